@@ -0,0 +1,178 @@
+/*
+ * Smart Car Dashboard - Alert Arbiter
+ * Author: Stromlabs - Pavan Kalsariya
+ * Date: July 2025
+ * Description: One place that decides what the buzzer, the ambient light and
+ * the indicator LEDs show. Alerts are raised with a value and an optional
+ * deadline, after which they lapse unless raised again. Once per loop pass
+ * resolve() picks the highest-priority live alert for each output channel
+ * and reports which channels changed, so outputs are only touched on a
+ * change. The time from an alert being raised to its output being set is
+ * kept per alert type.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include "jsonwriter.h"
+#include "profiler.h"
+
+// --- ALERTS AND CHANNELS ---
+enum AlertType : uint8_t {
+    ALERT_INDICATOR,        // value: BlinkMode
+    ALERT_PEER_LOST,
+    ALERT_PROXIMITY,        // value: nearest obstacle in mm
+    ALERT_COLLISION,        // value: CollisionLevel
+    ALERT_OBSTACLE,         // value: nearest obstacle in mm
+    ALERT_TYPES,
+    ALERT_NONE = ALERT_TYPES
+};
+
+static const char *const ALERT_NAMES[ALERT_TYPES + 1] = {
+    "indicator", "peerLost", "proximity", "collision", "obstacle", "none"
+};
+
+// Which indicators blink; shared with blinker.h
+enum BlinkMode : uint8_t {
+    BLINK_OFF = 0,
+    BLINK_LEFT = 1,
+    BLINK_RIGHT = 2,
+    BLINK_BOTH = BLINK_LEFT | BLINK_RIGHT
+};
+
+static const char *const BLINK_MODE_NAMES[] = {"off", "left", "right", "both"};
+
+enum AlertChannel : uint8_t {
+    CHANNEL_BUZZER,
+    CHANNEL_AMBIENT,
+    CHANNEL_INDICATORS,
+    ALERT_CHANNELS
+};
+
+#define CHANNEL_BIT(c) (1 << (c))
+
+// Higher priority wins a channel; each alert drives only its channels
+struct AlertRule {
+    uint8_t priority;
+    uint8_t channels;
+};
+
+static const AlertRule ALERT_RULES[ALERT_TYPES] = {
+    {1, CHANNEL_BIT(CHANNEL_BUZZER) | CHANNEL_BIT(CHANNEL_INDICATORS)},     // indicator
+    {2, CHANNEL_BIT(CHANNEL_AMBIENT)},                                      // peerLost
+    {3, CHANNEL_BIT(CHANNEL_BUZZER)},                                       // proximity
+    {4, CHANNEL_BIT(CHANNEL_BUZZER) | CHANNEL_BIT(CHANNEL_AMBIENT)},        // collision
+    {5, CHANNEL_BIT(CHANNEL_BUZZER) | CHANNEL_BIT(CHANNEL_AMBIENT)},        // obstacle
+};
+
+#define ALERT_NO_DEADLINE 0
+
+// What a channel should show
+struct AlertOutput {
+    AlertType type;
+    uint16_t value;
+};
+
+// --- ARBITER ---
+// Used from the loop task only.
+class AlertArbiter {
+public:
+    // holdMs: the alert lapses this long after the last raise, so one fed
+    // by a sensor goes away if the sensor stops reporting
+    void raise(AlertType type, uint16_t value, uint32_t nowMs, uint32_t holdMs = ALERT_NO_DEADLINE) {
+        Alert &a = alerts_[type];
+        if (!a.active) {
+            a.active = true;
+            a.raisedUs = micros();
+            a.pending = ALERT_RULES[type].channels;
+        }
+        a.value = value;
+        a.deadlineMs = holdMs ? nowMs + holdMs : 0;
+    }
+
+    void clear(AlertType type) { alerts_[type].active = false; }
+
+    void set(AlertType type, bool active, uint16_t value, uint32_t nowMs, uint32_t holdMs = ALERT_NO_DEADLINE) {
+        if (active) raise(type, value, nowMs, holdMs);
+        else clear(type);
+    }
+
+    // Drop lapsed alerts and pick a winner per channel. Returns a
+    // CHANNEL_BIT mask of channels whose output changed.
+    uint8_t resolve(uint32_t nowMs) {
+        for (uint8_t t = 0; t < ALERT_TYPES; t++) {
+            Alert &a = alerts_[t];
+            if (a.active && a.deadlineMs && (int32_t)(nowMs - a.deadlineMs) >= 0) {
+                a.active = false;
+                lapsed_[t]++;
+            }
+        }
+
+        uint8_t changed = 0;
+        for (uint8_t c = 0; c < ALERT_CHANNELS; c++) {
+            AlertOutput best = {ALERT_NONE, 0};
+            uint8_t bestPriority = 0;
+            for (uint8_t t = 0; t < ALERT_TYPES; t++) {
+                const Alert &a = alerts_[t];
+                if (!a.active || !(ALERT_RULES[t].channels & CHANNEL_BIT(c))) continue;
+                if (ALERT_RULES[t].priority > bestPriority) {
+                    bestPriority = ALERT_RULES[t].priority;
+                    best = {(AlertType)t, a.value};
+                }
+            }
+            if (best.type != outputs_[c].type || best.value != outputs_[c].value) {
+                outputs_[c] = best;
+                changed |= CHANNEL_BIT(c);
+            }
+        }
+        return changed;
+    }
+
+    const AlertOutput &output(AlertChannel channel) const { return outputs_[channel]; }
+
+    // Call once the channel's output has been set. The first time after a
+    // raise that an alert reaches each of its channels is one latency
+    // sample for that alert type.
+    void applied(AlertChannel channel) {
+        AlertType type = outputs_[channel].type;
+        if (type == ALERT_NONE) return;
+        Alert &a = alerts_[type];
+        if (!(a.pending & CHANNEL_BIT(channel))) return;
+        a.pending &= ~CHANNEL_BIT(channel);
+        latency_[type].record(micros() - a.raisedUs);
+    }
+
+    const LatencyHistogram &latency(AlertType type) const { return latency_[type]; }
+
+    // "alerts":{"unit":"us","types":[{"name":..,"active":..,"lapsed":..,"count":..,"p50":..,"p99":..,"max":..},...]}
+    void write(JsonWriter &json, const char *key = "alerts") const {
+        json.beginObject(key).add("unit", "us").beginArray("types");
+        for (uint8_t t = 0; t < ALERT_TYPES; t++) {
+            const LatencyHistogram &h = latency_[t];
+            json.beginObject()
+                .add("name", ALERT_NAMES[t])
+                .add("active", alerts_[t].active)
+                .add("lapsed", lapsed_[t])
+                .add("count", h.count())
+                .add("p50", h.percentileUs(50))
+                .add("p99", h.percentileUs(99))
+                .add("max", h.maxUs())
+                .endObject();
+        }
+        json.endArray().endObject();
+    }
+
+private:
+    struct Alert {
+        bool active = false;
+        uint16_t value = 0;
+        uint8_t pending = 0;        // Channels not yet set since the raise
+        uint32_t raisedUs = 0;
+        uint32_t deadlineMs = 0;    // 0: until cleared
+    };
+
+    Alert alerts_[ALERT_TYPES];
+    AlertOutput outputs_[ALERT_CHANNELS] = {{ALERT_NONE, 0}, {ALERT_NONE, 0}, {ALERT_NONE, 0}};
+    uint32_t lapsed_[ALERT_TYPES] = {};
+    LatencyHistogram latency_[ALERT_TYPES];
+};
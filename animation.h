@@ -0,0 +1,135 @@
+/*
+ * Smart Car Dashboard - Ambient Animation
+ * Author: Stromlabs - Pavan Kalsariya
+ * Date: July 2025
+ * Description: Renders the ambient strip at a fixed frame rate from three
+ * layers, bottom to top: a base colour (the temperature gradient), an alert
+ * overlay that flashes between its colour and off, and a status pulse that breathes along the strip.
+ * Layers are blended per pixel in 8.8 integer maths, then every channel goes
+ * through one 256-entry table that does gamma and brightness together. No
+ * floats per frame, so a frame costs a fixed few operations per LED
+ * (measured by tools/anim_bench).
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+#define ANIM_FRAME_MS 20            // 50 frames per second
+#define ANIM_GAMMA 2.2f
+#define ANIM_PULSE_MS 2560          // One breath, in and out
+#define ANIM_PULSE_SPREAD_MS 40     // Pulse phase lag from one pixel to the next
+
+// --- BLENDING ---
+// alpha 0..256: 0 keeps under, 256 is all over
+inline uint32_t blendColor(uint32_t under, uint32_t over, uint16_t alpha) {
+    uint32_t rb = ((under & 0xFF00FF) * (256 - alpha) + (over & 0xFF00FF) * alpha) >> 8;
+    uint32_t g = ((under & 0x00FF00) * (256 - alpha) + (over & 0x00FF00) * alpha) >> 8;
+    return (rb & 0xFF00FF) | (g & 0x00FF00);
+}
+
+// 0..256..0 over one period
+inline uint16_t triangleWave(uint32_t t, uint32_t periodMs) {
+    uint32_t half = periodMs / 2;
+    uint32_t p = t % periodMs;
+    return p < half ? p * 256 / half : (periodMs - p) * 256 / half;
+}
+
+// --- ANIMATOR ---
+template <uint16_t Count>
+class AmbientAnimator {
+public:
+    // alertHalfMs: alert overlay on for this long, then off as long
+    void begin(uint8_t brightness, uint16_t alertHalfMs) {
+        alertHalfMs_ = alertHalfMs ? alertHalfMs : 1;
+        setBrightness(brightness);
+    }
+
+    // Gamma and brightness in one table, rebuilt only when brightness changes
+    void setBrightness(uint8_t brightness) {
+        for (uint16_t v = 0; v < 256; v++) {
+            lut_[v] = (uint8_t)(powf(v / 255.0f, ANIM_GAMMA) * brightness + 0.5f);
+        }
+    }
+
+    void setEnabled(bool enabled) { enabled_ = enabled; }
+    void setBase(uint32_t color) { base_ = color; }
+
+    // Turning the alert on starts its flash lit; the dark half is off, not
+    // the base, so the flash reads as a warning
+    void setAlert(bool on, uint32_t nowMs, uint32_t color = 0xFF0000) {
+        if (on && !alertOn_) alertStartMs_ = nowMs;
+        alertOn_ = on;
+        alertColor_ = color;
+    }
+
+    // maxAlpha 0..256: how far the pulse covers the layers under it at its peak
+    void setPulse(bool on, uint32_t color = 0x0000FF, uint16_t maxAlpha = 128) {
+        pulseOn_ = on;
+        pulseColor_ = color;
+        pulseAlpha_ = maxAlpha > 256 ? 256 : maxAlpha;
+    }
+
+    // Renders a frame if one is due. Frames stay on a fixed grid; if the
+    // loop fell a whole frame behind, the missed frames are skipped (and
+    // counted) rather than rendered back to back.
+    bool render(uint32_t nowMs) {
+        if (frames_ == 0) nextFrameMs_ = nowMs;
+        if ((int32_t)(nowMs - nextFrameMs_) < 0) return false;
+        nextFrameMs_ += ANIM_FRAME_MS;
+        if ((int32_t)(nowMs - nextFrameMs_) >= 0) {
+            skipped_ += (nowMs - nextFrameMs_) / ANIM_FRAME_MS + 1;
+            nextFrameMs_ = nowMs + ANIM_FRAME_MS;
+        }
+        frames_++;
+
+        if (!enabled_) {
+            for (uint16_t i = 0; i < Count; i++) frame_[i] = 0;
+            return true;
+        }
+
+        // Layers that are the same for every pixel are worked out once
+        uint32_t under = base_;
+        if (alertOn_) under = ((nowMs - alertStartMs_) / alertHalfMs_ & 1) ? 0 : alertColor_;
+
+        for (uint16_t i = 0; i < Count; i++) {
+            uint32_t c = under;
+            if (pulseOn_) {
+                uint16_t alpha = triangleWave(nowMs + (uint32_t)(Count - i) * ANIM_PULSE_SPREAD_MS, ANIM_PULSE_MS);
+                c = blendColor(c, pulseColor_, alpha * pulseAlpha_ >> 8);
+            }
+            frame_[i] = (uint32_t)lut_[c >> 16 & 0xFF] << 16 | (uint32_t)lut_[c >> 8 & 0xFF] << 8 | lut_[c & 0xFF];
+        }
+        return true;
+    }
+
+    uint32_t pixel(uint16_t i) const { return i < Count ? frame_[i] : 0; }
+    uint8_t level(uint8_t v) const { return lut_[v]; }
+    uint32_t frames() const { return frames_; }
+    uint32_t skipped() const { return skipped_; }
+
+    // Hand the last frame to a strip; the strip decides whether it changed
+    template <class Strip>
+    void copyTo(Strip &strip) const {
+        for (uint16_t i = 0; i < Count; i++) strip.setPixelColor(i, frame_[i]);
+    }
+
+private:
+    uint8_t lut_[256] = {};
+    uint32_t frame_[Count] = {};
+    uint32_t nextFrameMs_ = 0;
+    uint32_t frames_ = 0;
+    uint32_t skipped_ = 0;
+
+    bool enabled_ = true;
+    uint32_t base_ = 0;
+
+    bool alertOn_ = false;
+    uint32_t alertColor_ = 0xFF0000;
+    uint32_t alertStartMs_ = 0;
+    uint16_t alertHalfMs_ = 500;
+
+    bool pulseOn_ = false;
+    uint32_t pulseColor_ = 0x0000FF;
+    uint16_t pulseAlpha_ = 128;
+};
@@ -0,0 +1,163 @@
+/*
+ * Smart Car Dashboard - Indicator Blinker
+ * Author: Stromlabs - Pavan Kalsariya
+ * Date: July 2025
+ * Description: Blinks the indicator LEDs from an esp_timer, so a blocking
+ * call in loop() (a 1 s HTTP timeout, say) no longer freezes them mid-blink.
+ * The loop only sets which sides blink. Edges are planned on a fixed grid
+ * from the last phase start, so the period doesn't drift; turning an
+ * indicator on from off restarts the phase with the LED lit, and the phase
+ * can be nudged to line up with another blinker. With both sides off the
+ * timer isn't armed, so a parked car isn't woken every half period. How
+ * late each edge ran behind its planned time is kept as a jitter histogram.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <esp_timer.h>
+#include "jsonwriter.h"
+#include "profiler.h"
+#include "alerts.h"     // BlinkMode, the indicator alert's value
+
+#define BLINK_MIN_DELAY_US 50       // Shortest wait handed to the timer
+
+static portMUX_TYPE blinkerMux = portMUX_INITIALIZER_UNLOCKED;
+
+// --- BLINKER ---
+class IndicatorBlinker {
+public:
+    // halfPeriodUs: time on, and time off. Both sides start off, with the
+    // timer idle until setMode() turns one on.
+    bool begin(uint8_t leftPin, uint8_t rightPin, uint32_t halfPeriodUs) {
+        leftPin_ = leftPin;
+        rightPin_ = rightPin;
+        halfPeriodUs_ = halfPeriodUs > BLINK_MIN_DELAY_US ? halfPeriodUs : BLINK_MIN_DELAY_US;
+        pinMode(leftPin_, OUTPUT);
+        pinMode(rightPin_, OUTPUT);
+        digitalWrite(leftPin_, LOW);
+        digitalWrite(rightPin_, LOW);
+
+        esp_timer_create_args_t args = {};
+        args.callback = &IndicatorBlinker::onTimer;
+        args.arg = this;
+        args.name = "blinker";
+        return esp_timer_create(&args, &timer_) == ESP_OK;
+    }
+
+    // Turning a side on while the other is already blinking joins its
+    // phase; turning on from off starts a fresh phase, lit, and arms the
+    // timer. Turning both off runs the callback once more to darken the
+    // LEDs, and it doesn't re-arm.
+    void setMode(uint8_t mode) {
+        mode &= BLINK_BOTH;
+        portENTER_CRITICAL(&blinkerMux);
+        uint8_t before = mode_;
+        mode_ = mode;
+        portEXIT_CRITICAL(&blinkerMux);
+        if (mode != before) kick(before == BLINK_OFF);
+    }
+
+    // Moves every later edge by shiftUs, e.g. to line up with the other car;
+    // only while blinking
+    void shiftPhase(int32_t shiftUs) {
+        if (mode_ == BLINK_OFF) return;
+        portENTER_CRITICAL(&blinkerMux);
+        shiftUs_ += shiftUs;
+        portEXIT_CRITICAL(&blinkerMux);
+        kick(false);
+    }
+
+    uint8_t mode() const { return mode_; }
+    bool lit() const { return lit_; }
+    const LatencyHistogram &jitter() const { return jitter_; }
+
+    // "blinker":{"mode":..,"edges":..,"jitterP50Us":..,"jitterP99Us":..,"jitterMaxUs":..}
+    void write(JsonWriter &json, const char *key = "blinker") const {
+        json.beginObject(key)
+            .add("mode", BLINK_MODE_NAMES[mode_ & BLINK_BOTH])
+            .add("edges", jitter_.count())
+            .add("jitterP50Us", jitter_.percentileUs(50))
+            .add("jitterP99Us", jitter_.percentileUs(99))
+            .add("jitterMaxUs", jitter_.maxUs())
+            .endObject();
+    }
+
+private:
+    // Run the callback now to apply a change. If the callback was running
+    // and re-armed itself in between, start fails; stop again.
+    void kick(bool restartPhase) {
+        portENTER_CRITICAL(&blinkerMux);
+        if (restartPhase) restart_ = true;
+        else refresh_ = true;
+        portEXIT_CRITICAL(&blinkerMux);
+        for (uint8_t attempt = 0; attempt < 3; attempt++) {
+            esp_timer_stop(timer_);
+            if (esp_timer_start_once(timer_, BLINK_MIN_DELAY_US) == ESP_OK) return;
+        }
+    }
+
+    static void onTimer(void *arg) { static_cast<IndicatorBlinker *>(arg)->step(); }
+
+    // Runs on the esp_timer task, one call at a time; lit_, nextEdge_ and
+    // the histogram are only written here
+    void step() {
+        int64_t now = esp_timer_get_time();
+        portENTER_CRITICAL(&blinkerMux);
+        uint8_t mode = mode_;
+        bool restart = restart_, refresh = refresh_;
+        int32_t shiftUs = shiftUs_;
+        restart_ = refresh_ = false;
+        shiftUs_ = 0;
+        portEXIT_CRITICAL(&blinkerMux);
+
+        if (restart) {
+            lit_ = true;
+            nextEdge_ = now + halfPeriodUs_;
+        } else if (refresh) {
+            // Mode or phase change only; the planned edge stands
+            nextEdge_ += shiftUs;
+        } else {
+            int64_t late = now - nextEdge_;
+            jitter_.record(late > 0 ? late : 0);
+            lit_ = !lit_;
+            nextEdge_ += halfPeriodUs_ + shiftUs;
+        }
+
+        if (mode == BLINK_OFF) {
+            // Off: nothing to time until setMode() starts a fresh phase
+            lit_ = false;
+            digitalWrite(leftPin_, LOW);
+            digitalWrite(rightPin_, LOW);
+            return;
+        }
+
+        digitalWrite(leftPin_, lit_ && (mode & BLINK_LEFT) ? HIGH : LOW);
+        digitalWrite(rightPin_, lit_ && (mode & BLINK_RIGHT) ? HIGH : LOW);
+
+        // If we're already past the next edge, slip the grid rather than
+        // flash through the missed edges
+        int64_t delayUs = nextEdge_ - esp_timer_get_time();
+        if (delayUs < BLINK_MIN_DELAY_US) {
+            nextEdge_ += BLINK_MIN_DELAY_US - delayUs;
+            delayUs = BLINK_MIN_DELAY_US;
+        }
+        esp_timer_start_once(timer_, delayUs);
+    }
+
+    esp_timer_handle_t timer_ = NULL;
+    uint8_t leftPin_ = 0;
+    uint8_t rightPin_ = 0;
+    uint32_t halfPeriodUs_ = 500000;
+
+    // Set by the loop, read by the callback (under blinkerMux)
+    volatile uint8_t mode_ = BLINK_OFF;
+    bool restart_ = false;
+    bool refresh_ = false;
+    int32_t shiftUs_ = 0;
+
+    // Callback only
+    volatile bool lit_ = false;
+    int64_t nextEdge_ = 0;
+    LatencyHistogram jitter_;
+};
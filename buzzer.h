@@ -0,0 +1,199 @@
+/*
+ * Smart Car Dashboard - Buzzer Patterns
+ * Author: Stromlabs - Pavan Kalsariya
+ * Date: July 2025
+ * Description: Plays the buzzer from an esp_timer instead of the loop, so
+ * beeps keep their length however long an HTTP call or pulseIn() holds the
+ * loop up. The loop only picks the pattern (alerts.h decides which): an
+ * indicator tick, a proximity beep that speeds up as an obstacle gets
+ * closer, or a steady alarm below the obstacle threshold. Each edge is
+ * scheduled from the previous planned edge, not from when the callback ran,
+ * so the rhythm doesn't drift.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <esp_timer.h>
+#include "jsonwriter.h"
+
+// --- PATTERNS ---
+enum BuzzPattern : uint8_t {
+    BUZZ_INDICATOR,
+    BUZZ_PROXIMITY,
+    BUZZ_ALARM,
+    BUZZ_PATTERNS,
+    BUZZ_NONE = BUZZ_PATTERNS
+};
+
+static const char *const BUZZ_PATTERN_NAMES[BUZZ_PATTERNS + 1] = {
+    "indicator", "proximity", "alarm", "none"
+};
+
+#define BUZZ_TICK_US 20000          // Indicator tick, once per blink period
+#define BUZZ_BEEP_US 40000          // Proximity beep
+#define BUZZ_GAP_NEAR_US 60000      // Gap between beeps just above the alarm distance...
+#define BUZZ_GAP_FAR_US 600000      // ...and at the edge of proximity range
+#define BUZZ_GAP_CAUTION_US 300000  // Collision caution...
+#define BUZZ_GAP_WARNING_US 100000  // ...and warning; critical is the alarm
+#define BUZZ_MIN_DELAY_US 50        // Shortest wait handed to the timer
+
+static portMUX_TYPE buzzerMux = portMUX_INITIALIZER_UNLOCKED;
+
+// --- ENGINE ---
+class BuzzerEngine {
+public:
+    // The proximity gap runs from BUZZ_GAP_NEAR_US at nearMm to
+    // BUZZ_GAP_FAR_US at farMm. tickPeriodUs: one indicator tick per period (the full blink cycle).
+    bool begin(uint8_t pin, uint16_t nearMm, uint16_t farMm, uint32_t tickPeriodUs) {
+        pin_ = pin;
+        nearMm_ = nearMm;
+        farMm_ = farMm > nearMm ? farMm : nearMm + 1;
+        tickPeriodUs_ = tickPeriodUs > BUZZ_TICK_US ? tickPeriodUs : 2 * BUZZ_TICK_US;
+        pinMode(pin_, OUTPUT);
+        digitalWrite(pin_, LOW);
+
+        esp_timer_create_args_t args = {};
+        args.callback = &BuzzerEngine::onTimer;
+        args.arg = this;
+        args.name = "buzzer";
+        return esp_timer_create(&args, &timer_) == ESP_OK;
+    }
+
+    // Switching pattern starts the new one on its rising edge
+    void play(BuzzPattern pattern) {
+        portENTER_CRITICAL(&buzzerMux);
+        BuzzPattern before = top();
+        pattern_ = pattern;
+        bool changed = top() != before;
+        portEXIT_CRITICAL(&buzzerMux);
+        if (changed) restart();
+    }
+
+    // Nearest obstacle; sets the proximity gap, which takes effect from the
+    // next gap without restarting the pattern
+    void setDistance(uint16_t mm) {
+        if (mm < nearMm_) mm = nearMm_;
+        if (mm > farMm_) mm = farMm_;
+        setGap(BUZZ_GAP_NEAR_US + (uint32_t)(mm - nearMm_) * (BUZZ_GAP_FAR_US - BUZZ_GAP_NEAR_US) / (farMm_ - nearMm_));
+    }
+
+    // The proximity gap directly, for warnings not graded by distance
+    void setGap(uint32_t gapUs) {
+        portENTER_CRITICAL(&buzzerMux);
+        gapUs_ = gapUs;
+        portEXIT_CRITICAL(&buzzerMux);
+    }
+
+    // The dashboard's buzzer switch; the pattern stays picked while muted
+    void setEnabled(bool enabled) {
+        portENTER_CRITICAL(&buzzerMux);
+        BuzzPattern before = top();
+        enabled_ = enabled;
+        bool changed = top() != before;
+        portEXIT_CRITICAL(&buzzerMux);
+        if (changed) restart();
+    }
+
+    BuzzPattern playing() const { return playing_; }
+
+    // "buzzer":{"pattern":..,"edges":..,"lateMaxUs":..}
+    // lateMaxUs: worst delay of an edge behind its planned time
+    void write(JsonWriter &json, const char *key = "buzzer") const {
+        json.beginObject(key)
+            .add("pattern", BUZZ_PATTERN_NAMES[playing_])
+            .add("edges", edges_)
+            .add("lateMaxUs", lateMaxUs_)
+            .endObject();
+    }
+
+private:
+    BuzzPattern top() const { return enabled_ ? pattern_ : BUZZ_NONE; }
+
+    // Fire the callback now so it starts the new pattern. If the callback
+    // was running and re-armed itself in between, start fails; stop again.
+    void restart() {
+        portENTER_CRITICAL(&buzzerMux);
+        restart_ = true;
+        portEXIT_CRITICAL(&buzzerMux);
+        for (uint8_t attempt = 0; attempt < 3; attempt++) {
+            esp_timer_stop(timer_);
+            if (esp_timer_start_once(timer_, BUZZ_MIN_DELAY_US) == ESP_OK) return;
+        }
+    }
+
+    static void onTimer(void *arg) { static_cast<BuzzerEngine *>(arg)->step(); }
+
+    // Runs on the esp_timer task, one call at a time; playing_, on_ and
+    // nextEdge_ are only touched here
+    void step() {
+        int64_t now = esp_timer_get_time();
+        portENTER_CRITICAL(&buzzerMux);
+        BuzzPattern want = top();
+        bool restart = restart_ || want != playing_;
+        restart_ = false;
+        uint32_t gapUs = gapUs_;
+        portEXIT_CRITICAL(&buzzerMux);
+
+        if (restart) {
+            // New pattern starts on its rising edge
+            playing_ = want;
+            on_ = false;
+            nextEdge_ = now;
+        } else {
+            // The timer can fire a little early; that isn't late
+            int64_t late = now - nextEdge_;
+            if (late > 0 && late > lateMaxUs_) lateMaxUs_ = late;
+        }
+        edges_++;
+
+        uint32_t durationUs = 0;
+        switch (playing_) {
+            case BUZZ_INDICATOR:
+                on_ = !on_;
+                durationUs = on_ ? BUZZ_TICK_US : tickPeriodUs_ - BUZZ_TICK_US;
+                break;
+            case BUZZ_PROXIMITY:
+                on_ = !on_;
+                durationUs = on_ ? BUZZ_BEEP_US : gapUs;
+                break;
+            case BUZZ_ALARM:
+                on_ = true;
+                break;
+            default:
+                on_ = false;
+                break;
+        }
+        digitalWrite(pin_, on_ ? HIGH : LOW);
+        if (!durationUs) return;
+
+        // Planned from the last edge; if we're already past it, slip the
+        // schedule rather than play a burst of short edges to catch up
+        nextEdge_ += durationUs;
+        int64_t delayUs = nextEdge_ - esp_timer_get_time();
+        if (delayUs < BUZZ_MIN_DELAY_US) {
+            nextEdge_ += BUZZ_MIN_DELAY_US - delayUs;
+            delayUs = BUZZ_MIN_DELAY_US;
+        }
+        esp_timer_start_once(timer_, delayUs);
+    }
+
+    esp_timer_handle_t timer_ = NULL;
+    uint8_t pin_ = 0;
+    uint16_t nearMm_ = 0;
+    uint16_t farMm_ = 1;
+    uint32_t tickPeriodUs_ = 2 * BUZZ_TICK_US;
+
+    // Set by the loop, read by the callback (under buzzerMux)
+    BuzzPattern pattern_ = BUZZ_NONE;
+    bool enabled_ = true;
+    bool restart_ = false;
+    uint32_t gapUs_ = BUZZ_GAP_FAR_US;
+
+    // Callback only
+    volatile BuzzPattern playing_ = BUZZ_NONE;
+    bool on_ = false;
+    int64_t nextEdge_ = 0;
+    volatile uint32_t edges_ = 0;
+    volatile uint32_t lateMaxUs_ = 0;
+};
@@ -0,0 +1,344 @@
+/*
+ * Smart Car Dashboard - Car Logic
+ * Author: Stromlabs - Pavan Kalsariya
+ * Date: July 2025
+ * Description: Everything between the car's inputs and its output decisions,
+ * with no hardware: the shared state, sensor conversions, button handling,
+ * messages from the other car, dashboard commands, and which alert each
+ * output shows. The firmware reads the hardware and calls in here; the replay
+ * tool calls the same functions from a recording, so both reach the same
+ * decisions. Each function records what it was given while a recording runs
+ * (record.h). Time comes in as an argument and nothing here reads a clock,
+ * other than for latency stats.
+ */
+
+#pragma once
+
+#include "config.h"
+#include "fixedmath.h"
+#include "alerts.h"
+#include "ttc.h"
+#include "events.h"
+#include "record.h"
+#if FEATURE_PEER
+#include "updatebody.h"
+#endif
+
+// Logging is the firmware's (logger.h); the host tools leave it out
+#ifdef ARDUINO
+#include "logger.h"
+#else
+#define LOG(...) ((void)0)
+#endif
+
+// Wakes the loop when another task publishes a change; defined by whoever
+// runs the loop (the firmware, or a tool)
+void wakeLoop();
+
+// --- STATE VARIABLES ---
+struct CarState {
+    float temp = 0.0;
+    float humidity = 0.0;
+    float frontDist = 999.0;
+    float backDist = 999.0;
+    int speed = 0;
+    float direction = 0;
+    bool leftIndicator = false;
+    bool rightIndicator = false;
+    bool buzzerOn = true;
+    bool ambientOn = true;
+    bool peerLeft = false;       // The other car's indicators
+    bool peerRight = false;
+    uint8_t collision = COLLISION_NONE;     // CollisionLevel
+    bool collisionBack = false;             // The warning is for the back sensor
+    uint16_t ttcMs = TTC_NONE;
+} carState;
+
+// Car 1: Car 2 answered the last search. Car 2: always false.
+bool peerConnected = false;
+bool peerLost = false;              // Car 2 answered once, then stopped
+unsigned long peerLostMs = 0;       // When it stopped
+
+AlertArbiter alerts;
+CollisionPredictor collision(CONFIG.ttcCautionMs, CONFIG.ttcWarningMs, CONFIG.ttcCriticalMs);
+YawIntegrator yaw;
+unsigned long lastMPUUpdate = 0;
+
+// --- STATE EVENTS ---
+// Fields consumers can subscribe to; up to 32
+enum StateField : uint8_t {
+    FIELD_TEMP,
+    FIELD_HUMIDITY,
+    FIELD_FRONT_DIST,
+    FIELD_BACK_DIST,
+    FIELD_SPEED,
+    FIELD_DIRECTION,
+    FIELD_LEFT,
+    FIELD_RIGHT,
+    FIELD_BUZZER,
+    FIELD_AMBIENT,
+    FIELD_PEER_LEFT,
+    FIELD_PEER_RIGHT,
+    FIELD_PEER_CONNECTED,
+    FIELD_COLLISION,            // Level, side or time to collision
+    STATE_FIELDS
+};
+
+#define ALL_FIELDS (EVENT_BIT(STATE_FIELDS) - 1)
+
+// Fields an output shows; a change to one raises or clears an alert
+#define OUTPUT_FIELDS (EVENT_BIT(FIELD_TEMP) | EVENT_BIT(FIELD_FRONT_DIST) | EVENT_BIT(FIELD_BACK_DIST) | \
+                       EVENT_BIT(FIELD_LEFT) | EVENT_BIT(FIELD_RIGHT) | EVENT_BIT(FIELD_BUZZER) | \
+                       EVENT_BIT(FIELD_AMBIENT) | EVENT_BIT(FIELD_PEER_LEFT) | EVENT_BIT(FIELD_PEER_RIGHT) | \
+                       EVENT_BIT(FIELD_PEER_CONNECTED) | EVENT_BIT(FIELD_COLLISION))
+
+// Outputs, dashboard push, sync with the other car. A sensor read publishes
+// up to seven events; 64 slots cover a 1 s HTTP stall with room to spare.
+EventBus<3, 64> stateEvents(wakeLoop);
+
+// Write a state field and publish the change; an unchanged value publishes
+// nothing, so consumers only run when something they show has changed
+template <typename T, typename V>
+void updateState(T &field, V value, StateField id) {
+    if (field == (T)value) return;
+    field = value;
+    stateEvents.publish(id);
+}
+
+// --- RECORDING ---
+// About 25 s of driving, in case flash writes fall behind
+InputRecorder<4096> recorder;
+
+// The settings a recording's outputs depend on. A replay built with other
+// settings can't be expected to reach the same outputs.
+inline uint32_t logicConfigHash() {
+    const uint32_t values[] = {
+        (uint32_t)CAR_ROLE, (uint32_t)(CONFIG.obstacleCm * 10), (uint32_t)(CONFIG.proximityCm * 10),
+        CONFIG.doublePressMs, CONFIG.sensorMs, CONFIG.ttcCautionMs, CONFIG.ttcWarningMs, CONFIG.ttcCriticalMs,
+        CONFIG.peerLostAlertMs,
+    };
+    uint32_t hash = 2166136261u;    // FNV-1a
+    const uint8_t *p = (const uint8_t *)values;
+    for (size_t i = 0; i < sizeof(values); i++) hash = (hash ^ p[i]) * 16777619u;
+    return hash;
+}
+
+// --- INDICATORS ---
+void setLeftIndicator(bool on) {
+    updateState(carState.leftIndicator, on, FIELD_LEFT);
+    if (on) updateState(carState.rightIndicator, false, FIELD_RIGHT);
+}
+
+void setRightIndicator(bool on) {
+    updateState(carState.rightIndicator, on, FIELD_RIGHT);
+    if (on) updateState(carState.leftIndicator, false, FIELD_LEFT);
+}
+
+// --- SENSORS ---
+// Echo times in us, 0 for no echo (999 cm)
+void applyEchoes(unsigned long currentTime, uint16_t frontUs, uint16_t backUs) {
+    recorder.echo(currentTime, frontUs, backUs);
+    uint16_t frontMm = echoToMm(frontUs), backMm = echoToMm(backUs);
+    updateState(carState.frontDist, frontMm * 0.1f, FIELD_FRONT_DIST);
+    updateState(carState.backDist, backMm * 0.1f, FIELD_BACK_DIST);
+
+    // Time to collision from the range history; the distance thresholds
+    // below stay as the floor
+    collision.update(currentTime, frontMm, backMm);
+    updateState(carState.collision, collision.level(), FIELD_COLLISION);
+    updateState(carState.collisionBack, collision.back(), FIELD_COLLISION);
+    updateState(carState.ttcMs, collision.ttcMs(), FIELD_COLLISION);
+
+    // Obstacle alerts lapse if the sensors stop being read
+    float nearestCm = carState.frontDist < carState.backDist ? carState.frontDist : carState.backDist;
+    uint16_t nearestMm = nearestCm * 10;
+    uint32_t holdMs = 4UL * CONFIG.sensorMs;
+    alerts.set(ALERT_OBSTACLE, nearestMm < CONFIG.obstacleCm * 10, 0, currentTime, holdMs);
+    alerts.set(ALERT_COLLISION, carState.collision != COLLISION_NONE, carState.collision, currentTime, holdMs);
+    alerts.set(ALERT_PROXIMITY, nearestMm < CONFIG.proximityCm * 10, nearestMm, currentTime, holdMs);
+}
+
+// As read from the DHT; NaN when the read failed
+void applyClimate(unsigned long currentTime, float temp, float humidity) {
+    recorder.climate(currentTime, temp, humidity);
+    if (!isnan(temp) && !isnan(humidity)) {
+        updateState(carState.temp, temp, FIELD_TEMP);
+        updateState(carState.humidity, humidity, FIELD_HUMIDITY);
+    }
+}
+
+#if FEATURE_MPU
+// Acceleration in m/s^2 and yaw rate in rad/s, as the MPU6050 library gives them
+void applyMotion(unsigned long currentTime, float ax, float ay, float az, float gz) {
+    recorder.motion(currentTime, ax, ay, az, gz);
+
+    // Speed level from the acceleration magnitude (no sqrt)
+    updateState(carState.speed, speedLevel(accelToFixed(ax), accelToFixed(ay), accelToFixed(az)), FIELD_SPEED);
+
+    // Forward acceleration feeds the collision prediction between echoes
+    collision.motion(lroundf(ax * 1000));
+
+    // Simplified yaw calculation
+    yaw.update(lroundf(gz * RAD_TO_MDEG), currentTime - lastMPUUpdate);
+    lastMPUUpdate = currentTime;
+    updateState(carState.direction, yaw.degrees(), FIELD_DIRECTION);
+}
+#endif
+
+// --- BUTTONS ---
+unsigned long lastButtonPressTime = 0;
+bool waitingForSecondPress = false;
+
+// Called every loop pass with the presses the ISRs saw since the last one.
+// Two buttons toggle left and right. With one button, a single press
+// toggles left and a double press toggles right.
+void handleButtons(unsigned long currentTime, bool leftPressed, bool rightPressed) {
+    bool windowOver = waitingForSecondPress && currentTime - lastButtonPressTime > CONFIG.doublePressMs;
+    if (!leftPressed && !rightPressed && !windowOver) return;
+    recorder.button(currentTime, leftPressed, rightPressed);
+
+    if (CONFIG.pins.rightButton != NO_PIN) {
+        if (leftPressed) {
+            setLeftIndicator(!carState.leftIndicator);
+            LOG(MSG_LEFT_INDICATOR, carState.leftIndicator);
+        }
+
+        if (rightPressed) {
+            setRightIndicator(!carState.rightIndicator);
+            LOG(MSG_RIGHT_INDICATOR, carState.rightIndicator);
+        }
+        return;
+    }
+
+    if (leftPressed) {
+        if (!waitingForSecondPress) {
+            lastButtonPressTime = currentTime;
+            waitingForSecondPress = true;
+        } else if (currentTime - lastButtonPressTime < CONFIG.doublePressMs) {
+            // Double press: toggle right indicator
+            setRightIndicator(!carState.rightIndicator);
+            waitingForSecondPress = false;
+            LOG(MSG_RIGHT_INDICATOR, carState.rightIndicator);
+        }
+    }
+
+    // Check if double press window has expired (single press)
+    if (waitingForSecondPress && (currentTime - lastButtonPressTime > CONFIG.doublePressMs)) {
+        // Single press: toggle left indicator
+        setLeftIndicator(!carState.leftIndicator);
+        waitingForSecondPress = false;
+        LOG(MSG_LEFT_INDICATOR, carState.leftIndicator);
+    }
+}
+
+#if FEATURE_PEER
+// --- THE OTHER CAR ---
+// A parsed /update body from the other car
+void applyPeerUpdate(unsigned long currentTime, const UpdateBody &body) {
+    recorder.peerUpdate(currentTime, body.present, body.values);
+    if (body.has(UPDATE_LEFT)) {
+        updateState(carState.peerLeft, body.get(UPDATE_LEFT), FIELD_PEER_LEFT);
+        if (carState.peerLeft) updateState(carState.peerRight, false, FIELD_PEER_RIGHT);
+    }
+    if (body.has(UPDATE_RIGHT)) {
+        updateState(carState.peerRight, body.get(UPDATE_RIGHT), FIELD_PEER_RIGHT);
+        if (carState.peerRight) updateState(carState.peerLeft, false, FIELD_PEER_LEFT);
+    }
+    if (body.has(UPDATE_BUZZER)) updateState(carState.buzzerOn, body.get(UPDATE_BUZZER), FIELD_BUZZER);
+    if (body.has(UPDATE_AMBIENT)) updateState(carState.ambientOn, body.get(UPDATE_AMBIENT), FIELD_AMBIENT);
+}
+
+// The other car's indicators, from its reply to our /update
+void applyPeerReply(unsigned long currentTime, bool left, bool right) {
+    recorder.peerReply(currentTime, left, right);
+    updateState(carState.peerLeft, left, FIELD_PEER_LEFT);
+    updateState(carState.peerRight, right, FIELD_PEER_RIGHT);
+}
+
+#if CAR_ROLE == ROLE_MAIN
+// Result of looking for Car 2 among our stations
+void applyPeerStatus(unsigned long currentTime, bool found, bool left, bool right) {
+    recorder.peerStatus(currentTime, found, left, right);
+    if (found) {
+        updateState(carState.peerLeft, left, FIELD_PEER_LEFT);
+        updateState(carState.peerRight, right, FIELD_PEER_RIGHT);
+    } else if (peerConnected) {
+        peerLost = true;
+        peerLostMs = currentTime;
+    }
+    updateState(peerConnected, found, FIELD_PEER_CONNECTED);
+}
+#endif
+#endif
+
+#if FEATURE_DASHBOARD
+// --- COMMANDS ---
+enum CommandTarget : uint8_t {
+    TARGET_LEFT,
+    TARGET_RIGHT,
+    TARGET_BUZZER,
+    TARGET_AMBIENT,
+    COMMAND_TARGETS
+};
+
+static const char *const COMMAND_TARGET_NAMES[COMMAND_TARGETS] = {
+    "left_indicator", "right_indicator", "buzzer", "ambient"
+};
+
+// Set one output to an explicit state
+void applyCommand(unsigned long currentTime, CommandTarget target, bool value) {
+    recorder.command(currentTime, target, value);
+    switch (target) {
+        case TARGET_LEFT:    setLeftIndicator(value); break;
+        case TARGET_RIGHT:   setRightIndicator(value); break;
+        case TARGET_BUZZER:  updateState(carState.buzzerOn, value, FIELD_BUZZER); break;
+        case TARGET_AMBIENT: updateState(carState.ambientOn, value, FIELD_AMBIENT); break;
+        default: break;
+    }
+}
+
+// COMMAND_TARGETS if there is no such target
+CommandTarget findCommandTarget(const char *name) {
+    uint8_t t = 0;
+    while (t < COMMAND_TARGETS && strcmp(name, COMMAND_TARGET_NAMES[t]) != 0) t++;
+    return (CommandTarget)t;
+}
+
+// Returns false for an unknown target
+bool applySetCommand(unsigned long currentTime, const char *target, bool value) {
+    CommandTarget t = findCommandTarget(target);
+    if (t == COMMAND_TARGETS) return false;
+    applyCommand(currentTime, t, value);
+    return true;
+}
+#endif
+
+// --- OUTPUT DECISIONS ---
+// Raise the alerts that follow from the state: the indicators, and the
+// other car being out of reach. Called when state changes reach the outputs.
+void raiseStateAlerts(unsigned long currentTime) {
+    recorder.state(currentTime);
+    bool leftOn = carState.leftIndicator || carState.peerLeft;
+    bool rightOn = carState.rightIndicator || carState.peerRight;
+    uint8_t blinkMode = (leftOn ? BLINK_LEFT : BLINK_OFF) | (rightOn ? BLINK_RIGHT : BLINK_OFF);
+    alerts.set(ALERT_INDICATOR, blinkMode != BLINK_OFF, blinkMode, currentTime);
+#if FEATURE_PEER && FEATURE_AMBIENT
+    // Only a link that was up and dropped, and only for peerLostAlertMs: a
+    // Car 2 that was never on, or has been off a while, isn't an alert
+    uint32_t lostForMs = currentTime - peerLostMs;
+    bool lost = peerLost && !peerConnected && lostForMs < CONFIG.peerLostAlertMs;
+    alerts.set(ALERT_PEER_LOST, lost, 0, currentTime, lost ? CONFIG.peerLostAlertMs - lostForMs : ALERT_NO_DEADLINE);
+#endif
+}
+
+// Pick each output's alert; returns a CHANNEL_BIT mask of outputs that
+// changed, which are recorded
+uint8_t resolveOutputs(unsigned long currentTime) {
+    uint8_t changed = alerts.resolve(currentTime);
+    for (uint8_t c = 0; c < ALERT_CHANNELS; c++) {
+        if (!(changed & CHANNEL_BIT(c))) continue;
+        const AlertOutput &out = alerts.output((AlertChannel)c);
+        recorder.output(currentTime, c, out.type, out.value);
+    }
+    return changed;
+}
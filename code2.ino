@@ -2,13 +2,15 @@
 #include <WiFiManager.h>
 #include <AsyncTCP.h>
 #include <ESPAsyncWebServer.h>
-#include <ArduinoJson.h>
 #include <DHT.h>
 #include <Adafruit_NeoPixel.h>
 #include <Wire.h>
 #include <MPU6050.h>
 #include <esp_now.h>
 #include <esp_wifi.h>
+#include "jsonwriter.h"
+#include "runtime.h"
+#include "logger.h"
 
 // Pin definitions
 #define DHT_PIN 4
@@ -30,8 +32,10 @@
 DHT dht(DHT_PIN, DHT_TYPE);
 Adafruit_NeoPixel strip(NEOPIXEL_COUNT, NEOPIXEL_PIN, NEO_GRB + NEO_KHZ800);
 AsyncWebServer server(80);
+AsyncEventSource events("/api/events");
 MPU6050 mpu;
 WiFiManager wifiManager;
+HeapMonitor heapMonitor;
 
 // Global variables
 bool leftIndicator1 = false;
@@ -39,7 +43,7 @@ bool rightIndicator1 = false;
 bool leftIndicator2 = false;
 bool rightIndicator2 = false;
 bool obstacleAlert = false;
-String obstacleLocation = "Clear";
+const char *obstacleLocation = "Clear";
 float temperature = 0;
 float humidity = 0;
 int frontDistance = 0;
@@ -51,6 +55,9 @@ unsigned long lastSensorRead = 0;
 unsigned long lastDHTRead = 0;
 unsigned long lastMPURead = 0;
 unsigned long lastBuzzTime = 0;
+unsigned long lastEventPush = 0;
+unsigned long lastHeapReport = 0;
+char lastEventJson[384] = ""; // Last state pushed over /api/events
 int buzzInterval = 500;
 float accelThreshold = 0.15; // Acceleration threshold for movement detection
 
@@ -421,6 +428,14 @@ const char index_html[] PROGMEM = R"rawliteral(
             margin-top: 10px;
         }
         
+        .latency {
+            margin-top: 10px;
+            min-height: 16px;
+            font-size: 0.75rem;
+            text-align: center;
+            opacity: 0.6;
+        }
+        
         .control-btn {
             flex: 1;
             max-width: 200px;
@@ -601,6 +616,7 @@ const char index_html[] PROGMEM = R"rawliteral(
                 RIGHT <span>→</span>
             </button>
         </div>
+        <div class="latency" id="latency"></div>
     </div>
     
     <script>
@@ -614,83 +630,103 @@ const char index_html[] PROGMEM = R"rawliteral(
             selectedCar = carNum;
             document.getElementById('car1Btn').classList.toggle('active', carNum === 1);
             document.getElementById('car2Btn').classList.toggle('active', carNum === 2);
+            if (lastStatus) updateStatus(lastStatus);
         }
         
-        // Toggle indicators
-        function toggleIndicator(side) {
-            fetch(`/api/indicator/${selectedCar}/${side}`, { method: 'POST' });
-        }
+        // Indicator commands send the wanted state plus a sequence number;
+        // the response echoes both, which gives click-to-confirmed latency
+        let commandSeq = 0;
         
-        // Update dashboard status
-        function updateStatus() {
-            fetch('/api/status')
+        function toggleIndicator(side) {
+            const field = `${side}Indicator${selectedCar}`;
+            const on = !(lastStatus && lastStatus[field]);
+            const seq = ++commandSeq;
+            const sentAt = performance.now();
+            
+            fetch(`/api/indicator/${selectedCar}/${side}?state=${on ? 'on' : 'off'}&seq=${seq}`, { method: 'POST' })
                 .then(response => response.json())
-                .then(data => {
-                    // Update temperature and humidity
-                    document.getElementById('temperature').textContent = 
-                        data.temperature === -999 ? '--' : data.temperature.toFixed(1);
-                    document.getElementById('humidity').textContent = 
-                        data.humidity === -999 ? '--' : data.humidity.toFixed(0);
-                    
-                    // Update proximity status
-                    const proximityCard = document.getElementById('proximityCard');
-                    const proximityStatus = document.getElementById('proximityStatus');
-                    const proximityDistance = document.getElementById('proximityDistance');
-                    
-                    proximityStatus.textContent = data.obstacleLocation;
-                    proximityDistance.textContent = '';
-                    
-                    if (data.obstacleAlert) {
-                        proximityCard.classList.add('alert');
-                        if (data.frontDistance < 10) {
-                            proximityDistance.textContent += `Front: ${data.frontDistance}cm `;
-                        }
-                        if (data.backDistance < 10) {
-                            proximityDistance.textContent += `Back: ${data.backDistance}cm`;
-                        }
-                    } else {
-                        proximityCard.classList.remove('alert');
-                    }
-                    
-                    // Update speed
-                    document.getElementById('speedDisplay').textContent = data.speed.toFixed(0);
-                    
-                    // Update compass and heading
-                    document.getElementById('compassNeedle').style.transform = 
-                        `rotate(${data.direction}deg)`;
-                    document.getElementById('headingText').textContent = 
-                        `${Math.round(data.direction)}°`;
-                    
-                    // Update indicators for both cars
-                    document.getElementById('leftIndicator1').classList.toggle('active', data.leftIndicator1);
-                    document.getElementById('rightIndicator1').classList.toggle('active', data.rightIndicator1);
-                    document.getElementById('leftIndicator2').classList.toggle('active', data.leftIndicator2);
-                    document.getElementById('rightIndicator2').classList.toggle('active', data.rightIndicator2);
-                    
-                    // Update button states
-                    document.getElementById('leftBtn').classList.toggle('active', 
-                        (selectedCar === 1 && data.leftIndicator1) || (selectedCar === 2 && data.leftIndicator2));
-                    document.getElementById('rightBtn').classList.toggle('active', 
-                        (selectedCar === 1 && data.rightIndicator1) || (selectedCar === 2 && data.rightIndicator2));
-                    
-                    // Update obstacle alert
-                    const alertBox = document.getElementById('alertBox');
-                    const alertText = document.getElementById('alertText');
-                    if (data.obstacleAlert) {
-                        alertText.textContent = `OBSTACLE DETECTED: ${data.obstacleLocation}`;
-                        alertBox.classList.add('show');
-                    } else {
-                        alertBox.classList.remove('show');
+                .then(ack => {
+                    if (ack.seq !== seq) return;
+                    document.getElementById('latency').textContent =
+                        `Confirmed in ${Math.round(performance.now() - sentAt)} ms`;
+                    if (lastStatus) {
+                        lastStatus[`leftIndicator${ack.car}`] = ack.leftIndicator;
+                        lastStatus[`rightIndicator${ack.car}`] = ack.rightIndicator;
+                        updateStatus(lastStatus);
                     }
                 })
-                .catch(error => console.error('Error:', error));
+                .catch(error => console.error('Indicator error:', error));
         }
         
-        // Update status every 100ms for real-time feel
-        setInterval(updateStatus, 100);
+        // Update dashboard status
+        function updateStatus(data) {
+            // Update temperature and humidity
+            document.getElementById('temperature').textContent = 
+                data.temperature === -999 ? '--' : data.temperature.toFixed(1);
+            document.getElementById('humidity').textContent = 
+                data.humidity === -999 ? '--' : data.humidity.toFixed(0);
+            
+            // Update proximity status
+            const proximityCard = document.getElementById('proximityCard');
+            const proximityStatus = document.getElementById('proximityStatus');
+            const proximityDistance = document.getElementById('proximityDistance');
+            
+            proximityStatus.textContent = data.obstacleLocation;
+            proximityDistance.textContent = '';
+            
+            if (data.obstacleAlert) {
+                proximityCard.classList.add('alert');
+                if (data.frontDistance < 10) {
+                    proximityDistance.textContent += `Front: ${data.frontDistance}cm `;
+                }
+                if (data.backDistance < 10) {
+                    proximityDistance.textContent += `Back: ${data.backDistance}cm`;
+                }
+            } else {
+                proximityCard.classList.remove('alert');
+            }
+            
+            // Update speed
+            document.getElementById('speedDisplay').textContent = data.speed.toFixed(0);
+            
+            // Update compass and heading
+            document.getElementById('compassNeedle').style.transform = 
+                `rotate(${data.direction}deg)`;
+            document.getElementById('headingText').textContent = 
+                `${Math.round(data.direction)}°`;
+            
+            // Update indicators for both cars
+            document.getElementById('leftIndicator1').classList.toggle('active', data.leftIndicator1);
+            document.getElementById('rightIndicator1').classList.toggle('active', data.rightIndicator1);
+            document.getElementById('leftIndicator2').classList.toggle('active', data.leftIndicator2);
+            document.getElementById('rightIndicator2').classList.toggle('active', data.rightIndicator2);
+            
+            // Update button states
+            document.getElementById('leftBtn').classList.toggle('active', 
+                (selectedCar === 1 && data.leftIndicator1) || (selectedCar === 2 && data.leftIndicator2));
+            document.getElementById('rightBtn').classList.toggle('active', 
+                (selectedCar === 1 && data.rightIndicator1) || (selectedCar === 2 && data.rightIndicator2));
+            
+            // Update obstacle alert
+            const alertBox = document.getElementById('alertBox');
+            const alertText = document.getElementById('alertText');
+            if (data.obstacleAlert) {
+                alertText.textContent = `OBSTACLE DETECTED: ${data.obstacleLocation}`;
+                alertBox.classList.add('show');
+            } else {
+                alertBox.classList.remove('show');
+            }
+        }
         
-        // Initial status update
-        updateStatus();
+        // State is pushed over one Server-Sent Events connection: the full
+        // state on connect, then only when something changes
+        let lastStatus = null;
+        const events = new EventSource('/api/events');
+        events.addEventListener('state', e => {
+            lastStatus = JSON.parse(e.data);
+            updateStatus(lastStatus);
+        });
+        events.onerror = () => console.error('Event stream interrupted, reconnecting');
     </script>
 </body>
 </html>
@@ -703,16 +739,12 @@ void onDataReceived(const uint8_t * mac, const uint8_t *incomingData, int len) {
   if (msg->carId == 1) {
     leftIndicator1 = msg->leftIndicator;
     rightIndicator1 = msg->rightIndicator;
-    Serial.println("Received Car1 indicators: " + 
-                  String(leftIndicator1 ? "LEFT" : "") + 
-                  String(rightIndicator1 ? "RIGHT" : ""));
+    LOG(MSG_ESPNOW_INDICATORS, 1, leftIndicator1, rightIndicator1);
   } 
   else if (msg->carId == 2) {
     leftIndicator2 = msg->leftIndicator;
     rightIndicator2 = msg->rightIndicator;
-    Serial.println("Received Car2 indicators: " + 
-                  String(leftIndicator2 ? "LEFT" : "") + 
-                  String(rightIndicator2 ? "RIGHT" : ""));
+    LOG(MSG_ESPNOW_INDICATORS, 2, leftIndicator2, rightIndicator2);
   }
 }
 
@@ -725,33 +757,104 @@ void sendIndicatorSync(uint8_t carId, bool left, bool right) {
   esp_now_send(broadcastAddress, (uint8_t *) &msg, sizeof(msg));
 }
 
-void toggleIndicator(uint8_t carId, char side) {
-  if (carId == 1) {
-    if (side == 'left') {
-      leftIndicator1 = !leftIndicator1;
-      if (leftIndicator1) rightIndicator1 = false;
-    } 
-    else if (side == 'right') {
-      rightIndicator1 = !rightIndicator1;
-      if (rightIndicator1) leftIndicator1 = false;
-    }
-    sendIndicatorSync(1, leftIndicator1, rightIndicator1);
+// Set one side of a car's indicators to an explicit state; side is 'L' or 'R'
+void setIndicator(uint8_t carId, char side, bool on) {
+  bool &left = (carId == 1) ? leftIndicator1 : leftIndicator2;
+  bool &right = (carId == 1) ? rightIndicator1 : rightIndicator2;
+  
+  if (side == 'L') {
+    left = on;
+    if (on) right = false;
   } 
-  else if (carId == 2) {
-    if (side == 'left') {
-      leftIndicator2 = !leftIndicator2;
-      if (leftIndicator2) rightIndicator2 = false;
-    } 
-    else if (side == 'right') {
-      rightIndicator2 = !rightIndicator2;
-      if (rightIndicator2) leftIndicator2 = false;
-    }
-    sendIndicatorSync(2, leftIndicator2, rightIndicator2);
+  else if (side == 'R') {
+    right = on;
+    if (on) left = false;
   }
+  sendIndicatorSync(carId, left, right);
+}
+
+// Local button presses still toggle
+void toggleIndicator(uint8_t carId, char side) {
+  bool current;
+  if (carId == 1) current = (side == 'L') ? leftIndicator1 : rightIndicator1;
+  else current = (side == 'L') ? leftIndicator2 : rightIndicator2;
+  setIndicator(carId, side, !current);
+}
+
+// POST /api/indicator/<car>/<side>?state=on|off&seq=N
+// Sets an explicit state, so a retried or concurrent request can't flip the
+// indicator twice, and echoes the client's sequence number with the result.
+void handleIndicatorCommand(AsyncWebServerRequest *request, uint8_t carId, char side) {
+  // Anything but on or off is rejected, not taken as off
+  const char *state = request->hasParam("state") ? request->getParam("state")->value().c_str() : "";
+  bool on = strcmp(state, "on") == 0;
+  if (!on && strcmp(state, "off") != 0) {
+    request->send(400, "application/json", "{\"status\":\"error\",\"error\":\"state=on|off required\"}");
+    return;
+  }
+  
+  setIndicator(carId, side, on);
+  
+  bool left = (carId == 1) ? leftIndicator1 : leftIndicator2;
+  bool right = (carId == 1) ? rightIndicator1 : rightIndicator2;
+  unsigned long seq = request->hasParam("seq") ? request->getParam("seq")->value().toInt() : 0;
+  JsonBuffer<128> json;
+  json.beginObject()
+    .add("status", "ok")
+    .add("seq", seq)
+    .add("car", carId)
+    .add("leftIndicator", left)
+    .add("rightIndicator", right)
+    .endObject();
+  sendJson(request, json);
+}
+
+void writeStatus(JsonWriter &json) {
+  json.beginObject()
+    .add("temperature", isnan(temperature) ? -999 : temperature, 1)
+    .add("humidity", isnan(humidity) ? -999 : humidity, 1)
+    .add("leftIndicator1", leftIndicator1)
+    .add("rightIndicator1", rightIndicator1)
+    .add("leftIndicator2", leftIndicator2)
+    .add("rightIndicator2", rightIndicator2)
+    .add("obstacleAlert", obstacleAlert)
+    .add("obstacleLocation", obstacleLocation)
+    .add("frontDistance", frontDistance)
+    .add("backDistance", backDistance)
+    .add("speed", speed)
+    .add("direction", direction)
+    .endObject();
+}
+
+// Cut-off JSON isn't sent; the first time is logged
+bool jsonFits(const JsonWriter &json) {
+  static bool logged = false;
+  if (!json.overflowed()) return true;
+  if (!logged) LOG(MSG_JSON_OVERFLOW, (uint32_t)json.capacity());
+  logged = true;
+  return false;
+}
+
+void sendJson(AsyncWebServerRequest *request, const JsonWriter &json) {
+  if (jsonFits(json)) request->send(200, "application/json", json.c_str());
+  else request->send(500, "application/json", "{\"error\":\"response too large\"}");
+}
+
+void pushStatusEvent() {
+  if (events.count() == 0) return;
+  
+  char buffer[sizeof(lastEventJson)];
+  JsonWriter json(buffer, sizeof(buffer));
+  writeStatus(json);
+  
+  if (!jsonFits(json) || strcmp(buffer, lastEventJson) == 0) return;
+  strcpy(lastEventJson, buffer);
+  events.send(buffer, "state", millis());
 }
 
 void setup() {
   Serial.begin(115200);
+  logger.begin(Serial);
   
   // Initialize I2C
   Wire.begin(SDA_PIN, SCL_PIN);
@@ -783,7 +886,8 @@ void setup() {
   WiFi.mode(WIFI_STA);
   wifiManager.autoConnect("SmartCarAP");
   Serial.println("WiFi connected!");
-  Serial.println("IP address: " + WiFi.localIP().toString());
+  Serial.print("IP address: ");
+  Serial.println(WiFi.localIP());
   
   // Initialize ESP-NOW
   if (esp_now_init() != ESP_OK) {
@@ -808,52 +912,44 @@ void setup() {
   
   // Setup web server routes
   server.on("/", HTTP_GET, [](AsyncWebServerRequest *request){
-    request->send(200, "text/html", index_html);
+    request->send_P(200, "text/html", index_html);
   });
   
   server.on("/api/status", HTTP_GET, [](AsyncWebServerRequest *request){
-    StaticJsonDocument<500> doc;
-    doc["temperature"] = isnan(temperature) ? -999 : temperature;
-    doc["humidity"] = isnan(humidity) ? -999 : humidity;
-    doc["leftIndicator1"] = leftIndicator1;
-    doc["rightIndicator1"] = rightIndicator1;
-    doc["leftIndicator2"] = leftIndicator2;
-    doc["rightIndicator2"] = rightIndicator2;
-    doc["obstacleAlert"] = obstacleAlert;
-    doc["obstacleLocation"] = obstacleLocation;
-    doc["frontDistance"] = frontDistance;
-    doc["backDistance"] = backDistance;
-    doc["speed"] = speed;
-    doc["direction"] = direction;
-    
-    String response;
-    serializeJson(doc, response);
-    request->send(200, "application/json", response);
+    JsonBuffer<384> json;
+    writeStatus(json);
+    sendJson(request, json);
   });
   
   server.on("/api/indicator/1/left", HTTP_POST, [](AsyncWebServerRequest *request){
-    toggleIndicator(1, 'left');
-    request->send(200, "application/json", "{\"status\":\"ok\"}");
+    handleIndicatorCommand(request, 1, 'L');
   });
   
   server.on("/api/indicator/1/right", HTTP_POST, [](AsyncWebServerRequest *request){
-    toggleIndicator(1, 'right');
-    request->send(200, "application/json", "{\"status\":\"ok\"}");
+    handleIndicatorCommand(request, 1, 'R');
   });
   
   server.on("/api/indicator/2/left", HTTP_POST, [](AsyncWebServerRequest *request){
-    toggleIndicator(2, 'left');
-    request->send(200, "application/json", "{\"status\":\"ok\"}");
+    handleIndicatorCommand(request, 2, 'L');
   });
   
   server.on("/api/indicator/2/right", HTTP_POST, [](AsyncWebServerRequest *request){
-    toggleIndicator(2, 'right');
-    request->send(200, "application/json", "{\"status\":\"ok\"}");
+    handleIndicatorCommand(request, 2, 'R');
   });
   
+  // Server-Sent Events: full state on connect, then only changes
+  events.onConnect([](AsyncEventSourceClient *client){
+    JsonBuffer<sizeof(lastEventJson)> json;
+    writeStatus(json);
+    if (jsonFits(json)) client->send(json.c_str(), "state", millis(), 1000);
+  });
+  server.addHandler(&events);
+  
   // Start server
   server.begin();
   Serial.println("Web server started");
+  heapMonitor.sample();
+  heapMonitor.print(Serial);
 }
 
 void loop() {
@@ -892,6 +988,19 @@ void loop() {
   // Handle ambient lighting
   handleAmbientLighting();
   
+  // Push state changes to the dashboard every 100ms
+  if (currentTime - lastEventPush > 100) {
+    pushStatusEvent();
+    lastEventPush = currentTime;
+  }
+  
+  // Heap report every 30 seconds; a falling "lowest" block means fragmentation
+  if (currentTime - lastHeapReport > 30000) {
+    heapMonitor.sample();
+    heapMonitor.log();
+    lastHeapReport = currentTime;
+  }
+  
   delay(10);
 }
 
@@ -912,7 +1021,7 @@ void handleButton() {
     if (duration < 500) { // Short press
       if (millis() - lastButtonPress < 300) {
         // Double press detected
-        toggleIndicator(1, 'right');
+        toggleIndicator(1, 'R');
         pressCount = 0;
       } else {
         // Start single press timeout
@@ -927,7 +1036,7 @@ void handleButton() {
   
   // Handle single press after timeout
   if (pressCount == 1 && millis() - lastButtonPress > 300) {
-    toggleIndicator(1, 'left');
+    toggleIndicator(1, 'L');
     pressCount = 0;
   }
 }
@@ -0,0 +1,175 @@
+/*
+ * Smart Car Dashboard - Configuration
+ * Author: Stromlabs - Pavan Kalsariya
+ * Date: July 2025
+ * Description: Pins, thresholds and timings for every car, as one constexpr
+ * struct per role. The sketch picks a role with CAR_ROLE before including
+ * smartcar.h; the role decides which features are built at all, so a
+ * follower carries no MPU, NeoPixel or dashboard code.
+ *
+ *   ROLE_MAIN        Car 1: access point, dashboard, MPU, NeoPixel, finds Car 2
+ *   ROLE_FOLLOWER    Car 2: joins Car 1's network, one button, syncs with Car 1
+ *   ROLE_STANDALONE  A single car: Car 1 without the Car 2 link
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+// --- ROLES ---
+// Plain numbers so they can be compared in #if
+#define ROLE_MAIN 1
+#define ROLE_FOLLOWER 2
+#define ROLE_STANDALONE 3
+
+#ifndef CAR_ROLE
+#define CAR_ROLE ROLE_MAIN
+#endif
+
+// --- FEATURES ---
+// Code and libraries behind a feature that is 0 are not compiled
+#if CAR_ROLE == ROLE_MAIN
+#define FEATURE_DASHBOARD 1    // Access point, web page, WebSocket, history
+#define FEATURE_MPU 1
+#define FEATURE_AMBIENT 1      // NeoPixel
+#define FEATURE_PEER 1         // Indicator sync with the other car
+#elif CAR_ROLE == ROLE_FOLLOWER
+#define FEATURE_DASHBOARD 0
+#define FEATURE_MPU 0
+#define FEATURE_AMBIENT 0
+#define FEATURE_PEER 1
+#elif CAR_ROLE == ROLE_STANDALONE
+#define FEATURE_DASHBOARD 1
+#define FEATURE_MPU 1
+#define FEATURE_AMBIENT 1
+#define FEATURE_PEER 0
+#else
+#error "CAR_ROLE must be ROLE_MAIN, ROLE_FOLLOWER or ROLE_STANDALONE"
+#endif
+
+// --- CONFIG ---
+#define NO_PIN 0xFF
+
+struct PinConfig {
+    uint8_t dht;
+    uint8_t buzzer;
+    uint8_t leftLed;
+    uint8_t rightLed;
+    uint8_t leftButton;      // With no right button, one press is left and a double press is right
+    uint8_t rightButton;
+    uint8_t frontTrig;
+    uint8_t frontEcho;
+    uint8_t backTrig;
+    uint8_t backEcho;
+    uint8_t neopixel;
+    uint8_t mpuInt;          // MPU6050 INT, for the motion wake
+};
+
+struct CarConfig {
+    const char *name;            // Shown at boot
+    const char *statusType;      // "type" in /status, used by Car 1 to find Car 2
+    PinConfig pins;
+
+    // --- WIFI ---
+    const char *ssid;
+    const char *password;
+    const char *mainHost;        // Car 1's address as seen from Car 2
+
+    // --- OUTPUTS ---
+    uint8_t neopixelCount;       // Up to a 60-LED strip; all pixels show the ambient colour
+    uint8_t neopixelBrightness;
+
+    // --- THRESHOLDS ---
+    float obstacleCm;            // Buzzer alarm and red ambient light below this
+    float proximityCm;           // Buzzer beeps, faster as it gets closer, below this
+    uint16_t ttcCautionMs;       // Time to collision at the closing speed: caution below this...
+    uint16_t ttcWarningMs;       // ...warning...
+    uint16_t ttcCriticalMs;      // ...and the alarm
+    float coldTemp;              // Ambient light is blue at or below...
+    float hotTemp;               // ...and red at or above
+    uint32_t echoTimeoutUs;      // ~5 m round trip
+    uint16_t debounceMs;
+    uint16_t doublePressMs;
+
+    // --- TIMING (ms) ---
+    uint16_t sensorMs;
+    uint16_t outputMs;           // Outputs and ambient frames
+    uint16_t blinkMs;
+    uint16_t peerCheckMs;
+    uint16_t peerSendMs;         // Resend to the other car if nothing changed; changes go at once
+    uint16_t peerTimeoutMs;      // Connect and read timeout of each HTTP call to the other car; the loop waits on it
+    uint32_t peerLostAlertMs;    // Car 1 pulses the ambient light this long after Car 2 drops out; longer is taken as switched off
+    uint16_t wsPushMs;           // Fastest dashboard push while values change...
+    uint16_t wsKeepaliveMs;      // ...and slowest while they don't. Plus two peer calls timing out in one
+                                 // loop pass (4 x peerTimeoutMs), well inside the page's 2 s stale timeout.
+    uint32_t runtimePushMs;
+    uint32_t heapReportMs;
+    uint16_t recordFlushMs;      // Input recording, RAM to flash
+    uint16_t telemetryLogMs;     // Car 1's flash log; one 4 KB write per 256 samples
+
+    // --- POWER ---
+    uint32_t idleAfterMs;        // No motion, indicators, alerts or dashboard for this long: idle (0: never)
+    uint16_t idleSensorMs;       // While idle: sensor reads and dashboard checks...
+    uint16_t idleOutputMs;       // ...outputs and ambient frames...
+    uint8_t idleCpuMhz;          // ...and the CPU clock; 80 is the lowest WiFi runs at
+};
+
+// --- ROLE TEMPLATES ---
+constexpr PinConfig CAR1_PINS = {
+    4,      // dht
+    5,      // buzzer
+    18,     // leftLed
+    19,     // rightLed
+    32,     // leftButton
+    33,     // rightButton
+    26,     // frontTrig
+    27,     // frontEcho
+    14,     // backTrig
+    12,     // backEcho
+    2,      // neopixel
+    34,     // mpuInt (input only)
+};
+
+constexpr PinConfig CAR2_PINS = {
+    4,      // dht
+    5,      // buzzer
+    18,     // leftLed
+    19,     // rightLed
+    33,     // leftButton (single and double press)
+    NO_PIN, // rightButton
+    26,     // frontTrig
+    27,     // frontEcho
+    14,     // backTrig
+    12,     // backEcho
+    NO_PIN, // neopixel
+    NO_PIN, // mpuInt
+};
+
+// Everything but the name and pins is shared, so the cars can't drift apart
+constexpr CarConfig makeConfig(const char *name, const char *statusType, PinConfig pins) {
+    return CarConfig{
+        name, statusType, pins,
+        "SmartCar_Dashboard", "12345678", "192.168.4.1",
+        1, 50,
+        6.0f, 30.0f, 3000, 1500, 700, 20.0f, 35.0f, 30000, 200, 300,
+        250, 20, 500, 2000, 2000, 250, 30000, 100, 300, 10000, 30000, 1000, 1000,
+        60000, 2000, 200, 80,
+    };
+}
+
+template <int Role> struct RoleConfig;
+
+template <> struct RoleConfig<ROLE_MAIN> {
+    static constexpr CarConfig get() { return makeConfig("Car 1", "car1", CAR1_PINS); }
+};
+
+template <> struct RoleConfig<ROLE_FOLLOWER> {
+    static constexpr CarConfig get() { return makeConfig("Car 2", "car2", CAR2_PINS); }
+};
+
+template <> struct RoleConfig<ROLE_STANDALONE> {
+    static constexpr CarConfig get() { return makeConfig("Standalone car", "car1", CAR1_PINS); }
+};
+
+// Every value is a compile-time constant, so unused branches fold away
+constexpr CarConfig CONFIG = RoleConfig<CAR_ROLE>::get();
@@ -0,0 +1,1267 @@
+/*
+ * Smart Car Dashboard - Web Interface
+ * Author: Stromlabs - Pavan Kalsariya
+ * Date: July 2025
+ * Description: HTML, CSS, and JavaScript for the web-based dashboard, displaying
+ * sensor data, compass, speedometer, two cars with indicators, and dynamic obstacles.
+ * Served by the finalised firmware (smartcar.h); web.h is main.ino's older page.
+ */
+
+#pragma once
+
+#include <pgmspace.h>
+
+const char DASHBOARD_PAGE[] PROGMEM = R"rawliteral(
+<!DOCTYPE html>
+<html lang="en">
+<head>
+    <meta charset="UTF-8">
+    <meta name="viewport" content="width=device-width, initial-scale=1.0, maximum-scale=1.0, user-scalable=no">
+    <title>Smart Car Dashboard</title>
+    <style>
+        * {
+            margin: 0;
+            padding: 0;
+            box-sizing: border-box;
+            -webkit-touch-callout: none;
+            -webkit-user-select: none;
+            -khtml-user-select: none;
+            -moz-user-select: none;
+            -ms-user-select: none;
+            user-select: none;
+        }
+
+        :root {
+            --bg-color: #1a1a1a;
+            --road-color: #2c2c2c;
+            --line-color: #fff;
+            --card-bg: rgba(60, 60, 60, 0.95);
+            --text-color: #FFFFFF;
+            --accent-color: #00FF00;
+            --danger-color: #FF0000;
+            --warning-color: #FFA500;
+            --font-family: -apple-system, BlinkMacSystemFont, 'Segoe UI', Roboto, sans-serif;
+        }
+
+        body {
+            font-family: var(--font-family);
+            background-color: var(--bg-color);
+            color: var(--text-color);
+            height: 100vh;
+            overflow: hidden;
+            display: flex;
+            justify-content: center;
+            align-items: center;
+            background-image: 
+                linear-gradient(rgba(255, 255, 255, 0.05) 1px, transparent 1px),
+                linear-gradient(90deg, rgba(255, 255, 255, 0.05) 1px, transparent 1px);
+            background-size: 20px 20px;
+        }
+
+        .dashboard-container {
+            width: 100vw;
+            height: 100vh;
+            max-width: 420px;
+            max-height: 800px;
+            display: flex;
+            flex-direction: column;
+            position: relative;
+            background-color: var(--bg-color);
+        }
+
+        .road-container {
+            flex: 1;
+            position: relative;
+            display: flex;
+            justify-content: center;
+            align-items: center;
+            min-height: 0;
+        }
+
+        .road {
+            width: 45%;
+            height: 100%;
+            background-color: var(--road-color);
+            position: relative;
+            border-left: 3px solid var(--line-color);
+            border-right: 3px solid var(--line-color);
+            overflow: hidden;
+        }
+        
+        .road-lines {
+            position: absolute;
+            width: 4px;
+            height: 200%;
+            background: linear-gradient(var(--line-color) 50%, transparent 50%);
+            background-size: 100% 60px;
+            left: 50%;
+            transform: translateX(-50%);
+            top: -100%;
+            animation: moveRoad 8s linear infinite;
+            animation-play-state: paused;
+        }
+
+        @keyframes moveRoad {
+            from { top: -100%; }
+            to { top: 0; }
+        }
+
+        .car-svg {
+            position: absolute;
+            width: 32%;
+            height: auto;
+            filter: drop-shadow(0 2px 8px rgba(0,0,0,0.6));
+            z-index: 10;
+        }
+
+        .car-svg.small {
+            width: 28%;
+        }
+
+        #main-car {
+            bottom: 45%;
+            left: 50%;
+            transform: translateX(-50%);
+        }
+
+        #second-car {
+            bottom: 10%;
+            left: 50%;
+            transform: translateX(-50%);
+        }
+
+        #other-car {
+            top: 25%;
+            left: 50%;
+            transform: translateX(-50%);
+            opacity: 0;
+            transition: opacity 0.3s ease;
+        }
+        
+        #other-car.visible {
+            opacity: 1;
+        }
+
+        .turn-indicator {
+            position: absolute;
+            width: 6px;
+            height: 6px;
+            background-color: var(--warning-color);
+            border-radius: 50%;
+            opacity: 0;
+            box-shadow: 0 0 8px var(--warning-color);
+            top: 30%;
+        }
+
+        .turn-indicator.left { left: 15%; }
+        .turn-indicator.right { right: 15%; }
+
+        .turn-indicator.blinking {
+            animation: blink 0.8s infinite;
+        }
+
+        @keyframes blink {
+            0%, 100% { opacity: 1; }
+            50% { opacity: 0; }
+        }
+
+        .obstacle {
+            position: absolute;
+            width: 12%;
+            left: 50%;
+            transform: translateX(-50%);
+            z-index: 8;
+            display: none;
+            transition: top 0.3s ease, bottom 0.3s ease;
+        }
+
+        .obstacle.front {
+            top: calc(15% + (1 - var(--dist)) * 30%);
+        }
+
+        .obstacle.back {
+            bottom: calc(15% + (1 - var(--dist)) * 30%);
+        }
+        
+        .side-controls {
+            position: absolute;
+            top: 50%;
+            transform: translateY(-50%);
+            display: flex;
+            flex-direction: column;
+            gap: 12px;
+            z-index: 20;
+        }
+
+        .side-controls.left { left: 10px; }
+        .side-controls.right { right: 10px; }
+
+        .control-card {
+            background-color: var(--card-bg);
+            border-radius: 10px;
+            padding: 8px;
+            width: 65px;
+            height: 65px;
+            display: flex;
+            flex-direction: column;
+            justify-content: center;
+            align-items: center;
+            backdrop-filter: blur(10px);
+            border: 1px solid rgba(255, 255, 255, 0.15);
+        }
+
+        .switch-container {
+            gap: 4px;
+        }
+        
+        .switch-label {
+            font-size: 8px;
+            text-transform: uppercase;
+            opacity: 0.9;
+            font-weight: 600;
+            text-align: center;
+        }
+
+        .switch {
+            position: relative;
+            display: inline-block;
+            width: 38px;
+            height: 20px;
+        }
+
+        .switch input { display: none; }
+
+        .slider {
+            position: absolute;
+            cursor: pointer;
+            top: 0;
+            left: 0;
+            right: 0;
+            bottom: 0;
+            background-color: #444;
+            border: 1px solid #666;
+            transition: .3s;
+            border-radius: 20px;
+        }
+
+        .slider:before {
+            position: absolute;
+            content: "";
+            height: 14px;
+            width: 14px;
+            left: 2px;
+            bottom: 2px;
+            background-color: #fff;
+            transition: .3s;
+            border-radius: 50%;
+        }
+
+        input:checked + .slider {
+            background-color: var(--accent-color);
+            border-color: var(--accent-color);
+        }
+        
+        input:checked + .slider:before {
+            transform: translateX(18px);
+        }
+
+        .compass, .speedometer {
+            width: 100%;
+            height: 100%;
+            transition: transform 0.3s ease-out;
+        }
+
+        .compass-arrow {
+            transform-origin: 50% 50%;
+        }
+
+        .status-indicator {
+            position: absolute;
+            top: 12px;
+            right: 12px;
+            background-color: var(--card-bg);
+            border-radius: 8px;
+            padding: 6px 10px;
+            display: none;
+            align-items: center;
+            gap: 6px;
+            font-size: 10px;
+            font-weight: 600;
+            backdrop-filter: blur(10px);
+            border: 1px solid rgba(255, 255, 255, 0.15);
+        }
+
+        .status-dot {
+            width: 8px;
+            height: 8px;
+            border-radius: 50%;
+            background-color: var(--accent-color);
+            box-shadow: 0 0 6px var(--accent-color);
+        }
+
+        .link-status {
+            right: auto;
+            left: 50%;
+            transform: translateX(-50%);
+            z-index: 30;
+        }
+
+        .link-status .status-dot {
+            background-color: var(--warning-color);
+            box-shadow: 0 0 6px var(--warning-color);
+        }
+
+        .debug-overlay {
+            position: absolute;
+            top: 12px;
+            left: 12px;
+            background-color: var(--card-bg);
+            border-radius: 8px;
+            padding: 6px 10px;
+            display: none;
+            font-family: monospace;
+            font-size: 10px;
+            line-height: 1.4;
+            white-space: pre;
+            z-index: 30;
+            border: 1px solid rgba(255, 255, 255, 0.15);
+        }
+
+        .debug-overlay.visible {
+            display: block;
+        }
+
+        .hud {
+            position: absolute;
+            bottom: 0;
+            left: 0;
+            right: 0;
+            padding: 8px;
+            display: flex;
+            flex-direction: column;
+            gap: 8px;
+            z-index: 20;
+        }
+        
+        .hud-row {
+            display: grid;
+            grid-template-columns: 1fr 1fr 1fr;
+            gap: 8px;
+        }
+        
+        .hud-row.buttons {
+            grid-template-columns: 1fr 1fr;
+        }
+
+        .hud-card {
+            background-color: var(--card-bg);
+            border-radius: 10px;
+            padding: 10px;
+            text-align: center;
+            backdrop-filter: blur(10px);
+            border: 1px solid rgba(255, 255, 255, 0.15);
+        }
+
+        .hud-card .value {
+            font-size: 22px;
+            font-weight: 600;
+            line-height: 1;
+        }
+        
+        .hud-card .unit {
+            font-size: 12px;
+            font-weight: 400;
+            opacity: 0.8;
+        }
+
+        .hud-card .label {
+            font-size: 9px;
+            text-transform: uppercase;
+            letter-spacing: 0.5px;
+            opacity: 0.7;
+            margin-top: 4px;
+            font-weight: 600;
+        }
+
+        .hud-card.danger {
+            background-color: rgba(255, 0, 0, 0.2);
+            border-color: var(--danger-color);
+            color: var(--danger-color);
+        }
+
+        .hud-card.caution {
+            background-color: rgba(255, 165, 0, 0.2);
+            border-color: var(--warning-color);
+            color: var(--warning-color);
+        }
+
+        .sparkline {
+            display: block;
+            width: 100%;
+            height: 18px;
+            margin-top: 6px;
+        }
+
+        .control-card .speedometer {
+            min-height: 0;
+        }
+
+        .control-card .sparkline {
+            height: 10px;
+            margin-top: 2px;
+            flex-shrink: 0;
+        }
+
+        .btn {
+            background-color: var(--card-bg);
+            border-radius: 10px;
+            padding: 12px;
+            font-size: 14px;
+            font-weight: 600;
+            cursor: pointer;
+            user-select: none;
+            transition: all 0.2s ease;
+            text-align: center;
+            backdrop-filter: blur(10px);
+            border: 1px solid rgba(255, 255, 255, 0.15);
+        }
+
+        .btn.pending {
+            opacity: 0.6;
+        }
+
+        .btn[data-latency]::after {
+            content: attr(data-latency);
+            display: block;
+            font-size: 9px;
+            font-weight: 400;
+            opacity: 0.7;
+            margin-top: 2px;
+        }
+
+        .btn:active {
+            transform: scale(0.95);
+        }
+        
+        .btn.active {
+            background-color: var(--accent-color);
+            color: #000;
+            border-color: var(--accent-color);
+        }
+
+        @media (max-height: 600px) {
+            .control-card {
+                width: 55px;
+                height: 55px;
+                padding: 6px;
+            }
+            
+            .switch {
+                width: 32px;
+                height: 16px;
+            }
+            
+            .switch-label {
+                font-size: 7px;
+            }
+        }
+    </style>
+</head>
+<body>
+    <div class="dashboard-container">
+        <div class="road-container">
+            <div class="road">
+                <div class="road-lines"></div>
+            </div>
+
+            <!-- Obstacle Icon (Cone) -->
+            <svg class="obstacle" id="obstacle-icon" viewBox="0 0 100 100">
+                <path d="M50 10 L20 85 L80 85 Z" fill="#FF6B00"/>
+                <rect x="25" y="70" width="50" height="6" fill="#FFF"/>
+                <rect x="30" y="50" width="40" height="6" fill="#FFF"/>
+                <rect x="35" y="30" width="30" height="6" fill="#FFF"/>
+            </svg>
+
+            <!-- Main Car (Red) -->
+            <svg id="main-car" class="car-svg" viewBox="0 0 100 180">
+                <path d="M25 10 L75 10 C85 10 90 15 90 25 L90 155 C90 165 85 170 75 170 L25 170 C15 170 10 165 10 155 L10 25 C10 15 15 10 25 10 Z" fill="#DC143C"/>
+                <rect x="20" y="35" width="60" height="40" fill="#1a1a1a" opacity="0.8"/>
+                <rect x="15" y="30" width="70" height="50" fill="#FFB6C1" opacity="0.3"/>
+                <div class="turn-indicator left"></div>
+                <div class="turn-indicator right"></div>
+            </svg>
+
+            <!-- Second Car (Blue, Smaller) -->
+            <svg id="second-car" class="car-svg small" viewBox="0 0 100 180">
+                <path d="M25 10 L75 10 C85 10 90 15 90 25 L90 155 C90 165 85 170 75 170 L25 170 C15 170 10 165 10 155 L10 25 C10 15 15 10 25 10 Z" fill="#1E90FF"/>
+                <rect x="20" y="35" width="60" height="40" fill="#1a1a1a" opacity="0.8"/>
+                <rect x="15" y="30" width="70" height="50" fill="#ADD8E6" opacity="0.3"/>
+                <div class="turn-indicator left"></div>
+                <div class="turn-indicator right"></div>
+            </svg>
+            
+            <!-- Other Car (Gray, Smaller) -->
+            <svg id="other-car" class="car-svg small" viewBox="0 0 100 180">
+                <path d="M25 10 L75 10 C85 10 90 15 90 25 L90 155 C90 165 85 170 75 170 L25 170 C15 170 10 165 10 155 L10 25 C10 15 15 10 25 10 Z" fill="#808080"/>
+                <rect x="20" y="35" width="60" height="40" fill="#1a1a1a" opacity="0.8"/>
+                <rect x="15" y="30" width="70" height="50" fill="#C0C0C0" opacity="0.3"/>
+                <div class="turn-indicator left"></div>
+                <div class="turn-indicator right"></div>
+            </svg>
+        </div>
+
+        <!-- Left Side Controls -->
+        <div class="side-controls left">
+            <div class="control-card switch-container">
+                <span class="switch-label">BUZZER</span>
+                <label class="switch">
+                    <input type="checkbox" id="buzzer-toggle" checked>
+                    <span class="slider"></span>
+                </label>
+            </div>
+            
+            <div class="control-card switch-container">
+                <span class="switch-label">AMBIENT</span>
+                <label class="switch">
+                    <input type="checkbox" id="ambient-toggle" checked>
+                    <span class="slider"></span>
+                </label>
+            </div>
+            
+            <div class="control-card">
+                <svg class="compass" viewBox="0 0 100 100">
+                    <circle cx="50" cy="50" r="45" fill="none" stroke="#666" stroke-width="4"/>
+                    <path class="compass-arrow" id="compass-arrow" d="M50 32 L45 50 L50 68 L55 50 Z" fill="#FF0000" opacity="0.8"/>
+                    <text x="50" y="25" font-size="14" fill="#fff" text-anchor="middle" font-weight="600" id="compass-text">N</text>
+                    <text x="50" y="85" font-size="12" fill="#fff" text-anchor="middle" font-weight="600">S</text>
+                    <text x="15" y="55" font-size="12" fill="#fff" text-anchor="middle" font-weight="600">W</text>
+                    <text x="85" y="55" font-size="12" fill="#fff" text-anchor="middle" font-weight="600">E</text>
+                </svg>
+            </div>
+        </div>
+
+        <!-- Right Side Controls -->
+        <div class="side-controls right">
+            <div class="control-card">
+                <svg class="speedometer" viewBox="0 0 100 100">
+                    <path d="M20 80 A40 40 0 0 1 80 80" stroke="#666" stroke-width="4" fill="none"/>
+                    <text id="speed-value" x="50" y="70" text-anchor="middle" font-size="24" font-weight="600" fill="#fff">0</text>
+                    <text x="50" y="85" text-anchor="middle" font-size="10" fill="#fff" opacity="0.7">MPH</text>
+                </svg>
+                <canvas class="sparkline" id="speed-chart"></canvas>
+            </div>
+        </div>
+
+        <!-- Status Indicator -->
+        <div id="car2-status" class="status-indicator">
+            <span>CAR 2</span>
+            <div class="status-dot"></div>
+        </div>
+
+        <!-- Connection Lost Indicator -->
+        <div id="link-status" class="status-indicator link-status">
+            <span>RECONNECTING</span>
+            <div class="status-dot"></div>
+        </div>
+
+        <!-- Debug Overlay (open the page with #debug) -->
+        <div id="debug-overlay" class="debug-overlay"></div>
+
+        <!-- Bottom HUD -->
+        <div class="hud">
+            <div class="hud-row">
+                <div class="hud-card">
+                    <div class="value"><span id="temp-value">--</span><span class="unit">°C</span></div>
+                    <div class="label">TEMPERATURE</div>
+                    <canvas class="sparkline" id="temp-chart"></canvas>
+                </div>
+                <div class="hud-card">
+                    <div class="value"><span id="humidity-value">--</span><span class="unit">%</span></div>
+                    <div class="label">HUMIDITY</div>
+                    <canvas class="sparkline" id="humidity-chart"></canvas>
+                </div>
+                <div class="hud-card" id="distance-card">
+                    <div class="value"><span id="distance-value">--</span><span class="unit">CM</span></div>
+                    <div class="label" id="distance-label">NO OBSTACLE</div>
+                    <canvas class="sparkline" id="distance-chart"></canvas>
+                </div>
+            </div>
+            <div class="hud-row buttons">
+                <div class="btn" id="turn-left-btn">← TURN LEFT</div>
+                <div class="btn" id="turn-right-btn">TURN RIGHT →</div>
+            </div>
+        </div>
+    </div>
+
+    <script>
+        let ws = null;
+        
+        // UI Elements
+        const elements = {
+            temp: document.getElementById('temp-value'),
+            humidity: document.getElementById('humidity-value'),
+            distance: document.getElementById('distance-value'),
+            distanceLabel: document.getElementById('distance-label'),
+            distanceCard: document.getElementById('distance-card'),
+            compass: document.getElementById('compass-text'),
+            compassArrow: document.getElementById('compass-arrow'),
+            speed: document.getElementById('speed-value'),
+            roadLines: document.querySelector('.road-lines'),
+            mainCarLeft: document.querySelector('#main-car .turn-indicator.left'),
+            mainCarRight: document.querySelector('#main-car .turn-indicator.right'),
+            otherCarLeft: document.querySelector('#other-car .turn-indicator.left'),
+            otherCarRight: document.querySelector('#other-car .turn-indicator.right'),
+            turnLeftBtn: document.getElementById('turn-left-btn'),
+            turnRightBtn: document.getElementById('turn-right-btn'),
+            buzzerToggle: document.getElementById('buzzer-toggle'),
+            ambientToggle: document.getElementById('ambient-toggle'),
+            car2Status: document.getElementById('car2-status'),
+            otherCar: document.getElementById('other-car'),
+            obstacle: document.getElementById('obstacle-icon'),
+            debug: document.getElementById('debug-overlay'),
+            linkStatus: document.getElementById('link-status')
+        };
+
+        // Latest state received from Car 1. The socket only writes here;
+        // the render loop below is the only place that touches the DOM.
+        const model = {
+            data: null,
+            history: null,
+            runtime: null,
+            dirty: false,
+            lastFrameAt: 0,
+            frameInterval: 100,
+            obstacleCm: 0,          // The car's obstacle distance, from the snapshot
+            direction: { from: 0, to: 0, start: 0 },
+            speed: { from: 0, to: 0, start: 0 }
+        };
+
+        // Sparklines keep one min/max pair per pixel column. A new sample only
+        // touches its own column, and advancing time shifts the existing
+        // pixels left instead of redrawing, so drawing cost depends on the
+        // canvas width, not on how much time the window covers.
+        class Sparkline {
+            constructor(canvas, series, options) {
+                this.canvas = canvas;
+                this.ctx = canvas.getContext('2d');
+                this.series = series;
+                this.windowMs = options.windowMs;
+                this.lo = options.lo;
+                this.hi = options.hi;
+                this.clampLo = options.clampLo ?? -Infinity;
+                this.clampHi = options.clampHi ?? Infinity;
+                this.resize();
+            }
+
+            resize() {
+                const dpr = window.devicePixelRatio || 1;
+                this.width = Math.max(1, Math.round(this.canvas.clientWidth * dpr));
+                this.height = Math.max(1, Math.round(this.canvas.clientHeight * dpr));
+                this.canvas.width = this.width;
+                this.canvas.height = this.height;
+                this.columnMs = this.windowMs / this.width;
+                this.mins = this.series.map(() => new Float32Array(this.width).fill(NaN));
+                this.maxs = this.series.map(() => new Float32Array(this.width).fill(NaN));
+                this.head = null;
+                this.shift = 0;
+                this.dirty = new Set();
+                this.redrawAll = true;
+            }
+
+            slot(column) {
+                return ((column % this.width) + this.width) % this.width;
+            }
+
+            push(time, values) {
+                const column = Math.floor(time / this.columnMs);
+                if (this.head === null) this.head = column;
+                if (column <= this.head - this.width) return;
+
+                // Time moved on: recycle the columns that scrolled off
+                if (column > this.head) {
+                    const steps = Math.min(column - this.head, this.width);
+                    for (let i = 1; i <= steps; i++) {
+                        const slot = this.slot(this.head + i);
+                        this.mins.forEach(m => m[slot] = NaN);
+                        this.maxs.forEach(m => m[slot] = NaN);
+                    }
+                    this.shift += column - this.head;
+                    this.head = column;
+                }
+
+                const slot = this.slot(column);
+                values.forEach((raw, i) => {
+                    if (raw === undefined || raw === null || isNaN(raw)) return;
+                    const value = Math.min(Math.max(raw, this.clampLo), this.clampHi);
+                    if (!(this.mins[i][slot] <= value)) this.mins[i][slot] = value;
+                    if (!(this.maxs[i][slot] >= value)) this.maxs[i][slot] = value;
+
+                    // The scale only ever grows, so a rescale is rare
+                    if (value < this.lo || value > this.hi) {
+                        const pad = (this.hi - this.lo) * 0.1;
+                        if (value < this.lo) this.lo = value - pad;
+                        if (value > this.hi) this.hi = value + pad;
+                        this.redrawAll = true;
+                    }
+                });
+                this.dirty.add(column);
+            }
+
+            draw() {
+                const ctx = this.ctx;
+                if (this.redrawAll || this.shift >= this.width) {
+                    ctx.clearRect(0, 0, this.width, this.height);
+                    if (this.head !== null) {
+                        for (let column = this.head - this.width + 1; column <= this.head; column++) {
+                            this.drawColumn(column);
+                        }
+                    }
+                } else {
+                    if (this.shift > 0) {
+                        ctx.globalCompositeOperation = 'copy';
+                        ctx.drawImage(this.canvas, -this.shift, 0);
+                        ctx.globalCompositeOperation = 'source-over';
+                        ctx.clearRect(this.width - this.shift, 0, this.shift, this.height);
+                    }
+                    this.dirty.forEach(column => {
+                        if (column > this.head - this.width) this.drawColumn(column);
+                    });
+                }
+                this.redrawAll = false;
+                this.shift = 0;
+                this.dirty.clear();
+            }
+
+            drawColumn(column) {
+                const ctx = this.ctx;
+                const x = this.width - 1 - (this.head - column);
+                const slot = this.slot(column);
+                const scale = (this.height - 1) / (this.hi - this.lo || 1);
+                ctx.clearRect(x, 0, 1, this.height);
+                this.series.forEach((series, i) => {
+                    const min = this.mins[i][slot];
+                    const max = this.maxs[i][slot];
+                    if (isNaN(min)) return;
+                    const top = this.height - 1 - (max - this.lo) * scale;
+                    const bottom = this.height - 1 - (min - this.lo) * scale;
+                    ctx.fillStyle = series.color;
+                    ctx.fillRect(x, Math.floor(top), 1, Math.max(1, Math.ceil(bottom - top)));
+                });
+            }
+        }
+
+        const chartWindowMs = 3 * 60 * 1000;
+        const charts = [
+            new Sparkline(document.getElementById('temp-chart'),
+                [{ key: 'temp', color: '#FFA500' }], { windowMs: chartWindowMs, lo: 15, hi: 35 }),
+            new Sparkline(document.getElementById('humidity-chart'),
+                [{ key: 'humidity', color: '#1E90FF' }], { windowMs: chartWindowMs, lo: 20, hi: 80 }),
+            new Sparkline(document.getElementById('distance-chart'),
+                [{ key: 'frontDist', color: '#FF0000' }, { key: 'backDist', color: '#00FF00' }],
+                { windowMs: chartWindowMs, lo: 0, hi: 100, clampLo: 0, clampHi: 100 }),
+            new Sparkline(document.getElementById('speed-chart'),
+                [{ key: 'speed', color: '#FFFFFF' }], { windowMs: chartWindowMs, lo: 0, hi: 2 })
+        ];
+
+        function chartSample(time, data) {
+            charts.forEach(chart => chart.push(time, chart.series.map(series => data[series.key])));
+        }
+
+        // Start the charts over from the replayed history
+        function seedCharts(history) {
+            charts.forEach(chart => chart.resize());
+            for (let row = 0; row < history.time.length; row++) {
+                const sample = {};
+                for (const field in history.series) sample[field] = history.series[field][row];
+                chartSample(history.time[row], sample);
+            }
+        }
+
+        window.addEventListener('resize', () => {
+            if (model.history) seedCharts(model.history);
+            else charts.forEach(chart => chart.resize());
+        });
+
+        // Values currently shown in the DOM, so unchanged ones are skipped
+        const applied = {};
+
+        // Frame timing for the debug overlay
+        const debugEnabled = window.location.hash === '#debug';
+        const stats = { frames: [], work: [], messages: 0, lastReport: 0 };
+
+        // Connection state. Car 1 pushes a frame on every change and at
+        // least every 300 ms, so a silent link is detected in seconds instead
+        // of waiting for TCP to give up. The stale timeout also covers a loop
+        // pass where two calls to Car 2 time out (up to 1 s in all).
+        const link = {
+            attempt: 0,
+            retryTimer: null,
+            staleTimer: null,
+            serverOffset: 0,
+            baseDelay: 100,
+            maxDelay: 1000,
+            staleAfter: 2000,
+            connectTimeout: 1500
+        };
+
+        function connect() {
+            clearTimeout(link.retryTimer);
+            link.retryTimer = null;
+
+            ws = new WebSocket(`ws://${window.location.hostname}/ws`);
+            ws.binaryType = 'arraybuffer';
+
+            // WebSocket Events
+            ws.onopen = () => {
+                console.log('Connected to Smart Car');
+                link.attempt = 0;
+                setLinkStatus(true);
+                watchLink();
+            };
+
+            ws.onclose = () => {
+                console.log('Disconnected from Smart Car');
+                scheduleReconnect();
+            };
+
+            ws.onerror = (error) => console.error('WebSocket error:', error);
+            ws.onmessage = onFrame;
+            watchLink(link.connectTimeout);
+        }
+
+        function scheduleReconnect() {
+            clearTimeout(link.staleTimer);
+            setLinkStatus(false);
+            if (link.retryTimer) return;
+
+            // Exponential backoff with full jitter, capped low so a short
+            // WiFi blip recovers in well under a second
+            const ceiling = Math.min(link.maxDelay, link.baseDelay * Math.pow(2, link.attempt));
+            const delay = Math.random() * ceiling;
+            link.attempt++;
+            link.retryTimer = setTimeout(connect, delay);
+        }
+
+        function watchLink(timeout = link.staleAfter) {
+            clearTimeout(link.staleTimer);
+            link.staleTimer = setTimeout(() => {
+                console.log('No data from Smart Car, reconnecting');
+                const stale = ws;
+                stale.onclose = null;
+                stale.onmessage = null;
+                stale.close();
+                scheduleReconnect();
+            }, timeout);
+        }
+
+        function setLinkStatus(connected) {
+            setStyle(elements.linkStatus, 'link', 'display', connected ? 'none' : 'flex');
+        }
+
+        // Reconnect straight away when the phone wakes up or rejoins WiFi
+        function reconnectNow() {
+            if (ws.readyState === WebSocket.CLOSED || ws.readyState === WebSocket.CLOSING) {
+                link.attempt = 0;
+                connect();
+            }
+        }
+        window.addEventListener('online', reconnectNow);
+        document.addEventListener('visibilitychange', () => { if (!document.hidden) reconnectNow(); });
+
+        function onFrame(event) {
+            const now = performance.now();
+            watchLink();
+
+            // Binary frames carry the history replay sent on connect
+            if (event.data instanceof ArrayBuffer) {
+                const history = decodeHistory(event.data, now);
+                if (history) {
+                    model.history = history;
+                    seedCharts(history);
+                }
+                return;
+            }
+
+            const data = JSON.parse(event.data);
+
+            if (data.type === 'ack') {
+                onAck(data, now);
+                return;
+            }
+
+            // Car 1 heap/stack/queue snapshot, every 10 s; only the debug overlay shows it
+            if (data.type === 'runtime') {
+                model.runtime = data;
+                return;
+            }
+
+            // A snapshot is sent once per connection: take it as-is instead
+            // of interpolating from whatever was on screen before the drop
+            if (data.type === 'snapshot') {
+                link.serverOffset = data.serverTime - now;
+                model.obstacleCm = data.obstacleCm;
+                model.lastFrameAt = 0;
+                model.direction = { from: data.direction, to: data.direction, start: now };
+                model.speed = { from: data.speed, to: data.speed, start: now };
+                model.data = data;
+                model.dirty = true;
+                return;
+            }
+
+            // Track the server send rate so interpolation spans one frame
+            if (model.lastFrameAt) {
+                const gap = Math.min(Math.max(now - model.lastFrameAt, 50), 500);
+                model.frameInterval += (gap - model.frameInterval) * 0.2;
+            }
+            model.lastFrameAt = now;
+
+            // Start new interpolation segments from where the display is now
+            retarget(model.direction, data.direction, now, true);
+            retarget(model.speed, data.speed, now, false);
+
+            model.data = data;
+            model.dirty = true;
+            chartSample(now, data);
+            stats.messages++;
+        }
+
+        // History frame layout is documented in history.h. Row times are
+        // mapped onto the performance.now() clock of this page.
+        const historyFields = ['temp', 'humidity', 'frontDist', 'backDist', 'speed', 'direction'];
+
+        function decodeHistory(buffer, now) {
+            const view = new DataView(buffer);
+            if (view.byteLength < 12 || view.getUint8(0) !== 0x48 || view.getUint8(1) !== 1) return null;
+
+            const resolution = view.getUint16(2, true);
+            const channels = view.getUint8(4);
+            const rows = view.getUint16(6, true);
+            const history = { resolution, time: new Float64Array(rows), series: {} };
+            historyFields.forEach(field => history.series[field] = new Float32Array(rows));
+
+            let offset = 12;
+            for (let row = 0; row < rows; row++) {
+                history.time[row] = now - view.getUint16(offset, true) * 1000;
+                offset += 2;
+                for (let c = 0; c < channels; c++) {
+                    const field = historyFields[c];
+                    if (field) history.series[field][row] = view.getInt16(offset, true) / 10;
+                    offset += 2;
+                }
+            }
+            return history;
+        }
+
+        function retarget(channel, value, now, isAngle) {
+            channel.from = sample(channel, now, isAngle);
+            channel.to = value;
+            channel.start = now;
+        }
+
+        function sample(channel, now, isAngle) {
+            const t = Math.min((now - channel.start) / model.frameInterval, 1);
+            let delta = channel.to - channel.from;
+            if (isAngle) delta = ((delta % 360) + 540) % 360 - 180; // Shortest way round
+            let value = channel.from + delta * t;
+            if (isAngle) value = (value + 360) % 360;
+            return value;
+        }
+
+        // DOM writers that only touch the page when the value changed
+        function setText(el, key, value) {
+            if (applied[key] !== value) {
+                applied[key] = value;
+                el.textContent = value;
+            }
+        }
+
+        function setClass(el, key, name, on) {
+            if (applied[key] !== on) {
+                applied[key] = on;
+                el.classList.toggle(name, on);
+            }
+        }
+
+        function setStyle(el, key, prop, value) {
+            if (applied[key] !== value) {
+                applied[key] = value;
+                el.style[prop] = value;
+            }
+        }
+
+        function render(now) {
+            const workStart = performance.now();
+
+            if (model.data) {
+                // Interpolated channels update every frame while moving
+                const direction = sample(model.direction, now, true);
+                const heading = Math.round(direction);
+                setStyle(elements.compassArrow, 'arrow', 'transform', `rotate(${heading}deg)`);
+
+                const directions = ['N', 'NE', 'E', 'SE', 'S', 'SW', 'W', 'NW'];
+                setText(elements.compass, 'compass', directions[Math.round(direction / 45) % 8]);
+
+                const speed = Math.round(sample(model.speed, now, false) * 10) / 10;
+                setText(elements.speed, 'speed', Number.isInteger(speed) ? `${speed}` : speed.toFixed(1));
+                setStyle(elements.roadLines, 'road', 'animationPlayState', model.data.speed > 0 ? 'running' : 'paused');
+            }
+
+            if (model.dirty) {
+                model.dirty = false;
+                applyState(model.data);
+            }
+
+            charts.forEach(chart => chart.draw());
+
+            if (debugEnabled) recordFrame(now, performance.now() - workStart);
+            requestAnimationFrame(render);
+        }
+
+        function applyState(data) {
+            // Update sensor data
+            setText(elements.temp, 'temp', data.temp.toFixed(1));
+            setText(elements.humidity, 'humidity', data.humidity.toFixed(1));
+
+            // Handle obstacle detection and collision warnings
+            updateObstacle(data.frontDist, data.backDist, data.collision, data.collisionSide, data.ttc);
+
+            // Update turn indicators
+            setClass(elements.mainCarLeft, 'mainLeft', 'blinking', data.leftIndicator);
+            setClass(elements.mainCarRight, 'mainRight', 'blinking', data.rightIndicator);
+            setClass(elements.turnLeftBtn, 'leftBtn', 'active', data.leftIndicator);
+            setClass(elements.turnRightBtn, 'rightBtn', 'active', data.rightIndicator);
+
+            // Update Car 2 status
+            setStyle(elements.car2Status, 'car2Status', 'display', data.car2Connected ? 'flex' : 'none');
+            setClass(elements.otherCar, 'otherCar', 'visible', data.car2Connected);
+            
+            if (data.car2Connected) {
+                setClass(elements.otherCarLeft, 'otherLeft', 'blinking', data.car2Left);
+                setClass(elements.otherCarRight, 'otherRight', 'blinking', data.car2Right);
+            }
+
+            // Update toggles
+            if (applied.buzzer !== data.buzzerOn) {
+                applied.buzzer = data.buzzerOn;
+                elements.buzzerToggle.checked = data.buzzerOn;
+            }
+            if (applied.ambient !== data.ambientOn) {
+                applied.ambient = data.ambientOn;
+                elements.ambientToggle.checked = data.ambientOn;
+            }
+        }
+
+        const COLLISION_LABELS = { caution: 'CAUTION', warning: 'BRAKE', critical: 'DANGER' };
+
+        // Closer than the obstacle distance is always danger; otherwise the
+        // car's time-to-collision grade, from how fast the gap is closing
+        function updateObstacle(frontDist, backDist, collision, collisionSide, ttc) {
+            let showObstacle = false;
+            let caution = false;
+            let distance = 0;
+            let position = 'front';
+            let label = 'NO OBSTACLE';
+
+            if (frontDist < model.obstacleCm) {
+                showObstacle = true;
+                distance = frontDist;
+                position = 'front';
+                label = 'DANGER - FRONT';
+            } else if (backDist < model.obstacleCm) {
+                showObstacle = true;
+                distance = backDist;
+                position = 'back';
+                label = 'DANGER - BACK';
+            } else if (collision && collision !== 'none') {
+                showObstacle = true;
+                caution = collision !== 'critical';
+                position = collisionSide;
+                distance = position === 'back' ? backDist : frontDist;
+                label = `${COLLISION_LABELS[collision]} - ${position.toUpperCase()} ${ttc.toFixed(1)} S`;
+            }
+
+            setStyle(elements.obstacle, 'obstacle', 'display', showObstacle ? 'block' : 'none');
+            setClass(elements.distanceCard, 'danger', 'danger', showObstacle && !caution);
+            setClass(elements.distanceCard, 'caution', 'caution', caution);
+            setText(elements.distanceLabel, 'distanceLabel', label);
+
+            if (showObstacle) {
+                if (applied.obstaclePos !== position) {
+                    applied.obstaclePos = position;
+                    elements.obstacle.setAttribute('class', `obstacle ${position}`);
+                }
+                const rounded = distance.toFixed(0);
+                setText(elements.distance, 'distance', rounded);
+                // The marker's scale ends at the obstacle distance; farther
+                // warnings sit at its edge
+                const markerDist = Math.min(rounded / model.obstacleCm, 1);
+                if (applied.obstacleDist !== markerDist) {
+                    applied.obstacleDist = markerDist;
+                    elements.obstacle.style.setProperty('--dist', markerDist);
+                }
+            } else {
+                setText(elements.distance, 'distance', '--');
+            }
+        }
+
+        function commandAverage() {
+            const samples = commands.samples;
+            return samples.reduce((sum, v) => sum + v, 0) / (samples.length || 1);
+        }
+
+        function runtimeSummary(rt) {
+            if (!rt) return '';
+            const kb = (bytes) => (bytes / 1024).toFixed(1);
+            const stacks = Object.entries(rt.stacks).map(([name, free]) => `${name} ${free}`).join(' / ');
+            return `\nHEAP  ${kb(rt.heap.free)}k / block ${kb(rt.heap.largestBlock)}k / low ${kb(rt.heap.minLargestBlock)}k\n` +
+                `STACK ${stacks}\n` +
+                `WSQ   ${rt.ws.queued} queued / max ${rt.ws.maxQueued} / up ${rt.uptime}s`;
+        }
+
+        function recordFrame(now, work) {
+            if (stats.lastFrame) {
+                stats.frames.push(now - stats.lastFrame);
+                stats.work.push(work);
+            }
+            stats.lastFrame = now;
+
+            if (now - stats.lastReport < 500) return;
+            const elapsed = (now - stats.lastReport) / 1000;
+            stats.lastReport = now;
+
+            const frames = stats.frames.sort((a, b) => a - b);
+            const work95 = stats.work.sort((a, b) => a - b)[Math.floor(stats.work.length * 0.95)] || 0;
+            const avg = frames.reduce((sum, f) => sum + f, 0) / (frames.length || 1);
+            const p95 = frames[Math.floor(frames.length * 0.95)] || 0;
+            const max = frames[frames.length - 1] || 0;
+
+            elements.debug.textContent =
+                `FPS   ${(1000 / (avg || 1)).toFixed(0)}\n` +
+                `FRAME ${avg.toFixed(1)} / p95 ${p95.toFixed(1)} / max ${max.toFixed(1)} ms\n` +
+                `WORK  p95 ${work95.toFixed(2)} ms\n` +
+                `MSG   ${(stats.messages / elapsed).toFixed(1)}/s\n` +
+                `LINK  ${ws && ws.readyState === WebSocket.OPEN ? 'up' : 'down'} / retries ${link.attempt}\n` +
+                `CMD   last ${commands.last.toFixed(0)} / avg ${commandAverage().toFixed(0)} ms` +
+                runtimeSummary(model.runtime);
+            stats.frames = [];
+            stats.work = [];
+            stats.messages = 0;
+        }
+
+        if (debugEnabled) elements.debug.classList.add('visible');
+        connect();
+        requestAnimationFrame(render);
+
+        function sendMessage(message) {
+            if (ws.readyState === WebSocket.OPEN) {
+                ws.send(JSON.stringify(message));
+            }
+        }
+
+        // Commands carry the wanted state and a sequence number, and Car 1
+        // acks with the same number and the state now in effect. A command
+        // with no ack is resent unchanged: setting the same state twice is
+        // harmless, unlike a toggle.
+        const commands = {
+            seq: 0,
+            pending: new Map(),
+            intent: new Map(),
+            retryMs: 1000,
+            maxTries: 3,
+            last: 0,
+            samples: []
+        };
+
+        const commandFields = {
+            left_indicator: 'leftIndicator',
+            right_indicator: 'rightIndicator',
+            buzzer: 'buzzerOn',
+            ambient: 'ambientOn'
+        };
+
+        function sendCommand(target, value, button) {
+            const seq = ++commands.seq;
+            commands.intent.set(target, value);
+            commands.pending.set(seq, {
+                command: { action: 'set', target, value, seq },
+                button,
+                sentAt: performance.now(),
+                tries: 0,
+                timer: null
+            });
+            transmit(seq);
+        }
+
+        function transmit(seq) {
+            const entry = commands.pending.get(seq);
+            if (!entry) return;
+            if (entry.tries++ >= commands.maxTries) {
+                settle(seq, entry);
+                return;
+            }
+            if (entry.button) entry.button.classList.add('pending');
+            sendMessage(entry.command);
+            entry.timer = setTimeout(() => transmit(seq), commands.retryMs);
+        }
+
+        function settle(seq, entry) {
+            clearTimeout(entry.timer);
+            commands.pending.delete(seq);
+            if (commands.intent.get(entry.command.target) === entry.command.value) {
+                commands.intent.delete(entry.command.target);
+            }
+            if (entry.button) entry.button.classList.remove('pending');
+        }
+
+        function onAck(ack, now) {
+            const entry = commands.pending.get(ack.seq);
+            if (!entry) return; // Ack for a resend that was already answered
+            settle(ack.seq, entry);
+
+            // Click-to-confirmed latency, including any resends
+            const latency = now - entry.sentAt;
+            commands.last = latency;
+            commands.samples.push(latency);
+            if (commands.samples.length > 20) commands.samples.shift();
+            if (entry.button) entry.button.dataset.latency = `${Math.round(latency)} ms`;
+
+            if (model.data) {
+                for (const field of Object.values(commandFields)) model.data[field] = ack[field];
+                model.dirty = true;
+            }
+        }
+
+        // State a click should flip from: a pending command wins over the
+        // last frame, so a quick double click turns the indicator back off
+        function currentState(target) {
+            if (commands.intent.has(target)) return commands.intent.get(target);
+            return model.data ? model.data[commandFields[target]] : false;
+        }
+
+        // Event Listeners
+        elements.turnLeftBtn.addEventListener('click', () => {
+            sendCommand('left_indicator', !currentState('left_indicator'), elements.turnLeftBtn);
+        });
+
+        elements.turnRightBtn.addEventListener('click', () => {
+            sendCommand('right_indicator', !currentState('right_indicator'), elements.turnRightBtn);
+        });
+
+        elements.buzzerToggle.addEventListener('change', (e) => {
+            applied.buzzer = e.target.checked;
+            sendCommand('buzzer', e.target.checked, null);
+        });
+
+        elements.ambientToggle.addEventListener('change', (e) => {
+            applied.ambient = e.target.checked;
+            sendCommand('ambient', e.target.checked, null);
+        });
+
+        // Disable context menu and text selection
+        document.addEventListener('contextmenu', e => e.preventDefault());
+        document.addEventListener('selectstart', e => e.preventDefault());
+        document.addEventListener('dragstart', e => e.preventDefault());
+    </script>
+</body>
+</html>
+)rawliteral";
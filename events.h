@@ -0,0 +1,211 @@
+/*
+ * Smart Car Dashboard - State Events
+ * Author: Stromlabs - Pavan Kalsariya
+ * Date: July 2025
+ * Description: Publish/subscribe on state fields, so consumers react to a
+ * change instead of re-reading the whole state on a timer. A writer publishes
+ * a field's ID after changing it; the event is stamped and pushed onto a
+ * bounded lock-free queue, which is safe from ISRs and from other tasks
+ * (async_tcp). The loop task drains the queue in dispatch() and calls each
+ * subscriber whose filter matches, with a mask of the fields that changed.
+ * A subscriber's window caps how often it runs: the first change after a
+ * quiet spell is delivered at once, later ones are merged until the window
+ * has passed. If the queue is full no change is lost: the field is flagged
+ * and delivered on the next dispatch. How long each change waited for its
+ * subscriber is kept per subscriber.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <atomic>
+#include "jsonwriter.h"
+#include "profiler.h"
+
+#define EVENT_BIT(f) (1UL << (f))
+
+typedef void (*EventHandler)(uint32_t fields);  // Mask of fields changed since the last call
+typedef void (*EventWake)();                    // Wakes the consumer, from any context
+
+struct EventSubscriber {
+    const char *name;
+    EventHandler handler;
+    uint32_t filter;            // EVENT_BIT per field of interest
+    uint32_t windowUs;          // Minimum time between runs
+    uint32_t pending;           // Fields changed but not yet delivered
+    uint32_t oldestUs;          // Time of the first pending change
+    uint32_t lastRunUs;
+    uint32_t runs;
+    uint32_t events;            // Changes delivered; events - runs were merged
+    LatencyHistogram latency;   // Change published to handler called
+};
+
+// MaxSubscribers up to 32 fields each; QueueSize a power of two (12 bytes a slot)
+template <uint8_t MaxSubscribers, uint16_t QueueSize>
+class EventBus {
+public:
+    explicit EventBus(EventWake wake = NULL) : wake_(wake) {
+        static_assert((QueueSize & (QueueSize - 1)) == 0, "QueueSize must be a power of two");
+        for (uint32_t i = 0; i < QueueSize; i++) slots_[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    // Returns the subscriber's index, or -1 if the table is full
+    int8_t subscribe(const char *name, uint32_t filter, uint32_t windowMs, EventHandler handler) {
+        if (count_ >= MaxSubscribers || !handler) return -1;
+        EventSubscriber &sub = subs_[count_];
+        sub.name = name;
+        sub.handler = handler;
+        sub.filter = filter;
+        sub.windowUs = windowMs * 1000;
+        sub.lastRunUs = micros() - sub.windowUs;
+        return count_++;
+    }
+
+    // --- PUBLISHING (any context) ---
+    void publish(uint8_t field) {
+        if (!push(field)) {
+            // Queue full: the change is still delivered, stamped when seen
+            overflow_.fetch_or(EVENT_BIT(field), std::memory_order_relaxed);
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+        }
+        published_.fetch_add(1, std::memory_order_relaxed);
+        if (wake_) wake_();
+    }
+
+    // --- DISPATCH (loop task only) ---
+    // Delivers queued changes to subscribers whose window has passed.
+    // Changes published by a handler are delivered on the next call.
+    void dispatch() {
+        Event ev;
+        while (pop(ev)) mark(EVENT_BIT(ev.field), ev.timeUs);
+        uint32_t lost = overflow_.exchange(0, std::memory_order_relaxed);
+        if (lost) mark(lost, micros());
+
+        for (uint8_t i = 0; i < count_; i++) {
+            EventSubscriber &sub = subs_[i];
+            if (!sub.pending) continue;
+            uint32_t now = micros();
+            if (now - sub.lastRunUs < sub.windowUs) continue;   // Merged into a later run
+
+            uint32_t fields = sub.pending;
+            sub.pending = 0;
+            sub.latency.record(now - sub.oldestUs);
+            sub.lastRunUs = now;
+            sub.runs++;
+            sub.handler(fields);
+        }
+    }
+
+    // Time until a merged change is due; 0 if anything can be delivered now
+    uint32_t idleUs() const {
+        if (queued() || overflow_.load(std::memory_order_relaxed)) return 0;
+        uint32_t now = micros();
+        uint32_t idle = UINT32_MAX;
+        for (uint8_t i = 0; i < count_; i++) {
+            const EventSubscriber &sub = subs_[i];
+            if (!sub.pending) continue;
+            uint32_t since = now - sub.lastRunUs;
+            if (since >= sub.windowUs) return 0;
+            if (sub.windowUs - since < idle) idle = sub.windowUs - since;
+        }
+        return idle;
+    }
+
+    uint8_t count() const { return count_; }
+    const EventSubscriber &subscriber(uint8_t i) const { return subs_[i]; }
+    uint32_t published() const { return published_.load(std::memory_order_relaxed); }
+    uint32_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+    // "events":{"unit":"us","published":..,"dropped":..,"subscribers":[{"name":..,"runs":..,"events":..,"p50":..,"p99":..,"max":..},...]}
+    // dropped: changes that found the queue full (still delivered, late)
+    void write(JsonWriter &json, const char *key = "events") const {
+        json.beginObject(key)
+            .add("unit", "us")
+            .add("published", published())
+            .add("dropped", dropped())
+            .beginArray("subscribers");
+        for (uint8_t i = 0; i < count_; i++) {
+            const EventSubscriber &sub = subs_[i];
+            json.beginObject()
+                .add("name", sub.name)
+                .add("runs", sub.runs)
+                .add("events", sub.events)
+                .add("p50", sub.latency.percentileUs(50))
+                .add("p99", sub.latency.percentileUs(99))
+                .add("max", sub.latency.maxUs())
+                .endObject();
+        }
+        json.endArray().endObject();
+    }
+
+private:
+    struct Event {
+        uint32_t timeUs;
+        uint8_t field;
+    };
+
+    struct Slot {
+        std::atomic<uint32_t> seq;
+        Event ev;
+    };
+
+    // Same bounded multi-producer queue as the logger's: a producer claims a
+    // position with a CAS, fills the slot, then publishes it by advancing the
+    // slot's sequence
+    bool push(uint8_t field) {
+        uint32_t pos = head_.load(std::memory_order_relaxed);
+        Slot *slot;
+        for (;;) {
+            slot = &slots_[pos & (QueueSize - 1)];
+            int32_t diff = (int32_t)(slot->seq.load(std::memory_order_acquire) - pos);
+            if (diff == 0) {
+                if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = head_.load(std::memory_order_relaxed);
+            }
+        }
+
+        slot->ev.timeUs = micros();
+        slot->ev.field = field;
+        slot->seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(Event &ev) {
+        Slot *slot = &slots_[tail_ & (QueueSize - 1)];
+        if (slot->seq.load(std::memory_order_acquire) != tail_ + 1) return false;
+        ev = slot->ev;
+        slot->seq.store(tail_ + QueueSize, std::memory_order_release);
+        tail_++;
+        return true;
+    }
+
+    bool queued() const {
+        return slots_[tail_ & (QueueSize - 1)].seq.load(std::memory_order_acquire) == tail_ + 1;
+    }
+
+    // Add changed fields to every subscriber that wants them
+    void mark(uint32_t fields, uint32_t timeUs) {
+        for (uint8_t i = 0; i < count_; i++) {
+            EventSubscriber &sub = subs_[i];
+            uint32_t wanted = fields & sub.filter;
+            if (!wanted) continue;
+            if (!sub.pending) sub.oldestUs = timeUs;
+            sub.pending |= wanted;
+            sub.events++;
+        }
+    }
+
+    EventWake wake_;
+    EventSubscriber subs_[MaxSubscribers] = {};
+    uint8_t count_ = 0;
+
+    Slot slots_[QueueSize];
+    std::atomic<uint32_t> head_{0};
+    uint32_t tail_ = 0;                 // Loop task only
+    std::atomic<uint32_t> overflow_{0};
+    std::atomic<uint32_t> published_{0};
+    std::atomic<uint32_t> dropped_{0};
+};
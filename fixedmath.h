@@ -0,0 +1,120 @@
+/*
+ * Smart Car Dashboard - Fixed-Point Sensor Math
+ * Author: Stromlabs - Pavan Kalsariya
+ * Date: July 2025
+ * Description: Integer versions of the per-sample sensor math. The ESP32 has
+ * a single-precision FPU but does doubles, pow() and sqrt() in software, and
+ * the old expressions used all three on every sample. Each kernel here
+ * matches the float version it replaces to within its stated error
+ * (checked by tools/fixedmath_bench).
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+// --- ULTRASONIC ---
+// Sound travels 0.034 cm/us and the echo covers the distance twice, so
+// 0.17 mm per microsecond of echo, as a Q16 multiplier. Rounded to whole
+// millimetres, and within 0.6 mm of duration * 0.034 / 2 up to the 30 ms
+// timeout.
+#define ECHO_MM_PER_US_Q16 11141UL      // 0.17 * 65536
+#define ECHO_NONE_MM 9990               // No echo: same 999 cm the dashboard treats as clear
+
+inline uint16_t echoToMm(uint32_t echoUs) {
+    if (echoUs == 0) return ECHO_NONE_MM;
+    uint32_t mm = (echoUs * ECHO_MM_PER_US_Q16 + 0x8000) >> 16;
+    return mm < ECHO_NONE_MM ? mm : ECHO_NONE_MM;
+}
+
+// --- ACCELERATION ---
+// Speed level from how far the acceleration magnitude is from 1 g, without
+// the square root: |m - g| > t  <=>  m^2 > (g + t)^2 or m^2 < (g - t)^2.
+// Components are in 1/256 m/s^2, clamped to 16 bits so the squared sum
+// always fits 32 bits (the MPU is set to +-8 g, well inside that).
+#define ACCEL_Q 256
+#define ACCEL_GRAVITY 9.8f
+
+constexpr uint32_t accelBandSq(float offset) {
+    return (uint32_t)((ACCEL_GRAVITY + offset) * ACCEL_Q * (ACCEL_GRAVITY + offset) * ACCEL_Q);
+}
+
+inline int32_t accelToFixed(float ms2) {
+    int32_t v = (int32_t)(ms2 * ACCEL_Q);
+    return v > 32767 ? 32767 : (v < -32767 ? -32767 : v);
+}
+
+// 0 within 0.5 m/s^2 of gravity, 1 within 1.5, 2 beyond (speed 0/1/2 on the dashboard)
+inline uint8_t speedLevel(int32_t x, int32_t y, int32_t z) {
+    static constexpr uint32_t kLow1 = accelBandSq(-0.5f), kHigh1 = accelBandSq(0.5f);
+    static constexpr uint32_t kLow2 = accelBandSq(-1.5f), kHigh2 = accelBandSq(1.5f);
+    uint32_t m2 = (uint32_t)(x * x) + (uint32_t)(y * y) + (uint32_t)(z * z);    // Each square < 2^30
+    if (m2 > kHigh2 || m2 < kLow2) return 2;
+    if (m2 > kHigh1 || m2 < kLow1) return 1;
+    return 0;
+}
+
+// --- YAW ---
+// Heading from the gyro's z rate, kept in millidegrees with the sub-
+// millidegree remainder carried over, so slow turns don't round away. Rate
+// and interval are clamped so the product stays in 32 bits (64-bit division
+// is a library call on the ESP32); the gyro is set to +-500 deg/s anyway.
+#define RAD_TO_MDEG 57295.7795f
+#define YAW_MAX_RATE_MDEG 1000000
+#define YAW_MAX_DT_MS 2000
+
+class YawIntegrator {
+public:
+    // rateMdeg: gyro z in millidegrees per second; dtMs since the last update
+    void update(int32_t rateMdeg, uint32_t dtMs) {
+        if (rateMdeg > YAW_MAX_RATE_MDEG) rateMdeg = YAW_MAX_RATE_MDEG;
+        if (rateMdeg < -YAW_MAX_RATE_MDEG) rateMdeg = -YAW_MAX_RATE_MDEG;
+        if (dtMs > YAW_MAX_DT_MS) dtMs = YAW_MAX_DT_MS;
+
+        int32_t step = rateMdeg * (int32_t)dtMs + remainder_;
+        int32_t whole = step / 1000;
+        remainder_ = step - whole * 1000;
+        yaw_ = (yaw_ + whole) % 360000;
+        if (yaw_ < 0) yaw_ += 360000;
+    }
+
+    int32_t millidegrees() const { return yaw_; }
+    float degrees() const { return yaw_ * 0.001f; }
+
+private:
+    int32_t yaw_ = 0;
+    int32_t remainder_ = 0;
+};
+
+// --- TEMPERATURE COLOR ---
+// Blue at or below cold, red at or above hot, a red/green blend between.
+// Built once, in quarter degrees, as packed 0xRRGGBB like NeoPixel Color().
+// Temperatures round up to the next quarter, so red is within 5/255 of the
+// exact blend. Entries must cover (hot - cold) * 4.
+#define TEMP_GRADIENT_STEPS_PER_DEG 4
+
+template <uint8_t Entries>
+class TempGradient {
+public:
+    TempGradient(float cold, float hot) : coldQ_(cold * TEMP_GRADIENT_STEPS_PER_DEG), hotQ_(hot * TEMP_GRADIENT_STEPS_PER_DEG) {
+        int32_t span = hotQ_ - coldQ_;
+        for (uint8_t i = 0; i < Entries; i++) {
+            int32_t q = i < span ? i : span;
+            uint8_t r = (q * 255 + span / 2) / span;
+            lut_[i] = (uint32_t)r << 16 | (uint32_t)(255 - r) << 8;
+        }
+    }
+
+    uint32_t color(float temp) const {
+        int32_t q = (int32_t)ceilf(temp * TEMP_GRADIENT_STEPS_PER_DEG);
+        if (q <= coldQ_) return 0x0000FF;
+        if (q >= hotQ_) return 0xFF0000;
+        int32_t i = q - coldQ_;
+        return lut_[i < Entries ? i : Entries - 1];
+    }
+
+private:
+    int32_t coldQ_;
+    int32_t hotQ_;
+    uint32_t lut_[Entries];
+};
@@ -0,0 +1,318 @@
+/*
+ * Smart Car Dashboard - Telemetry History
+ * Author: Stromlabs - Pavan Kalsariya
+ * Date: July 2025
+ * Description: Fixed-size in-RAM time series for Car 1. Every sensor sample is
+ * rolled up into min/max/mean buckets at 1 s, 10 s and 1 min resolution, each
+ * kept in its own ring. All storage is static, so the footprint is known at
+ * compile time (see TelemetryHistory::kBytes).
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+// --- CHANNELS ---
+// Values are stored as int16 in tenths (21.5 C -> 215, 999 cm -> 9990)
+enum HistoryChannel : uint8_t {
+    HIST_TEMP,
+    HIST_HUMIDITY,
+    HIST_FRONT_DIST,
+    HIST_BACK_DIST,
+    HIST_SPEED,
+    HIST_DIRECTION,
+    HIST_CHANNELS
+};
+
+#define HIST_SCALE 10
+
+static const char *const HIST_CHANNEL_NAMES[HIST_CHANNELS] = {
+    "temp", "humidity", "frontDist", "backDist", "speed", "direction"
+};
+
+struct HistoryBucket {
+    uint32_t t;                      // Bucket start, seconds since boot
+    int16_t min[HIST_CHANNELS];
+    int16_t max[HIST_CHANNELS];
+    int16_t mean[HIST_CHANNELS];
+};
+
+// Readers (web server, async_tcp task) and the writer (loop task) share this
+static portMUX_TYPE historyMux = portMUX_INITIALIZER_UNLOCKED;
+
+// --- ONE RESOLUTION ---
+class HistoryRing {
+public:
+    HistoryRing(HistoryBucket *storage, uint16_t capacity, uint16_t resolution)
+        : ring_(storage), capacity_(capacity), resolution_(resolution) {}
+
+    uint16_t resolution() const { return resolution_; }
+
+    void add(uint32_t second, const int16_t values[HIST_CHANNELS]) {
+        uint32_t bucketStart = second - (second % resolution_);
+        if (count_ > 0 && bucketStart != current_.t) flush();
+
+        if (count_ == 0) {
+            current_.t = bucketStart;
+            for (uint8_t c = 0; c < HIST_CHANNELS; c++) {
+                current_.min[c] = values[c];
+                current_.max[c] = values[c];
+                sum_[c] = 0;
+            }
+        }
+
+        for (uint8_t c = 0; c < HIST_CHANNELS; c++) {
+            int16_t v = values[c];
+            if (c == HIST_DIRECTION) {
+                // Direction is unwrapped around the first sample of the bucket
+                // so 359 and 1 average to 0, not 180
+                if (count_ == 0) firstDirection_ = v;
+                else v = firstDirection_ + wrapDelta(v - firstDirection_);
+            }
+
+            if (v < current_.min[c]) current_.min[c] = v;
+            if (v > current_.max[c]) current_.max[c] = v;
+            sum_[c] += v;
+        }
+        count_++;
+    }
+
+    // Number of finished buckets currently held
+    uint16_t size() const {
+        return total_ < capacity_ ? total_ : capacity_;
+    }
+
+    // Copy the finished bucket with sequence number seq. Returns false if it
+    // has been overwritten since the caller read span().
+    bool get(uint32_t seq, HistoryBucket &out) const {
+        bool ok;
+        portENTER_CRITICAL(&historyMux);
+        ok = seq < total_ && total_ - seq <= capacity_;
+        if (ok) out = ring_[seq % capacity_];
+        portEXIT_CRITICAL(&historyMux);
+        return ok;
+    }
+
+    // Sequence numbers of the oldest and one-past-newest finished buckets
+    void span(uint32_t &first, uint32_t &end) const {
+        portENTER_CRITICAL(&historyMux);
+        end = total_;
+        first = total_ > capacity_ ? total_ - capacity_ : 0;
+        portEXIT_CRITICAL(&historyMux);
+    }
+
+private:
+    static int16_t wrapDelta(int16_t d) {
+        const int16_t full = 360 * HIST_SCALE;
+        while (d >= full / 2) d -= full;
+        while (d < -full / 2) d += full;
+        return d;
+    }
+
+    void flush() {
+        for (uint8_t c = 0; c < HIST_CHANNELS; c++) {
+            current_.mean[c] = sum_[c] / (int32_t)count_;
+        }
+        // Fold the direction stats back into 0..3600
+        const int16_t full = 360 * HIST_SCALE;
+        current_.mean[HIST_DIRECTION] = (current_.mean[HIST_DIRECTION] % full + full) % full;
+        current_.min[HIST_DIRECTION] = (current_.min[HIST_DIRECTION] % full + full) % full;
+        current_.max[HIST_DIRECTION] = (current_.max[HIST_DIRECTION] % full + full) % full;
+
+        portENTER_CRITICAL(&historyMux);
+        ring_[total_ % capacity_] = current_;
+        total_++;
+        portEXIT_CRITICAL(&historyMux);
+        count_ = 0;
+    }
+
+    HistoryBucket *ring_;
+    uint16_t capacity_;
+    uint16_t resolution_;
+    uint32_t total_ = 0;
+
+    // Bucket being filled; only touched by the writer
+    HistoryBucket current_;
+    int32_t sum_[HIST_CHANNELS];
+    int16_t firstDirection_ = 0;
+    uint16_t count_ = 0;
+};
+
+// Ring with its storage sized at compile time
+template <uint16_t Resolution, uint16_t Capacity>
+class HistoryTier : public HistoryRing {
+public:
+    HistoryTier() : HistoryRing(storage_, Capacity, Resolution) {}
+    static const uint16_t capacity = Capacity;
+
+private:
+    HistoryBucket storage_[Capacity];
+};
+
+// --- ALL RESOLUTIONS ---
+class TelemetryHistory {
+public:
+    HistoryTier<1, 180> seconds;     // Last 3 minutes
+    HistoryTier<10, 360> tens;       // Last hour
+    HistoryTier<60, 240> minutes;    // Last 4 hours
+
+    static const size_t kBytes =
+        (decltype(seconds)::capacity + decltype(tens)::capacity + decltype(minutes)::capacity) * sizeof(HistoryBucket);
+
+    void record(unsigned long nowMs, float temp, float humidity, float frontDist,
+                float backDist, float speed, float direction) {
+        int16_t v[HIST_CHANNELS];
+        v[HIST_TEMP] = toFixed(temp);
+        v[HIST_HUMIDITY] = toFixed(humidity);
+        v[HIST_FRONT_DIST] = toFixed(frontDist);
+        v[HIST_BACK_DIST] = toFixed(backDist);
+        v[HIST_SPEED] = toFixed(speed);
+        v[HIST_DIRECTION] = toFixed(direction);
+
+        uint32_t second = nowMs / 1000;
+        seconds.add(second, v);
+        tens.add(second, v);
+        minutes.add(second, v);
+    }
+
+    // Ring for a given resolution in seconds, or NULL if there is none
+    const HistoryRing *tier(uint16_t resolution) const {
+        if (resolution == seconds.resolution()) return &seconds;
+        if (resolution == tens.resolution()) return &tens;
+        if (resolution == minutes.resolution()) return &minutes;
+        return NULL;
+    }
+
+private:
+    static int16_t toFixed(float value) {
+        float scaled = value * HIST_SCALE;
+        if (scaled > 32767) return 32767;
+        if (scaled < -32768) return -32768;
+        return (int16_t)lroundf(scaled);
+    }
+};
+
+// --- COMPACT REPLAY FRAME ---
+// Binary WebSocket frame sent to new dashboard clients (little-endian):
+//   u8 'H', u8 version, u16 resolution in s, u8 channels, u8 reserved,
+//   u16 rows, u32 now in s since boot,
+//   then per row, oldest first: u16 age in s before now, i16 mean[channels]
+#define HIST_FRAME_HEADER 12
+#define HIST_FRAME_ROW (2 + 2 * HIST_CHANNELS)
+
+inline size_t historyFrameSize(const HistoryRing &ring) {
+    return HIST_FRAME_HEADER + (size_t)ring.size() * HIST_FRAME_ROW;
+}
+
+inline size_t encodeHistoryFrame(const HistoryRing &ring, uint32_t nowSec, uint8_t *out, size_t maxLen) {
+    if (maxLen < HIST_FRAME_HEADER) return 0;
+
+    uint32_t seq, end;
+    ring.span(seq, end);
+
+    size_t pos = HIST_FRAME_HEADER;
+    uint16_t rows = 0;
+    HistoryBucket bucket;
+    for (; seq < end && pos + HIST_FRAME_ROW <= maxLen; seq++) {
+        if (!ring.get(seq, bucket)) continue;
+        uint32_t age = nowSec > bucket.t ? nowSec - bucket.t : 0;
+        if (age > 0xFFFF) continue;
+
+        out[pos++] = age & 0xFF;
+        out[pos++] = age >> 8;
+        for (uint8_t c = 0; c < HIST_CHANNELS; c++) {
+            out[pos++] = (uint16_t)bucket.mean[c] & 0xFF;
+            out[pos++] = (uint16_t)bucket.mean[c] >> 8;
+        }
+        rows++;
+    }
+
+    out[0] = 'H';
+    out[1] = 1;
+    out[2] = ring.resolution() & 0xFF;
+    out[3] = ring.resolution() >> 8;
+    out[4] = HIST_CHANNELS;
+    out[5] = 0;
+    out[6] = rows & 0xFF;
+    out[7] = rows >> 8;
+    out[8] = nowSec & 0xFF;
+    out[9] = (nowSec >> 8) & 0xFF;
+    out[10] = (nowSec >> 16) & 0xFF;
+    out[11] = (nowSec >> 24) & 0xFF;
+    return pos;
+}
+
+// --- RANGE QUERY ---
+// Streams the buckets of one ring with from <= t <= to as JSON, one row at a
+// time, for use as a chunked HTTP response filler:
+//   {"res":10,"now":1234,"scale":10,"fields":[...],"stats":["min","max","mean"],
+//    "rows":[[t,min,max,mean,min,max,mean,...],...]}
+class HistoryJsonReader {
+public:
+    HistoryJsonReader(const HistoryRing &ring, uint32_t from, uint32_t to, uint32_t nowSec)
+        : ring_(ring), from_(from), to_(to), now_(nowSec) {
+        ring_.span(seq_, end_);
+    }
+
+    // Fill up to maxLen bytes; returns 0 once the document is complete
+    size_t read(uint8_t *out, size_t maxLen) {
+        size_t written = 0;
+        while (written < maxLen) {
+            if (pos_ == len_ && !nextLine()) break;
+            size_t n = len_ - pos_;
+            if (n > maxLen - written) n = maxLen - written;
+            memcpy(out + written, line_ + pos_, n);
+            pos_ += n;
+            written += n;
+        }
+        return written;
+    }
+
+private:
+    // Format the next piece of the document into line_
+    bool nextLine() {
+        pos_ = 0;
+        len_ = 0;
+        if (stage_ == 0) {
+            len_ = snprintf(line_, sizeof(line_),
+                "{\"res\":%u,\"now\":%lu,\"scale\":%d,\"fields\":[", ring_.resolution(),
+                (unsigned long)now_, HIST_SCALE);
+            for (uint8_t c = 0; c < HIST_CHANNELS; c++) {
+                len_ += snprintf(line_ + len_, sizeof(line_) - len_, "%s\"%s\"",
+                    c ? "," : "", HIST_CHANNEL_NAMES[c]);
+            }
+            len_ += snprintf(line_ + len_, sizeof(line_) - len_, "],\"stats\":[\"min\",\"max\",\"mean\"],\"rows\":[");
+            stage_ = 1;
+            return true;
+        }
+
+        if (stage_ == 1) {
+            HistoryBucket b;
+            while (seq_ < end_) {
+                if (!ring_.get(seq_++, b)) continue;
+                if (b.t < from_ || b.t > to_) continue;
+
+                len_ = snprintf(line_, sizeof(line_), "%s[%lu", rows_++ ? "," : "", (unsigned long)b.t);
+                for (uint8_t c = 0; c < HIST_CHANNELS; c++) {
+                    len_ += snprintf(line_ + len_, sizeof(line_) - len_, ",%d,%d,%d",
+                        b.min[c], b.max[c], b.mean[c]);
+                }
+                line_[len_++] = ']';
+                return true;
+            }
+            len_ = snprintf(line_, sizeof(line_), "]}");
+            stage_ = 2;
+            return true;
+        }
+
+        return false;
+    }
+
+    const HistoryRing &ring_;
+    uint32_t from_, to_, now_;
+    uint32_t seq_ = 0, end_ = 0;
+    uint32_t rows_ = 0;
+    uint8_t stage_ = 0;
+    char line_[224];
+    size_t len_ = 0, pos_ = 0;
+};
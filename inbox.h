@@ -0,0 +1,88 @@
+/*
+ * Smart Car Dashboard - Loop Inbox
+ * Author: Stromlabs - Pavan Kalsariya
+ * Date: July 2025
+ * Description: Hands work from other tasks (async_tcp: dashboard commands,
+ * the other car's /update) to the loop task, which owns the car state. A
+ * sender posts a small copy of what it received and wakes the loop; the
+ * loop takes the posts in order and applies them between its jobs, so a
+ * command and a button press never change the indicators at the same time,
+ * and a recording logs inputs in the order the loop applied them. A post
+ * that finds the inbox full is refused and counted.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <atomic>
+#include "jsonwriter.h"
+
+typedef void (*InboxWake)();    // Wakes the loop, from any task
+
+// T is copied in and out, so keep it small; Size a power of two
+template <typename T, uint16_t Size>
+class Inbox {
+public:
+    explicit Inbox(InboxWake wake = NULL) : wake_(wake) {
+        static_assert((Size & (Size - 1)) == 0, "Size must be a power of two");
+        for (uint32_t i = 0; i < Size; i++) slots_[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    // --- POSTING (any task) ---
+    // Returns false if the inbox is full; the item is dropped
+    bool post(const T &item) {
+        // Same bounded multi-producer queue as the event bus: claim a
+        // position with a CAS, fill the slot, publish it by its sequence
+        uint32_t pos = head_.load(std::memory_order_relaxed);
+        Slot *slot;
+        for (;;) {
+            slot = &slots_[pos & (Size - 1)];
+            int32_t diff = (int32_t)(slot->seq.load(std::memory_order_acquire) - pos);
+            if (diff == 0) {
+                if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            } else {
+                pos = head_.load(std::memory_order_relaxed);
+            }
+        }
+
+        slot->item = item;
+        slot->seq.store(pos + 1, std::memory_order_release);
+        posted_.fetch_add(1, std::memory_order_relaxed);
+        if (wake_) wake_();
+        return true;
+    }
+
+    // --- TAKING (loop task only) ---
+    bool take(T &item) {
+        Slot *slot = &slots_[tail_ & (Size - 1)];
+        if (slot->seq.load(std::memory_order_acquire) != tail_ + 1) return false;
+        item = slot->item;
+        slot->seq.store(tail_ + Size, std::memory_order_release);
+        tail_++;
+        return true;
+    }
+
+    uint32_t posted() const { return posted_.load(std::memory_order_relaxed); }
+    uint32_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+    // "<key>":{"posted":..,"dropped":..}
+    void write(JsonWriter &json, const char *key) const {
+        json.beginObject(key).add("posted", posted()).add("dropped", dropped()).endObject();
+    }
+
+private:
+    struct Slot {
+        std::atomic<uint32_t> seq;
+        T item;
+    };
+
+    InboxWake wake_;
+    Slot slots_[Size];
+    std::atomic<uint32_t> head_{0};
+    uint32_t tail_ = 0;                 // Loop task only
+    std::atomic<uint32_t> posted_{0};
+    std::atomic<uint32_t> dropped_{0};
+};
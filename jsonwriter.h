@@ -0,0 +1,234 @@
+/*
+ * Smart Car Dashboard - JSON Writer
+ * Author: Stromlabs - Pavan Kalsariya
+ * Date: July 2025
+ * Description: Append-only JSON serializer that writes straight into a
+ * caller-provided buffer. No heap, no String, no intermediate document, so
+ * the 100 ms telemetry push and the API responses don't fragment the heap
+ * over a long drive. Output that doesn't fit is cut off and flagged; cut-off
+ * output is invalid JSON, so senders check overflowed() and drop it. A
+ * report with no fixed bound streams instead: given a sink, the writer
+ * hands the buffer on whenever it fills, and never overflows.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+// Takes each full buffer, and what's left at flush()
+typedef void (*JsonSink)(void *ctx, const char *data, size_t len);
+
+class JsonWriter {
+public:
+    JsonWriter(char *buffer, size_t size) : buf_(buffer), size_(size) {
+        if (size_ > 0) buf_[0] = '\0';
+    }
+
+    const char *c_str() const { return buf_; }
+    size_t length() const { return len_; }
+    bool overflowed() const { return overflow_; }
+    size_t capacity() const { return size_; }
+
+    // Bytes written since the start, handed on or not
+    size_t written() const { return flushed_ + len_; }
+
+    void setSink(JsonSink sink, void *ctx) {
+        sink_ = sink;
+        sinkCtx_ = ctx;
+    }
+
+    // Hands what's buffered to the sink; call once the output is complete
+    void flush() {
+        if (!sink_ || len_ == 0) return;
+        sink_(sinkCtx_, buf_, len_);
+        flushed_ += len_;
+        len_ = 0;
+        buf_[0] = '\0';
+    }
+
+    // For sizing checks on the host: every integer member is written at its
+    // widest 32-bit width (zero-padded, so not valid JSON), and one pass
+    // gives the longest the output can get for the same strings and arrays
+    void setWidestNumbers(bool widest) { widest_ = widest; }
+
+    // Start over with the same buffer
+    void clear() {
+        len_ = 0;
+        flushed_ = 0;
+        overflow_ = false;
+        comma_ = false;
+        if (size_ > 0) buf_[0] = '\0';
+    }
+
+    // --- STRUCTURE ---
+    JsonWriter &beginObject(const char *key = NULL) { open(key, '{'); return *this; }
+    JsonWriter &endObject() { close('}'); return *this; }
+    JsonWriter &beginArray(const char *key = NULL) { open(key, '['); return *this; }
+    JsonWriter &endArray() { close(']'); return *this; }
+
+    // --- MEMBERS (key may be NULL inside an array) ---
+    JsonWriter &add(const char *key, bool value) {
+        member(key);
+        put(value ? "true" : "false");
+        return *this;
+    }
+
+    JsonWriter &add(const char *key, int value) { return add(key, (long)value); }
+    JsonWriter &add(const char *key, unsigned int value) { return add(key, (unsigned long)value); }
+
+    JsonWriter &add(const char *key, long value) {
+        member(key);
+        if (value < 0 || widest_) {
+            put('-');
+            putInteger(value < 0 ? 0UL - (unsigned long)value : value);
+        } else {
+            putInteger(value);
+        }
+        return *this;
+    }
+
+    JsonWriter &add(const char *key, unsigned long value) {
+        member(key);
+        putInteger(value);
+        return *this;
+    }
+
+    // Fixed number of decimals; NaN and infinity become null
+    JsonWriter &add(const char *key, float value, uint8_t decimals = 2) {
+        member(key);
+        if (isnan(value) || isinf(value)) {
+            put("null");
+            return *this;
+        }
+
+        static const uint32_t POW10[] = {1, 10, 100, 1000, 10000, 100000, 1000000};
+        if (decimals > 6) decimals = 6;
+        float scaled = fabsf(value) * POW10[decimals] + 0.5f;
+        if (scaled >= 4.0e9f) {
+            // Too large for the integer path; nothing we send gets here
+            put(value < 0 ? "-4e9" : "4e9");
+            return *this;
+        }
+
+        uint32_t fixed = (uint32_t)scaled;
+        if (value < 0 && fixed > 0) put('-');
+        putUnsigned(fixed / POW10[decimals]);
+        if (decimals > 0) {
+            put('.');
+            uint32_t frac = fixed % POW10[decimals];
+            for (uint32_t p = POW10[decimals - 1]; p > 0; p /= 10) {
+                put('0' + (frac / p) % 10);
+            }
+        }
+        return *this;
+    }
+
+    JsonWriter &add(const char *key, double value, uint8_t decimals = 2) {
+        return add(key, (float)value, decimals);
+    }
+
+    JsonWriter &add(const char *key, const char *value) {
+        member(key);
+        if (!value) {
+            put("null");
+            return *this;
+        }
+        putString(value);
+        return *this;
+    }
+
+    // Pre-serialized JSON value, copied as is
+    JsonWriter &addRaw(const char *key, const char *json) {
+        member(key);
+        put(json);
+        return *this;
+    }
+
+private:
+    void open(const char *key, char bracket) {
+        member(key);
+        put(bracket);
+        comma_ = false;
+    }
+
+    void close(char bracket) {
+        put(bracket);
+        comma_ = true;
+    }
+
+    void member(const char *key) {
+        if (comma_) put(',');
+        comma_ = true;
+        if (key) {
+            putString(key);
+            put(':');
+        }
+    }
+
+    void putString(const char *s) {
+        static const char HEX_DIGITS[] = "0123456789abcdef";
+        put('"');
+        for (; *s; s++) {
+            char c = *s;
+            if (c == '"' || c == '\\') {
+                put('\\');
+                put(c);
+            } else if ((uint8_t)c < 0x20) {
+                put("\\u00");
+                put(HEX_DIGITS[(c >> 4) & 0xF]);
+                put(HEX_DIGITS[c & 0xF]);
+            } else {
+                put(c);
+            }
+        }
+        put('"');
+    }
+
+    void putUnsigned(unsigned long value, uint8_t minDigits = 1) {
+        char digits[20];
+        uint8_t n = 0;
+        do {
+            digits[n++] = '0' + value % 10;
+            value /= 10;
+        } while (value > 0);
+        while (n < minDigits) digits[n++] = '0';
+        while (n > 0) put(digits[--n]);
+    }
+
+    void putInteger(unsigned long value) { putUnsigned(value, widest_ ? 10 : 1); }     // 4294967295
+
+    void put(const char *s) {
+        while (*s) put(*s++);
+    }
+
+    // Always leaves room for the terminator
+    void put(char c) {
+        if (len_ + 1 >= size_) flush();
+        if (len_ + 1 >= size_) {
+            overflow_ = true;
+            return;
+        }
+        buf_[len_++] = c;
+        buf_[len_] = '\0';
+    }
+
+    char *buf_;
+    size_t size_;
+    size_t len_ = 0;
+    size_t flushed_ = 0;
+    JsonSink sink_ = NULL;
+    void *sinkCtx_ = NULL;
+    bool overflow_ = false;
+    bool comma_ = false;
+    bool widest_ = false;
+};
+
+// Writer with its storage sized at compile time, usually on the stack
+template <size_t Size>
+class JsonBuffer : public JsonWriter {
+public:
+    JsonBuffer() : JsonWriter(storage_, Size) {}
+
+private:
+    char storage_[Size];
+};
@@ -0,0 +1,222 @@
+/*
+ * Smart Car Dashboard - Log Format
+ * Author: Stromlabs - Pavan Kalsariya
+ * Date: July 2025
+ * Description: Binary log record layout, the serial frame that carries it and
+ * the formatter that turns a record back into text. Shared by the firmware
+ * (logger.h) and the host decoder (tools/log_decode.cpp), so it only needs
+ * the C library.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include "logmessages.h"
+
+// --- LEVELS AND MODULES ---
+enum LogLevel : uint8_t {
+    LOG_ERROR,
+    LOG_WARN,
+    LOG_INFO,
+    LOG_DEBUG
+};
+
+enum LogModule : uint8_t {
+    LOG_SYS,
+    LOG_SENSOR,
+    LOG_INDICATOR,
+    LOG_LINK,
+    LOG_WEB,
+    LOG_MODULES
+};
+
+static const char *const LOG_LEVEL_TAGS = "EWID";
+static const char *const LOG_MODULE_NAMES[LOG_MODULES] = {
+    "sys", "sensor", "indicator", "link", "web"
+};
+
+// --- MESSAGE TABLE ---
+enum LogMsgId : uint16_t {
+#define LOG_MSG_ENUM(id, module, level, format) id,
+    LOG_MESSAGES(LOG_MSG_ENUM)
+#undef LOG_MSG_ENUM
+    LOG_MSG_COUNT
+};
+
+struct LogMessageInfo {
+    uint8_t module;
+    uint8_t level;
+    const char *format;
+};
+
+static constexpr LogMessageInfo LOG_MESSAGE_INFO[LOG_MSG_COUNT] = {
+#define LOG_MSG_INFO(id, module, level, format) {module, level, format},
+    LOG_MESSAGES(LOG_MSG_INFO)
+#undef LOG_MSG_INFO
+};
+
+// FNV-1a over every format string; logged at start so the decoder can tell
+// when a capture came from firmware with a different message table
+inline uint32_t logTableHash() {
+    uint32_t hash = 2166136261u;
+    for (uint16_t i = 0; i < LOG_MSG_COUNT; i++) {
+        for (const char *p = LOG_MESSAGE_INFO[i].format; *p; p++) {
+            hash = (hash ^ (uint8_t)*p) * 16777619u;
+        }
+        hash = (hash ^ 0xFF) * 16777619u;
+    }
+    return hash;
+}
+
+// --- RECORD ---
+#define LOG_MAX_ARGS 4
+
+struct LogRecord {
+    uint32_t timeMs;
+    uint16_t id;
+    uint8_t argc;
+    uint8_t reserved;
+    uint32_t args[LOG_MAX_ARGS];
+};
+
+// --- SERIAL FRAME ---
+// Binary output (little-endian):
+//   u8 0xA5, u8 0x5A, u32 time in ms, u16 message ID, u8 argc,
+//   u32 args[argc], u8 checksum (sum of the bytes after the sync pair)
+#define LOG_FRAME_SYNC0 0xA5
+#define LOG_FRAME_SYNC1 0x5A
+#define LOG_FRAME_MAX (2 + 7 + 4 * LOG_MAX_ARGS + 1)
+
+inline size_t encodeLogFrame(const LogRecord &rec, uint8_t *out) {
+    size_t pos = 0;
+    out[pos++] = LOG_FRAME_SYNC0;
+    out[pos++] = LOG_FRAME_SYNC1;
+    for (uint8_t i = 0; i < 4; i++) out[pos++] = rec.timeMs >> (8 * i);
+    out[pos++] = rec.id & 0xFF;
+    out[pos++] = rec.id >> 8;
+    out[pos++] = rec.argc;
+    for (uint8_t a = 0; a < rec.argc; a++) {
+        for (uint8_t i = 0; i < 4; i++) out[pos++] = rec.args[a] >> (8 * i);
+    }
+
+    uint8_t sum = 0;
+    for (size_t i = 2; i < pos; i++) sum += out[i];
+    out[pos++] = sum;
+    return pos;
+}
+
+// Decode one frame starting at in[0] (the first sync byte). Returns the frame
+// length, 0 if more bytes are needed, or -1 if this isn't a valid frame.
+inline int decodeLogFrame(const uint8_t *in, size_t len, LogRecord &rec) {
+    if (len < 2) return 0;
+    if (in[0] != LOG_FRAME_SYNC0 || in[1] != LOG_FRAME_SYNC1) return -1;
+    if (len < 9) return 0;
+
+    uint8_t argc = in[8];
+    if (argc > LOG_MAX_ARGS) return -1;
+    size_t frameLen = 9 + 4 * argc + 1;
+    if (len < frameLen) return 0;
+
+    uint8_t sum = 0;
+    for (size_t i = 2; i < frameLen - 1; i++) sum += in[i];
+    if (sum != in[frameLen - 1]) return -1;
+
+    rec.timeMs = in[2] | in[3] << 8 | in[4] << 16 | (uint32_t)in[5] << 24;
+    rec.id = in[6] | in[7] << 8;
+    rec.argc = argc;
+    rec.reserved = 0;
+    for (uint8_t a = 0; a < argc; a++) {
+        const uint8_t *p = in + 9 + 4 * a;
+        rec.args[a] = p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24;
+    }
+    return frameLen;
+}
+
+// --- TEXT ---
+// Apply the message's format to the record's arguments. Missing arguments
+// print as '?'; unknown IDs print the raw words.
+inline size_t formatLogMessage(const LogRecord &rec, char *out, size_t size) {
+    if (size == 0) return 0;
+    size_t len = 0;
+    // snprintf returns the untruncated length; clamp to what was written
+    auto append = [&](int n) {
+        if (n < 0) return;
+        len += n;
+        if (len >= size) len = size - 1;
+    };
+
+    if (rec.id >= LOG_MSG_COUNT) {
+        append(snprintf(out, size, "unknown message %u", rec.id));
+        for (uint8_t a = 0; a < rec.argc && len < size; a++) {
+            append(snprintf(out + len, size - len, " %08lx", (unsigned long)rec.args[a]));
+        }
+        return len;
+    }
+
+    const char *f = LOG_MESSAGE_INFO[rec.id].format;
+    uint8_t arg = 0;
+    while (*f && len + 1 < size) {
+        if (*f != '%') {
+            out[len++] = *f++;
+            continue;
+        }
+        if (f[1] == '%') {
+            out[len++] = '%';
+            f += 2;
+            continue;
+        }
+
+        // Copy one conversion spec, e.g. "%08x" or "%.1f"
+        char spec[12];
+        uint8_t n = 0;
+        spec[n++] = *f++;
+        while (*f && strchr("-+ #0123456789.", *f) && n < sizeof(spec) - 2) spec[n++] = *f++;
+        char conv = *f ? *f++ : 'd';
+        spec[n++] = conv;
+        spec[n] = '\0';
+
+        if (arg >= rec.argc) {
+            out[len++] = '?';
+            continue;
+        }
+        uint32_t word = rec.args[arg++];
+        size_t room = size - len;
+        switch (conv) {
+            case 'd': case 'i':
+                append(snprintf(out + len, room, spec, (int)(int32_t)word));
+                break;
+            case 'f': case 'e': case 'g': {
+                float value;
+                memcpy(&value, &word, sizeof(value));
+                append(snprintf(out + len, room, spec, (double)value));
+                break;
+            }
+            case 'b':
+                append(snprintf(out + len, room, "%s", word ? "ON" : "OFF"));
+                break;
+            case 's':
+                // Records can't carry strings; never pass the word as a pointer
+                append(snprintf(out + len, room, "?"));
+                break;
+            default:
+                append(snprintf(out + len, room, spec, (unsigned)word));
+                break;
+        }
+    }
+    out[len] = '\0';
+    return len;
+}
+
+// "[  12.345] I indicator  Left indicator: ON"
+inline size_t formatLogLine(const LogRecord &rec, char *out, size_t size) {
+    char level = '?';
+    const char *module = "?";
+    if (rec.id < LOG_MSG_COUNT) {
+        level = LOG_LEVEL_TAGS[LOG_MESSAGE_INFO[rec.id].level];
+        module = LOG_MODULE_NAMES[LOG_MESSAGE_INFO[rec.id].module];
+    }
+    int n = snprintf(out, size, "[%5lu.%03lu] %c %-9s ", (unsigned long)(rec.timeMs / 1000),
+                     (unsigned long)(rec.timeMs % 1000), level, module);
+    if (n < 0 || (size_t)n >= size) return size ? size - 1 : 0;
+    return n + formatLogMessage(rec, out + n, size - n);
+}
@@ -0,0 +1,248 @@
+/*
+ * Smart Car Dashboard - Logger
+ * Author: Stromlabs - Pavan Kalsariya
+ * Date: July 2025
+ * Description: Deferred structured logging. LOG() copies a message ID and its
+ * arguments into a lock-free ring and returns; a low-priority task on core 0
+ * formats them and writes them to Serial, either as text or as binary frames
+ * for tools/log_decode. Callers never allocate or wait on the UART. When the
+ * ring is full the record is dropped and counted. LOG() is safe from ISRs and
+ * from other tasks (ESP-NOW callback, async_tcp).
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <atomic>
+#include "logformat.h"
+
+// Messages above this level are compiled out
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL LOG_DEBUG
+#endif
+
+// Records held while the drain task catches up (power of two, 28 bytes each)
+#ifndef LOG_RING_SIZE
+#define LOG_RING_SIZE 128
+#endif
+
+#define LOG_DRAIN_INTERVAL_MS 20
+
+enum LogOutput : uint8_t {
+    LOG_OUT_TEXT,
+    LOG_OUT_BINARY
+};
+
+class Logger {
+public:
+    Logger() {
+        static_assert((LOG_RING_SIZE & (LOG_RING_SIZE - 1)) == 0, "LOG_RING_SIZE must be a power of two");
+        for (uint32_t i = 0; i < LOG_RING_SIZE; i++) slots_[i].seq.store(i, std::memory_order_relaxed);
+        for (uint8_t m = 0; m < LOG_MODULES; m++) levels_[m] = LOG_INFO;
+    }
+
+    // Start draining to out. Records logged earlier are kept (up to the ring
+    // size) and written once the task runs.
+    void begin(Print &out, LogOutput mode = LOG_OUT_TEXT) {
+        out_ = &out;
+        mode_ = mode;
+        startPending_ = true;
+        if (!task_) xTaskCreatePinnedToCore(drainTask, "log", 4096, this, 1, &task_, 0);
+    }
+
+    // --- FILTERS ---
+    void setLevel(uint8_t module, LogLevel level) {
+        if (module < LOG_MODULES) levels_[module] = level;
+    }
+
+    void setAllLevels(LogLevel level) {
+        for (uint8_t m = 0; m < LOG_MODULES; m++) levels_[m] = level;
+    }
+
+    LogLevel level(uint8_t module) const { return levels_[module]; }
+
+    // Switching to binary re-sends the start marker so the decoder can sync
+    void setOutput(LogOutput mode) {
+        mode_ = mode;
+        startPending_ = true;
+    }
+
+    LogOutput output() const { return mode_; }
+    uint32_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+    uint32_t written() const { return written_; }
+
+    // --- LOGGING ---
+    template <typename... Args>
+    void write(LogMsgId id, Args... args) {
+        static_assert(sizeof...(Args) <= LOG_MAX_ARGS, "a log record holds at most 4 arguments");
+        const LogMessageInfo &info = LOG_MESSAGE_INFO[id];
+        if (info.level > LOG_COMPILE_LEVEL || info.level > levels_[info.module]) return;
+
+        uint32_t words[] = {0, toWord(args)...};    // Leading 0 so the array is never empty
+        push(id, words + 1, sizeof...(Args));
+    }
+
+private:
+    struct Slot {
+        std::atomic<uint32_t> seq;
+        LogRecord rec;
+    };
+
+    static uint32_t toWord(float value) {
+        uint32_t word;
+        memcpy(&word, &value, sizeof(word));
+        return word;
+    }
+
+    static uint32_t toWord(double value) { return toWord((float)value); }
+
+    template <typename T>
+    static uint32_t toWord(T value) { return (uint32_t)value; }
+
+    // Bounded multi-producer queue: a producer claims a position with a CAS,
+    // fills the slot, then publishes it by advancing the slot's sequence.
+    // Each slot's sequence says whose turn it is, so no locks are needed.
+    bool push(LogMsgId id, const uint32_t *args, uint8_t argc) {
+        uint32_t pos = head_.load(std::memory_order_relaxed);
+        Slot *slot;
+        for (;;) {
+            slot = &slots_[pos & (LOG_RING_SIZE - 1)];
+            int32_t diff = (int32_t)(slot->seq.load(std::memory_order_acquire) - pos);
+            if (diff == 0) {
+                if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            } else {
+                pos = head_.load(std::memory_order_relaxed);
+            }
+        }
+
+        slot->rec.timeMs = millis();
+        slot->rec.id = id;
+        slot->rec.argc = argc;
+        slot->rec.reserved = 0;
+        memcpy(slot->rec.args, args, argc * sizeof(uint32_t));
+        slot->seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Single consumer: only the drain task calls this
+    bool pop(LogRecord &rec) {
+        Slot *slot = &slots_[tail_ & (LOG_RING_SIZE - 1)];
+        if (slot->seq.load(std::memory_order_acquire) != tail_ + 1) return false;
+        rec = slot->rec;
+        slot->seq.store(tail_ + LOG_RING_SIZE, std::memory_order_release);
+        tail_++;
+        return true;
+    }
+
+    static void drainTask(void *arg) {
+        Logger *self = (Logger *)arg;
+        for (;;) {
+            self->drain();
+            vTaskDelay(pdMS_TO_TICKS(LOG_DRAIN_INTERVAL_MS));
+        }
+    }
+
+    void drain() {
+        if (startPending_) {
+            startPending_ = false;
+            emitNow(MSG_LOG_START, logTableHash());
+        }
+
+        uint32_t dropped = dropped_.load(std::memory_order_relaxed);
+        if (dropped != reportedDropped_) {
+            emitNow(MSG_LOG_DROPPED, dropped - reportedDropped_);
+            reportedDropped_ = dropped;
+        }
+
+        LogRecord rec;
+        while (pop(rec)) emit(rec);
+    }
+
+    // Drain-task messages skip the ring so they can't be dropped themselves
+    void emitNow(LogMsgId id, uint32_t arg) {
+        LogRecord rec;
+        rec.timeMs = millis();
+        rec.id = id;
+        rec.argc = 1;
+        rec.reserved = 0;
+        rec.args[0] = arg;
+        emit(rec);
+    }
+
+    void emit(const LogRecord &rec) {
+        if (mode_ == LOG_OUT_BINARY) {
+            uint8_t frame[LOG_FRAME_MAX];
+            out_->write(frame, encodeLogFrame(rec, frame));
+        } else {
+            char line[160];
+            size_t len = formatLogLine(rec, line, sizeof(line) - 1);
+            line[len++] = '\n';
+            out_->write((const uint8_t *)line, len);
+        }
+        written_++;
+    }
+
+    Slot slots_[LOG_RING_SIZE];
+    std::atomic<uint32_t> head_{0};
+    uint32_t tail_ = 0;
+    std::atomic<uint32_t> dropped_{0};
+    uint32_t reportedDropped_ = 0;
+    uint32_t written_ = 0;
+
+    volatile LogLevel levels_[LOG_MODULES];
+    volatile LogOutput mode_ = LOG_OUT_TEXT;
+    volatile bool startPending_ = false;
+    Print *out_ = NULL;
+    TaskHandle_t task_ = NULL;
+};
+
+static Logger logger;
+
+#define LOG(id, ...) logger.write(id, ##__VA_ARGS__)
+
+// --- SERIAL COMMANDS ---
+// "log text" / "log binary"       output format
+// "log stats"                     records written and dropped
+// "log <module|all> <level>"      e.g. "log sensor debug", "log all warn"
+// Returns false if the command isn't a log command.
+inline bool handleLogCommand(const char *command, Print &out) {
+    if (strncmp(command, "log", 3) != 0 || (command[3] != ' ' && command[3] != '\0')) return false;
+    const char *arg = command[3] ? command + 4 : "";
+
+    if (strcmp(arg, "text") == 0) {
+        logger.setOutput(LOG_OUT_TEXT);
+    } else if (strcmp(arg, "binary") == 0) {
+        logger.setOutput(LOG_OUT_BINARY);
+    } else if (strcmp(arg, "stats") == 0) {
+        out.printf("Log: %lu written, %lu dropped\n", (unsigned long)logger.written(),
+                   (unsigned long)logger.dropped());
+    } else {
+        static const char *const LEVEL_NAMES[] = {"error", "warn", "info", "debug"};
+        char module[12];
+        char level[8];
+        if (sscanf(arg, "%11s %7s", module, level) != 2) {
+            out.println("Usage: log text|binary|stats|<module|all> <error|warn|info|debug>");
+            return true;
+        }
+
+        int levelIndex = -1;
+        for (uint8_t l = 0; l < 4; l++) {
+            if (strcmp(level, LEVEL_NAMES[l]) == 0) levelIndex = l;
+        }
+        int moduleIndex = -1;
+        for (uint8_t m = 0; m < LOG_MODULES; m++) {
+            if (strcmp(module, LOG_MODULE_NAMES[m]) == 0) moduleIndex = m;
+        }
+        if (levelIndex < 0 || (moduleIndex < 0 && strcmp(module, "all") != 0)) {
+            out.println("Unknown module or level");
+            return true;
+        }
+
+        if (moduleIndex < 0) logger.setAllLevels((LogLevel)levelIndex);
+        else logger.setLevel(moduleIndex, (LogLevel)levelIndex);
+    }
+    return true;
+}
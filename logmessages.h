@@ -0,0 +1,29 @@
+/*
+ * Smart Car Dashboard - Log Messages
+ * Author: Stromlabs - Pavan Kalsariya
+ * Date: July 2025
+ * Description: Every message the cars log, with its module, level and format.
+ * Records carry only the message ID and up to four 32-bit arguments; the
+ * format is applied later by the drain task or by tools/log_decode. Append
+ * new messages at the end so older captures still decode.
+ *
+ * Formats take printf conversions d i u x X c f e g (no length modifiers),
+ * %b for a bool shown as ON/OFF, and %% for a literal percent sign.
+ */
+
+#pragma once
+
+#define LOG_MESSAGES(X) \
+    X(MSG_LOG_START,          LOG_SYS,       LOG_INFO,  "Log started, message table %08x") \
+    X(MSG_LOG_DROPPED,        LOG_SYS,       LOG_WARN,  "Log: %u lines dropped") \
+    X(MSG_HEAP,               LOG_SYS,       LOG_INFO,  "Heap: free %u, largest block %u (lowest %u), min free %u") \
+    X(MSG_LEFT_INDICATOR,     LOG_INDICATOR, LOG_INFO,  "Left indicator: %b") \
+    X(MSG_RIGHT_INDICATOR,    LOG_INDICATOR, LOG_INFO,  "Right indicator: %b") \
+    X(MSG_ESPNOW_INDICATORS,  LOG_INDICATOR, LOG_DEBUG, "Received Car%u indicators: left %b, right %b") \
+    X(MSG_CAR2_FOUND,         LOG_LINK,      LOG_INFO,  "Car 2 found at: %u.%u.%u.%u") \
+    X(MSG_WS_CONNECT,         LOG_WEB,       LOG_INFO,  "WebSocket client %u connected") \
+    X(MSG_WS_DISCONNECT,      LOG_WEB,       LOG_INFO,  "WebSocket client %u disconnected") \
+    X(MSG_CLIMATE,            LOG_SENSOR,    LOG_DEBUG, "Temp: %.1f C, Humidity: %.1f%%") \
+    X(MSG_POWER_IDLE,         LOG_SYS,       LOG_INFO,  "Idle: CPU %u MHz, sensors every %u ms") \
+    X(MSG_POWER_ACTIVE,       LOG_SYS,       LOG_INFO,  "Active: CPU %u MHz") \
+    X(MSG_JSON_OVERFLOW,      LOG_WEB,       LOG_WARN,  "JSON didn't fit its %u-byte buffer, not sent")
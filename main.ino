@@ -1,12 +1,14 @@
 #include <WiFi.h>
 #include <AsyncTCP.h>
 #include <ESPAsyncWebServer.h>
-#include <ArduinoJson.h>
 #include <DHT.h>
 #include <Adafruit_NeoPixel.h>
 #include <Wire.h>
 #include <MPU6050.h>
 #include "web.h"
+#include "jsonwriter.h"
+#include "runtime.h"
+#include "logger.h"
 
 // WiFi credentials
 const char* ssid = "0000";
@@ -33,13 +35,15 @@ const char* password = "12121212";
 DHT dht(DHT_PIN, DHT_TYPE);
 Adafruit_NeoPixel strip(NEOPIXEL_COUNT, NEOPIXEL_PIN, NEO_GRB + NEO_KHZ800);
 AsyncWebServer server(80);
+AsyncEventSource events("/api/events");
 MPU6050 mpu;
+HeapMonitor heapMonitor;
 
 // Global variables
 volatile bool leftIndicator = false;
 volatile bool rightIndicator = false;
 bool obstacleAlert = false;
-String obstacleLocation = "Clear";
+const char *obstacleLocation = "Clear";
 float temperature = 20.0;
 float humidity = 50.0;
 int frontDistance = 0;
@@ -57,6 +61,11 @@ unsigned long lastDHTRead = 0;
 unsigned long lastMPURead = 0;
 unsigned long lastWiFiAnimation = 0;
 unsigned long lastButtonCheck = 0;
+unsigned long lastEventPush = 0;
+unsigned long lastHeapReport = 0;
+
+// Last state pushed over /api/events, to send only on change
+char lastEventJson[384] = "";
 
 // Button states
 bool lastLeftState = HIGH;
@@ -66,6 +75,7 @@ unsigned long rightDebounceTime = 0;
 
 void setup() {
   Serial.begin(115200);
+  logger.begin(Serial);
   delay(1000);
   
   // Initialize pins first
@@ -109,7 +119,8 @@ void setup() {
   }
   
   wifiConnected = true;
-  Serial.println("\nWiFi connected: " + WiFi.localIP().toString());
+  Serial.print("\nWiFi connected: ");
+  Serial.println(WiFi.localIP());
   
   // Show connection success
   for (int i = 0; i < 3; i++) {
@@ -124,6 +135,8 @@ void setup() {
   setupWebServer();
   server.begin();
   Serial.println("Web server started");
+  heapMonitor.sample();
+  heapMonitor.print(Serial);
 }
 
 void loop() {
@@ -162,6 +175,19 @@ void loop() {
   handleObstacleAlert();
   handleAmbientLighting();
   
+  // Push state changes to dashboards (every 100ms)
+  if (currentTime - lastEventPush >= 100) {
+    pushStatusEvent();
+    lastEventPush = currentTime;
+  }
+  
+  // Heap report (every 30 seconds); a falling "lowest" block means fragmentation
+  if (currentTime - lastHeapReport >= 30000) {
+    heapMonitor.sample();
+    heapMonitor.log();
+    lastHeapReport = currentTime;
+  }
+  
   delay(10);
 }
 
@@ -205,7 +231,7 @@ void calibrateSpeed() {
   
   if (validReadings > 0) {
     accelBaseline = totalAccel / validReadings;
-    Serial.println("Speed calibrated. Baseline: " + String(accelBaseline));
+    Serial.printf("Speed calibrated. Baseline: %.2f\n", accelBaseline);
   }
 }
 
@@ -222,7 +248,7 @@ void handleButtons() {
     if (leftReading == LOW && lastLeftState == HIGH) {
       leftIndicator = !leftIndicator;
       if (leftIndicator) rightIndicator = false;
-      Serial.println("Left indicator: " + String(leftIndicator));
+      LOG(MSG_LEFT_INDICATOR, leftIndicator);
     }
   }
   lastLeftState = leftReading;
@@ -236,7 +262,7 @@ void handleButtons() {
     if (rightReading == LOW && lastRightState == HIGH) {
       rightIndicator = !rightIndicator;
       if (rightIndicator) leftIndicator = false;
-      Serial.println("Right indicator: " + String(rightIndicator));
+      LOG(MSG_RIGHT_INDICATOR, rightIndicator);
     }
   }
   lastRightState = rightReading;
@@ -287,7 +313,7 @@ void readDHTSensor() {
   if (!isnan(newHumidity) && !isnan(newTemperature)) {
     humidity = newHumidity;
     temperature = newTemperature;
-    Serial.println("Temp: " + String(temperature) + "°C, Humidity: " + String(humidity) + "%");
+    LOG(MSG_CLIMATE, temperature, humidity);
   }
 }
 
@@ -376,49 +402,112 @@ void handleAmbientLighting() {
   }
 }
 
+void writeStatus(JsonWriter &json) {
+  json.beginObject()
+    .add("temperature", temperature, 1)
+    .add("humidity", humidity, 1)
+    .add("leftIndicator", (bool)leftIndicator)
+    .add("rightIndicator", (bool)rightIndicator)
+    .add("obstacleAlert", obstacleAlert)
+    .add("obstacleLocation", obstacleLocation)
+    .add("frontDistance", frontDistance)
+    .add("backDistance", backDistance)
+    .add("speed", speed, 1)
+    .add("direction", direction, 1);
+  
+  // Calculate minimum distance for display
+  int minDistance = 0;
+  if (obstacleAlert) {
+    minDistance = 999;
+    if (frontDistance > 0) minDistance = min(minDistance, frontDistance);
+    if (backDistance > 0) minDistance = min(minDistance, backDistance);
+    if (minDistance == 999) minDistance = 0;
+  }
+  json.add("minDistance", minDistance).endObject();
+}
+
+// Cut-off JSON isn't sent; the first time is logged
+bool jsonFits(const JsonWriter &json) {
+  static bool logged = false;
+  if (!json.overflowed()) return true;
+  if (!logged) LOG(MSG_JSON_OVERFLOW, (uint32_t)json.capacity());
+  logged = true;
+  return false;
+}
+
+void sendJson(AsyncWebServerRequest *request, const JsonWriter &json) {
+  if (jsonFits(json)) request->send(200, "application/json", json.c_str());
+  else request->send(500, "application/json", "{\"error\":\"response too large\"}");
+}
+
+void pushStatusEvent() {
+  if (events.count() == 0) return;
+  
+  char buffer[sizeof(lastEventJson)];
+  JsonWriter json(buffer, sizeof(buffer));
+  writeStatus(json);
+  
+  if (!jsonFits(json) || strcmp(buffer, lastEventJson) == 0) return;
+  strcpy(lastEventJson, buffer);
+  events.send(buffer, "state", millis());
+}
+
 void setupWebServer() {
   server.on("/", HTTP_GET, [](AsyncWebServerRequest *request){
-    request->send(200, "text/html", getWebPage());
+    request->send_P(200, "text/html", WEB_PAGE);
   });
   
   server.on("/api/status", HTTP_GET, [](AsyncWebServerRequest *request){
-    DynamicJsonDocument doc(1024);
-    
-    doc["temperature"] = round(temperature * 10) / 10.0;
-    doc["humidity"] = round(humidity * 10) / 10.0;
-    doc["leftIndicator"] = leftIndicator;
-    doc["rightIndicator"] = rightIndicator;
-    doc["obstacleAlert"] = obstacleAlert;
-    doc["obstacleLocation"] = obstacleLocation;
-    doc["frontDistance"] = frontDistance;
-    doc["backDistance"] = backDistance;
-    doc["speed"] = round(speed * 10) / 10.0;
-    doc["direction"] = round(direction * 10) / 10.0;
-    
-    // Calculate minimum distance for display
-    int minDistance = 0;
-    if (obstacleAlert) {
-      minDistance = 999;
-      if (frontDistance > 0) minDistance = min(minDistance, frontDistance);
-      if (backDistance > 0) minDistance = min(minDistance, backDistance);
-      if (minDistance == 999) minDistance = 0;
-    }
-    doc["minDistance"] = minDistance;
-    
-    String response;
-    serializeJson(doc, response);
-    request->send(200, "application/json", response);
+    JsonBuffer<384> json;
+    writeStatus(json);
+    sendJson(request, json);
+  });
+  
+  // Server-Sent Events: full state on connect, then only changes
+  events.onConnect([](AsyncEventSourceClient *client){
+    JsonBuffer<sizeof(lastEventJson)> json;
+    writeStatus(json);
+    if (jsonFits(json)) client->send(json.c_str(), "state", millis(), 1000);
   });
+  server.addHandler(&events);
   
+  // Indicator commands: POST /api/indicator/left?state=on|off&seq=N
   server.on("/api/indicator/left", HTTP_POST, [](AsyncWebServerRequest *request){
-    leftIndicator = !leftIndicator;
-    if (leftIndicator) rightIndicator = false;
-    request->send(200, "application/json", "{\"status\":\"ok\"}");
+    handleIndicatorCommand(request, true);
   });
   
   server.on("/api/indicator/right", HTTP_POST, [](AsyncWebServerRequest *request){
-    rightIndicator = !rightIndicator;
-    if (rightIndicator) leftIndicator = false;
-    request->send(200, "application/json", "{\"status\":\"ok\"}");
+    handleIndicatorCommand(request, false);
   });
 }
+
+// Sets the indicator to the requested state rather than toggling it, so a
+// retried or concurrent request can't flip it twice. The response echoes
+// the client's sequence number with the state now in effect.
+void handleIndicatorCommand(AsyncWebServerRequest *request, bool left) {
+  // Anything but on or off is rejected, not taken as off
+  const char *state = request->hasParam("state") ? request->getParam("state")->value().c_str() : "";
+  bool on = strcmp(state, "on") == 0;
+  if (!on && strcmp(state, "off") != 0) {
+    request->send(400, "application/json", "{\"status\":\"error\",\"error\":\"state=on|off required\"}");
+    return;
+  }
+  
+  if (left) {
+    leftIndicator = on;
+    if (on) rightIndicator = false;
+  } else {
+    rightIndicator = on;
+    if (on) leftIndicator = false;
+  }
+  
+  unsigned long seq = request->hasParam("seq") ? request->getParam("seq")->value().toInt() : 0;
+  JsonBuffer<128> json;
+  json.beginObject()
+    .add("status", "ok")
+    .add("seq", seq)
+    .add("leftIndicator", (bool)leftIndicator)
+    .add("rightIndicator", (bool)rightIndicator)
+    .endObject();
+  sendJson(request, json);
+}
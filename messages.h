@@ -0,0 +1,100 @@
+/*
+ * Smart Car Dashboard - JSON Messages
+ * Author: Stromlabs - Pavan Kalsariya
+ * Date: July 2025
+ * Description: The JSON the cars send from fixed buffers: the dashboard
+ * state and snapshot, command acks, /status, the /update reply and the sync
+ * with the other car, and the size of each buffer (the debug reports' too).
+ * No hardware, so tools/json_check can write every message at its longest
+ * and fail when a buffer is too small. A sender still checks overflowed()
+ * and drops what didn't fit, since an ack echoes whatever target the client
+ * sent.
+ */
+
+#pragma once
+
+#include "carlogic.h"
+#include "jsonwriter.h"
+
+// --- BUFFER SIZES ---
+#define STATE_JSON_SIZE 384         // State push and snapshot
+#define ACK_JSON_SIZE 224
+#define STATUS_JSON_SIZE 192
+#define UPDATE_REPLY_JSON_SIZE 64
+#define PEER_SYNC_JSON_SIZE 96
+#define PROFILE_JSON_SIZE 1024      // /debug/profile, every loop stage
+#define JOBS_JSON_SIZE 1600         // /debug/jobs, a full job table
+
+// Ack errors
+#define ACK_UNKNOWN_TARGET "unknown target"
+#define ACK_BUSY "busy, send again"        // The loop's inbox was full
+
+// --- DASHBOARD ---
+// Full dashboard state, shared by the push and the connect snapshot. A
+// snapshot is sent once to a new client, with the server time for its clock.
+void writeStateFrame(JsonWriter &json, bool snapshot, uint32_t serverTimeMs) {
+    json.beginObject();
+    // The snapshot also carries the settings the page draws with
+    if (snapshot) json.add("type", "snapshot").add("serverTime", serverTimeMs).add("obstacleCm", CONFIG.obstacleCm, 1);
+    json.add("temp", carState.temp, 1)
+        .add("humidity", carState.humidity, 1)
+        .add("frontDist", carState.frontDist, 1)
+        .add("backDist", carState.backDist, 1)
+        .add("speed", carState.speed)
+        .add("direction", carState.direction, 1)
+        .add("leftIndicator", carState.leftIndicator)
+        .add("rightIndicator", carState.rightIndicator)
+        .add("buzzerOn", carState.buzzerOn)
+        .add("ambientOn", carState.ambientOn)
+        .add("car2Connected", peerConnected)
+        .add("car2Left", carState.peerLeft)
+        .add("car2Right", carState.peerRight)
+        .add("collision", COLLISION_LEVEL_NAMES[carState.collision])
+        .add("collisionSide", carState.collisionBack ? "back" : "front")
+        .add("ttc", carState.ttcMs == TTC_NONE ? -1.0f : carState.ttcMs * 0.001f, 1)
+        .endObject();
+}
+
+// Echo the sequence number with the state that is now in effect; error is
+// NULL once the command was applied
+void writeAck(JsonWriter &json, unsigned long seq, const char *target, const char *error) {
+    json.beginObject().add("type", "ack").add("seq", seq).add("target", target);
+    if (error) json.add("error", error);
+    json.add("leftIndicator", carState.leftIndicator)
+        .add("rightIndicator", carState.rightIndicator)
+        .add("buzzerOn", carState.buzzerOn)
+        .add("ambientOn", carState.ambientOn)
+        .endObject();
+}
+
+// --- HTTP ---
+// GET /status; Car 1 finds Car 2 by its type
+void writeStatus(JsonWriter &json) {
+    json.beginObject()
+        .add("type", CONFIG.statusType)
+        .add("leftIndicator", carState.leftIndicator)
+        .add("rightIndicator", carState.rightIndicator)
+        .add("temp", carState.temp, 1)
+        .add("humidity", carState.humidity, 1)
+        .add("frontDist", carState.frontDist, 1)
+        .add("backDist", carState.backDist, 1)
+        .endObject();
+}
+
+// Reply to POST /update: our indicators, for the other car to show
+void writeUpdateReply(JsonWriter &json) {
+    json.beginObject()
+        .add("leftIndicator", carState.leftIndicator)
+        .add("rightIndicator", carState.rightIndicator)
+        .endObject();
+}
+
+// POST /update body sent to the other car
+void writePeerSync(JsonWriter &json) {
+    json.beginObject()
+        .add("leftIndicator", carState.leftIndicator)
+        .add("rightIndicator", carState.rightIndicator)
+        .add("buzzerOn", carState.buzzerOn)
+        .add("ambientOn", carState.ambientOn)
+        .endObject();
+}
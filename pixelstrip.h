@@ -0,0 +1,162 @@
+/*
+ * Smart Car Dashboard - Pixel Strip
+ * Author: Stromlabs - Pavan Kalsariya
+ * Date: July 2025
+ * Description: WS2812 output through the RMT peripheral. Pixels are kept as
+ * 0xRRGGBB and only sent when one of them changed. A frame is encoded into
+ * a send buffer and handed to RMT, which clocks it out from its interrupt
+ * while the loop carries on; show() never waits. If the previous frame is
+ * still going out, the change is sent on a later call instead. Loop cost is
+ * a compare per pixel set plus the encode when something changed, so a
+ * 60-LED strip costs the loop about what one pixel did.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <driver/rmt.h>
+#include <esp_timer.h>
+#include "jsonwriter.h"
+
+// --- WS2812 TIMING ---
+// RMT at 80 MHz / 2 = 25 ns per tick
+#define PIXEL_RMT_CLK_DIV 2
+#define PIXEL_T0H_TICKS 16          // 0.40 us
+#define PIXEL_T0L_TICKS 34          // 0.85 us
+#define PIXEL_T1H_TICKS 32          // 0.80 us
+#define PIXEL_T1L_TICKS 18          // 0.45 us
+#define PIXEL_US_PER_LED 30         // 24 bits at 1.25 us
+#define PIXEL_RESET_US 300          // Low time that latches a frame (newer WS2812B need 280)
+
+// Called from the RMT interrupt to turn send-buffer bytes into pulses, a
+// block at a time, so no per-bit item buffer is kept
+static void IRAM_ATTR pixelTranslate(const void *src, rmt_item32_t *dest, size_t srcSize, size_t wantedNum,
+                                     size_t *translatedSize, size_t *itemNum) {
+    if (!src || !dest) {
+        *translatedSize = 0;
+        *itemNum = 0;
+        return;
+    }
+    rmt_item32_t bit0, bit1;
+    bit0.level0 = 1;
+    bit0.duration0 = PIXEL_T0H_TICKS;
+    bit0.level1 = 0;
+    bit0.duration1 = PIXEL_T0L_TICKS;
+    bit1.level0 = 1;
+    bit1.duration0 = PIXEL_T1H_TICKS;
+    bit1.level1 = 0;
+    bit1.duration1 = PIXEL_T1L_TICKS;
+
+    const uint8_t *in = (const uint8_t *)src;
+    size_t size = 0, num = 0;
+    while (size < srcSize && num + 8 <= wantedNum) {
+        for (uint8_t bit = 0x80; bit; bit >>= 1) {
+            dest->val = (*in & bit) ? bit1.val : bit0.val;
+            dest++;
+        }
+        num += 8;
+        size++;
+        in++;
+    }
+    *translatedSize = size;
+    *itemNum = num;
+}
+
+struct PixelStats {
+    uint32_t frames = 0;        // Sent to the strip
+    uint32_t deferred = 0;      // Changed while a frame was still going out
+};
+
+// --- STRIP ---
+template <uint16_t Count>
+class PixelStrip {
+public:
+    explicit PixelStrip(uint8_t pin, rmt_channel_t channel = RMT_CHANNEL_0) : pin_(pin), channel_(channel) {}
+
+    bool begin() {
+        rmt_config_t config = RMT_DEFAULT_CONFIG_TX((gpio_num_t)pin_, channel_);
+        config.clk_div = PIXEL_RMT_CLK_DIV;
+        if (rmt_config(&config) != ESP_OK) return false;
+        if (rmt_driver_install(channel_, 0, 0) != ESP_OK) return false;
+        if (rmt_translator_init(channel_, pixelTranslate) != ESP_OK) return false;
+        ready_ = true;
+        dirty_ = true;      // Clear whatever the strip powered up with
+        return true;
+    }
+
+    static uint32_t Color(uint8_t r, uint8_t g, uint8_t b) { return (uint32_t)r << 16 | (uint32_t)g << 8 | b; }
+
+    void setPixelColor(uint16_t i, uint32_t color) {
+        if (i >= Count || colors_[i] == color) return;
+        colors_[i] = color;
+        dirty_ = true;
+    }
+
+    void fill(uint32_t color) {
+        for (uint16_t i = 0; i < Count; i++) setPixelColor(i, color);
+    }
+
+    void clear() { fill(0); }
+
+    void setBrightness(uint8_t brightness) {
+        if (brightness == brightness_) return;
+        brightness_ = brightness;
+        dirty_ = true;
+    }
+
+    uint32_t getPixelColor(uint16_t i) const { return i < Count ? colors_[i] : 0; }
+    uint16_t numPixels() const { return Count; }
+
+    // Send if anything changed and the strip is free. Returns true if a
+    // frame was started.
+    bool show() {
+        if (!dirty_ || !ready_) return false;
+        if (busy()) {
+            stats_.deferred++;
+            return false;
+        }
+
+        // GRB order, brightness applied on the way out so the stored
+        // colours stay exact
+        uint16_t scale = brightness_ + 1;
+        for (uint16_t i = 0; i < Count; i++) {
+            uint32_t c = colors_[i];
+            tx_[i * 3] = ((c >> 8 & 0xFF) * scale) >> 8;
+            tx_[i * 3 + 1] = ((c >> 16 & 0xFF) * scale) >> 8;
+            tx_[i * 3 + 2] = ((c & 0xFF) * scale) >> 8;
+        }
+        if (rmt_write_sample(channel_, tx_, sizeof(tx_), false) != ESP_OK) return false;
+        sentUs_ = esp_timer_get_time();
+        dirty_ = false;
+        stats_.frames++;
+        return true;
+    }
+
+    // Still clocking out the last frame, or inside its latch time
+    bool busy() const {
+        if (esp_timer_get_time() - sentUs_ < (int64_t)Count * PIXEL_US_PER_LED + PIXEL_RESET_US) return true;
+        return rmt_wait_tx_done(channel_, 0) != ESP_OK;
+    }
+
+    const PixelStats &stats() const { return stats_; }
+
+    // "pixels":{"count":..,"frames":..,"deferred":..}
+    void write(JsonWriter &json, const char *key = "pixels") const {
+        json.beginObject(key)
+            .add("count", Count)
+            .add("frames", stats_.frames)
+            .add("deferred", stats_.deferred)
+            .endObject();
+    }
+
+private:
+    uint8_t pin_;
+    rmt_channel_t channel_;
+    bool ready_ = false;
+    bool dirty_ = false;
+    uint8_t brightness_ = 255;
+    int64_t sentUs_ = 0;
+    uint32_t colors_[Count] = {};
+    uint8_t tx_[Count * 3];     // Read by RMT while a frame goes out
+    PixelStats stats_;
+};
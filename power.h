@@ -0,0 +1,165 @@
+/*
+ * Smart Car Dashboard - Idle Governor
+ * Author: Stromlabs - Pavan Kalsariya
+ * Date: July 2025
+ * Description: Decides when a parked car can run slower. The loop reports
+ * each pass whether anything is going on (motion, an indicator or alert, a
+ * dashboard open); after a quiet spell the governor switches to idle, and
+ * the sketch's hook drops the CPU clock and the job rates. A button, motion
+ * interrupt or WebSocket connection stamps a wake from any context; the
+ * next loop pass switches back, and the time from the stamp to full rate is
+ * kept as the wake latency. Time in each state, the loop's time asleep and
+ * an estimate of the average current are reported.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <atomic>
+#include "jsonwriter.h"
+#include "profiler.h"
+
+// --- STATES ---
+enum PowerState : uint8_t {
+    POWER_ACTIVE,
+    POWER_IDLE,
+    POWER_STATES
+};
+
+static const char *const POWER_STATE_NAMES[POWER_STATES] = {"active", "idle"};
+
+enum WakeSource : uint8_t {
+    WAKE_BUTTON,
+    WAKE_MOTION,        // MPU6050 motion interrupt
+    WAKE_CLIENT,        // WebSocket connection
+    WAKE_STATE,         // The loop found something going on: a message, a reading
+    WAKE_SOURCES
+};
+
+static const char *const WAKE_SOURCE_NAMES[WAKE_SOURCES] = {"button", "motion", "client", "state"};
+
+// Typical board draw with the radio on, for the estimate only; there is no
+// current sensor. Measure yours and adjust.
+#define POWER_ACTIVE_MA 130             // 240 MHz
+#define POWER_IDLE_MA 95                // 80 MHz
+#define POWER_LIGHT_SLEEP_MA 30         // Station in automatic light sleep between beacons
+
+// --- WAKE STAMP ---
+// Set from ISRs and other tasks while idle, taken by the loop. Only the first
+// stamp counts, so the latency runs from the earliest wake.
+static std::atomic<uint32_t> powerWakeUs{0};     // 0: none
+static std::atomic<uint8_t> powerWakeSource{WAKE_STATE};
+static volatile bool powerIdle = false;
+
+static void IRAM_ATTR powerWake(WakeSource source) {
+    if (!powerIdle) return;
+    uint32_t none = 0;
+    if (powerWakeUs.compare_exchange_strong(none, micros() | 1, std::memory_order_relaxed)) {
+        powerWakeSource.store(source, std::memory_order_release);
+    }
+}
+
+// --- GOVERNOR ---
+typedef void (*PowerHook)(PowerState state);    // Applies a state; called from the loop
+
+// Used from the loop task only; reports may be read from elsewhere
+class IdleGovernor {
+public:
+    explicit IdleGovernor(PowerHook hook) : hook_(hook) {}
+
+    // idleAfterMs: quiet time before going idle (0: never). idleMa: what the
+    // idle state draws, for the estimate.
+    void begin(uint32_t idleAfterMs, uint16_t idleMa) {
+        idleAfterMs_ = idleAfterMs;
+        stateMa_[POWER_ACTIVE] = POWER_ACTIVE_MA;
+        stateMa_[POWER_IDLE] = idleMa;
+        quietSinceMs_ = millis();
+        sinceUs_ = micros();
+    }
+
+    // Top of every loop pass: a stamped wake (button, motion, a client) is
+    // back at full rate before any job runs
+    void wake() {
+        uint32_t stamp = powerWakeUs.exchange(0, std::memory_order_acquire);
+        if (!stamp) return;
+        quietSinceMs_ = millis();
+        if (state_ == POWER_IDLE) activate(powerWakeSource.load(std::memory_order_relaxed), stamp);
+    }
+
+    // Every loop pass, after the jobs ran and their changes were delivered,
+    // so what this pass found going on counts in this pass
+    void update(bool busy) {
+        uint32_t nowMs = millis();
+        wake();     // Stamped while the jobs ran
+        account();
+        if (busy) quietSinceMs_ = nowMs;
+
+        if (state_ == POWER_IDLE && busy) {
+            // Woken by the loop itself: timed from when this pass found it
+            activate(WAKE_STATE, micros());
+        } else if (state_ == POWER_ACTIVE && idleAfterMs_ && nowMs - quietSinceMs_ >= idleAfterMs_) {
+            setState(POWER_IDLE);
+            idleEntries_++;
+        }
+    }
+
+    // The loop slept this long waiting for its next deadline
+    void slept(uint32_t us) { asleepUs_ += us; }
+
+    PowerState state() const { return state_; }
+    const LatencyHistogram &wakeLatency() const { return wakeLatency_; }
+
+    // "power":{"state":..,"idleEntries":..,"activeS":..,"idleS":..,"asleepPct":..,"nowMa":..,"estMa":..,
+    //  "wakes":{"button":..,..},"wakeP50Us":..,"wakeP99Us":..,"wakeMaxUs":..}
+    void write(JsonWriter &json, const char *key = "power") const {
+        uint64_t totalUs = stateUs_[POWER_ACTIVE] + stateUs_[POWER_IDLE];
+        uint64_t chargeUs = stateUs_[POWER_ACTIVE] * stateMa_[POWER_ACTIVE] + stateUs_[POWER_IDLE] * stateMa_[POWER_IDLE];
+        json.beginObject(key)
+            .add("state", POWER_STATE_NAMES[state_])
+            .add("idleEntries", idleEntries_)
+            .add("activeS", (uint32_t)(stateUs_[POWER_ACTIVE] / 1000000))
+            .add("idleS", (uint32_t)(stateUs_[POWER_IDLE] / 1000000))
+            .add("asleepPct", totalUs ? 100.0f * asleepUs_ / totalUs : 0.0f, 1)
+            .add("nowMa", stateMa_[state_])
+            .add("estMa", totalUs ? (float)chargeUs / totalUs : 0.0f, 1);
+        json.beginObject("wakes");
+        for (uint8_t s = 0; s < WAKE_SOURCES; s++) json.add(WAKE_SOURCE_NAMES[s], wakes_[s]);
+        json.endObject()
+            .add("wakeP50Us", wakeLatency_.percentileUs(50))
+            .add("wakeP99Us", wakeLatency_.percentileUs(99))
+            .add("wakeMaxUs", wakeLatency_.maxUs())
+            .endObject();
+    }
+
+private:
+    void account() {
+        uint32_t now = micros();
+        stateUs_[state_] += now - sinceUs_;
+        sinceUs_ = now;
+    }
+
+    void activate(uint8_t source, uint32_t fromUs) {
+        account();
+        setState(POWER_ACTIVE);
+        wakeLatency_.record(micros() - fromUs);
+        wakes_[source]++;
+    }
+
+    void setState(PowerState state) {
+        state_ = state;
+        powerIdle = state == POWER_IDLE;
+        if (hook_) hook_(state);
+    }
+
+    PowerHook hook_;
+    PowerState state_ = POWER_ACTIVE;
+    uint32_t idleAfterMs_ = 0;
+    uint32_t quietSinceMs_ = 0;
+    uint32_t sinceUs_ = 0;
+    uint64_t stateUs_[POWER_STATES] = {};
+    uint64_t asleepUs_ = 0;
+    uint16_t stateMa_[POWER_STATES] = {};
+    uint32_t idleEntries_ = 0;
+    uint32_t wakes_[WAKE_SOURCES] = {};
+    LatencyHistogram wakeLatency_;      // Wake stamped to full rate restored
+};
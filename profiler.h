@@ -0,0 +1,171 @@
+/*
+ * Smart Car Dashboard - Loop Profiler
+ * Author: Stromlabs - Pavan Kalsariya
+ * Date: July 2025
+ * Description: Per-stage timing for loop(). Each stage is timed with the CPU
+ * cycle counter and recorded into a log-bucketed histogram (four buckets per
+ * power of two, so percentiles are within 25%), from which p50/p99/max are
+ * reported. Recording is two counter reads and an increment, cheap enough to
+ * leave on in production.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include "jsonwriter.h"
+
+// --- HISTOGRAM ---
+// Microsecond values; buckets 0..3 are exact, then four per power of two up
+// to 2^24 us (~16 s). Anything longer lands in the last bucket.
+#define PROFILE_SUB_BUCKETS 4
+#define PROFILE_MAX_EXP 24
+#define PROFILE_BUCKETS (PROFILE_SUB_BUCKETS + (PROFILE_MAX_EXP - 2) * PROFILE_SUB_BUCKETS)
+
+class LatencyHistogram {
+public:
+    void record(uint32_t us) {
+        counts_[bucketOf(us)]++;
+        count_++;
+        totalUs_ += us;
+        if (us > maxUs_) maxUs_ = us;
+    }
+
+    void reset() {
+        memset(counts_, 0, sizeof(counts_));
+        count_ = 0;
+        totalUs_ = 0;
+        maxUs_ = 0;
+    }
+
+    uint32_t count() const { return count_; }
+    uint32_t maxUs() const { return maxUs_; }
+    uint32_t meanUs() const { return count_ ? totalUs_ / count_ : 0; }
+
+    // Upper edge of the bucket holding the p-th percentile (0..100)
+    uint32_t percentileUs(uint8_t p) const {
+        if (count_ == 0) return 0;
+        uint32_t target = ((uint64_t)count_ * p + 99) / 100;
+        if (target == 0) target = 1;
+        uint32_t seen = 0;
+        for (uint8_t i = 0; i < PROFILE_BUCKETS; i++) {
+            seen += counts_[i];
+            if (seen >= target) {
+                uint32_t upper = bucketUpper(i);
+                return upper < maxUs_ ? upper : maxUs_;
+            }
+        }
+        return maxUs_;
+    }
+
+    static uint8_t bucketOf(uint32_t us) {
+        if (us < PROFILE_SUB_BUCKETS) return us;
+        uint8_t exp = 31 - __builtin_clz(us);
+        if (exp >= PROFILE_MAX_EXP) return PROFILE_BUCKETS - 1;
+        uint8_t sub = (us >> (exp - 2)) & (PROFILE_SUB_BUCKETS - 1);
+        return PROFILE_SUB_BUCKETS + (exp - 2) * PROFILE_SUB_BUCKETS + sub;
+    }
+
+    static uint32_t bucketUpper(uint8_t i) {
+        if (i < PROFILE_SUB_BUCKETS) return i;
+        uint8_t exp = (i - PROFILE_SUB_BUCKETS) / PROFILE_SUB_BUCKETS + 2;
+        uint8_t sub = (i - PROFILE_SUB_BUCKETS) % PROFILE_SUB_BUCKETS;
+        uint32_t width = 1UL << (exp - 2);
+        return ((PROFILE_SUB_BUCKETS + sub) << (exp - 2)) + width - 1;
+    }
+
+private:
+    uint32_t counts_[PROFILE_BUCKETS] = {};
+    uint32_t count_ = 0;
+    uint64_t totalUs_ = 0;
+    uint32_t maxUs_ = 0;
+};
+
+// --- PROFILER ---
+// Stages are an enum in the sketch; names are given in the same order.
+// Recording happens on the loop task only. Reports are read from other tasks
+// without locking, so a report taken mid-update can be off by one sample.
+// A reset is only requested from outside and applied by the loop task.
+template <uint8_t Stages>
+class LoopProfiler {
+public:
+    explicit LoopProfiler(const char *const *names) : names_(names) {}
+
+    void begin() {
+        cyclesPerUs_ = ESP.getCpuFreqMHz();
+        sinceMs_ = millis();
+    }
+
+    // After the CPU clock changed: the cycle counter runs at the new rate
+    void clockChanged() { cyclesPerUs_ = ESP.getCpuFreqMHz(); }
+
+    // Call at the top of loop(); applies a pending reset
+    void beginLoop() {
+        if (resetPending_) {
+            for (uint8_t s = 0; s < Stages; s++) stages_[s].reset();
+            sinceMs_ = millis();
+            resetPending_ = false;
+        }
+    }
+
+    static uint32_t now() { return ESP.getCycleCount(); }
+
+    // Record a stage that started at cycle count `start`. The counter wraps
+    // every ~18 s at 240 MHz, which unsigned subtraction handles.
+    void record(uint8_t stage, uint32_t start) {
+        stages_[stage].record((now() - start) / cyclesPerUs_);
+    }
+
+    void requestReset() { resetPending_ = true; }
+
+    const LatencyHistogram &stage(uint8_t s) const { return stages_[s]; }
+
+    // {"unit":"us","since":<s>,"stages":[{"name":..,"count":..,"mean":..,"p50":..,"p99":..,"max":..},...]}
+    void write(JsonWriter &json) const {
+        json.beginObject()
+            .add("unit", "us")
+            .add("since", sinceMs_ / 1000)
+            .beginArray("stages");
+        for (uint8_t s = 0; s < Stages; s++) {
+            const LatencyHistogram &h = stages_[s];
+            json.beginObject()
+                .add("name", names_[s])
+                .add("count", h.count())
+                .add("mean", h.meanUs())
+                .add("p50", h.percentileUs(50))
+                .add("p99", h.percentileUs(99))
+                .add("max", h.maxUs())
+                .endObject();
+        }
+        json.endArray().endObject();
+    }
+
+    void print(Print &out) const {
+        out.printf("%-12s %8s %8s %8s %8s %8s  (us, last %lu s)\n", "stage", "count", "mean", "p50", "p99", "max",
+                   (unsigned long)((millis() - sinceMs_) / 1000));
+        for (uint8_t s = 0; s < Stages; s++) {
+            const LatencyHistogram &h = stages_[s];
+            out.printf("%-12s %8lu %8lu %8lu %8lu %8lu\n", names_[s], (unsigned long)h.count(),
+                       (unsigned long)h.meanUs(), (unsigned long)h.percentileUs(50),
+                       (unsigned long)h.percentileUs(99), (unsigned long)h.maxUs());
+        }
+    }
+
+    // Times one stage from construction to the end of the enclosing block
+    class Scope {
+    public:
+        Scope(LoopProfiler &profiler, uint8_t stage) : profiler_(profiler), stage_(stage), start_(now()) {}
+        ~Scope() { profiler_.record(stage_, start_); }
+
+    private:
+        LoopProfiler &profiler_;
+        uint8_t stage_;
+        uint32_t start_;
+    };
+
+private:
+    LatencyHistogram stages_[Stages];
+    const char *const *names_;
+    uint32_t cyclesPerUs_ = 240;
+    unsigned long sinceMs_ = 0;
+    volatile bool resetPending_ = false;
+};
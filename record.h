@@ -0,0 +1,310 @@
+/*
+ * Smart Car Dashboard - Input Recording
+ * Author: Stromlabs - Pavan Kalsariya
+ * Date: July 2025
+ * Description: A compact binary record of everything the car logic reads:
+ * ultrasonic echo times, DHT readings, IMU samples, button presses as the
+ * loop saw them, messages from the other car and dashboard commands. The
+ * alert outputs the logic decided on are recorded too, so a replay can check
+ * it reaches the same ones, as is each point at which the outputs took in
+ * state changes, so it takes them in at the same points. Records are appended from any task into a RAM
+ * ring and written to flash from the loop; tools/replay reads them back.
+ *
+ * Format (little-endian): a 12-byte header, then records of
+ *   type (1 byte), time delta in ms (zigzag varint), payload (fixed per type)
+ * Times are the logic's own ("now" as passed to it), not when the record was
+ * appended, so a record can be a few ms older than the one before it.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include "jsonwriter.h"
+
+// --- FORMAT ---
+#define RECORD_MAGIC "SCRD"
+#define RECORD_VERSION 1
+#define RECORD_HEADER_SIZE 12
+
+enum RecordType : uint8_t {
+    REC_ECHO,           // front us, back us (u16 each; 0: no echo)
+    REC_CLIMATE,        // temperature, humidity (f32 each, as read; may be NaN)
+    REC_MOTION,         // accel x, y, z in m/s^2, gyro z in rad/s (f32 each)
+    REC_BUTTON,         // bit 0 left pressed, bit 1 right pressed, neither: double-press window ran out
+    REC_PEER_UPDATE,    // /update body: present mask, values mask (UpdateField bits)
+    REC_PEER_REPLY,     // reply to our /update: bit 0 left, bit 1 right
+    REC_PEER_STATUS,    // Car 2 search: bit 0 found, bit 1 left, bit 2 right
+    REC_COMMAND,        // dashboard set: target index, value in bit 7
+    REC_STATE,          // the outputs took in the state changes so far (no payload)
+    REC_OUTPUT,         // alert output changed: channel, alert type, value (u16)
+    REC_LOST,           // records dropped before this one (u16): the ring was full
+    REC_TYPES
+};
+
+static const uint8_t RECORD_SIZES[REC_TYPES] = {4, 8, 16, 1, 2, 1, 1, 1, 0, 4, 2};
+
+static const char *const RECORD_NAMES[REC_TYPES] = {
+    "echo", "climate", "motion", "button", "peerUpdate", "peerReply", "peerStatus", "command", "state", "output", "lost"
+};
+
+#define RECORD_MAX_SIZE (1 + 5 + 16)
+
+// Little-endian on both the ESP32 and the Linux tools, so fields are copied as-is
+inline uint8_t *recordPut(uint8_t *p, const void *value, size_t len) {
+    memcpy(p, value, len);
+    return p + len;
+}
+
+inline void recordHeader(uint8_t *out, uint8_t role, uint32_t configHash) {
+    memcpy(out, RECORD_MAGIC, 4);
+    out[4] = RECORD_VERSION;
+    out[5] = role;
+    out[6] = out[7] = 0;
+    memcpy(out + 8, &configHash, 4);
+}
+
+// --- RECORDER ---
+static portMUX_TYPE recordMux = portMUX_INITIALIZER_UNLOCKED;
+
+struct RecordStats {
+    uint32_t records;
+    uint32_t bytes;
+    uint32_t lost;      // Dropped because the ring was full
+};
+
+// RingSize: bytes held until the loop writes them out
+template <uint16_t RingSize>
+class InputRecorder {
+public:
+    // Discards anything unwritten and starts with a header
+    void start(uint8_t role, uint32_t configHash) {
+        portENTER_CRITICAL(&recordMux);
+        head_ = tail_ = 0;
+        lastMs_ = 0;
+        pendingLost_ = 0;
+        stats_ = {};
+        climateSeen_ = false;
+        recordHeader(header_, role, configHash);
+        headerPending_ = true;
+        active_ = true;
+        portEXIT_CRITICAL(&recordMux);
+    }
+
+    void stop() { active_ = false; }
+    bool active() const { return active_; }
+
+    // --- INPUTS ---
+    void echo(uint32_t nowMs, uint16_t frontUs, uint16_t backUs) {
+        uint8_t p[4];
+        recordPut(recordPut(p, &frontUs, 2), &backUs, 2);
+        append(REC_ECHO, nowMs, p);
+    }
+
+    // Only when the reading differs from the last one recorded; the DHT
+    // library repeats its last frame between reads
+    void climate(uint32_t nowMs, float temp, float humidity) {
+        uint8_t p[8];
+        recordPut(recordPut(p, &temp, 4), &humidity, 4);
+        if (climateSeen_ && memcmp(p, lastClimate_, 8) == 0) return;
+        memcpy(lastClimate_, p, 8);
+        climateSeen_ = true;
+        append(REC_CLIMATE, nowMs, p);
+    }
+
+    void motion(uint32_t nowMs, float ax, float ay, float az, float gz) {
+        uint8_t p[16];
+        recordPut(recordPut(recordPut(recordPut(p, &ax, 4), &ay, 4), &az, 4), &gz, 4);
+        append(REC_MOTION, nowMs, p);
+    }
+
+    void button(uint32_t nowMs, bool left, bool right) {
+        uint8_t p = (left ? 1 : 0) | (right ? 2 : 0);
+        append(REC_BUTTON, nowMs, &p);
+    }
+
+    void peerUpdate(uint32_t nowMs, uint8_t present, uint8_t values) {
+        uint8_t p[2] = {present, values};
+        append(REC_PEER_UPDATE, nowMs, p);
+    }
+
+    void peerReply(uint32_t nowMs, bool left, bool right) {
+        uint8_t p = (left ? 1 : 0) | (right ? 2 : 0);
+        append(REC_PEER_REPLY, nowMs, &p);
+    }
+
+    void peerStatus(uint32_t nowMs, bool found, bool left, bool right) {
+        uint8_t p = (found ? 1 : 0) | (left ? 2 : 0) | (right ? 4 : 0);
+        append(REC_PEER_STATUS, nowMs, &p);
+    }
+
+    void command(uint32_t nowMs, uint8_t target, bool value) {
+        uint8_t p = target | (value ? 0x80 : 0);
+        append(REC_COMMAND, nowMs, &p);
+    }
+
+    // --- OUTPUTS ---
+    void state(uint32_t nowMs) { append(REC_STATE, nowMs, NULL); }
+
+    void output(uint32_t nowMs, uint8_t channel, uint8_t type, uint16_t value) {
+        uint8_t p[4] = {channel, type};
+        memcpy(p + 2, &value, 2);
+        append(REC_OUTPUT, nowMs, p);
+    }
+
+    // --- DRAIN (one task) ---
+    // Copies out up to len bytes, oldest first; the header comes first after start()
+    size_t read(uint8_t *out, size_t len) {
+        portENTER_CRITICAL(&recordMux);
+        size_t n = 0;
+        if (headerPending_ && len >= RECORD_HEADER_SIZE) {
+            memcpy(out, header_, RECORD_HEADER_SIZE);
+            headerPending_ = false;
+            n = RECORD_HEADER_SIZE;
+        }
+        while (n < len && tail_ != head_) {
+            out[n++] = ring_[tail_];
+            tail_ = (tail_ + 1) % RingSize;
+        }
+        portEXIT_CRITICAL(&recordMux);
+        return n;
+    }
+
+    const RecordStats &stats() const { return stats_; }
+
+    // "record":{"active":..,"records":..,"bytes":..,"lost":..}
+    void write(JsonWriter &json, const char *key = "record") const {
+        json.beginObject(key)
+            .add("active", active_)
+            .add("records", stats_.records)
+            .add("bytes", stats_.bytes)
+            .add("lost", stats_.lost)
+            .endObject();
+    }
+
+private:
+    size_t freeBytes() const { return (tail_ + RingSize - head_ - 1) % RingSize; }
+
+    void put(const uint8_t *p, size_t len) {
+        for (size_t i = 0; i < len; i++) {
+            ring_[head_] = p[i];
+            head_ = (head_ + 1) % RingSize;
+        }
+    }
+
+    // Encodes into a scratch record first so a full ring drops whole records
+    size_t encode(uint8_t *out, RecordType type, uint32_t nowMs, const uint8_t *payload) {
+        int32_t delta = (int32_t)(nowMs - lastMs_);
+        uint32_t zigzag = ((uint32_t)delta << 1) ^ (uint32_t)(delta >> 31);
+        size_t n = 0;
+        out[n++] = type;
+        do {
+            uint8_t b = zigzag & 0x7F;
+            zigzag >>= 7;
+            out[n++] = zigzag ? (b | 0x80) : b;
+        } while (zigzag);
+        if (RECORD_SIZES[type]) memcpy(out + n, payload, RECORD_SIZES[type]);
+        return n + RECORD_SIZES[type];
+    }
+
+    void append(RecordType type, uint32_t nowMs, const uint8_t *payload) {
+        if (!active_) return;
+        uint8_t rec[RECORD_MAX_SIZE * 2];
+        portENTER_CRITICAL(&recordMux);
+        uint32_t lastMs = lastMs_;
+        size_t n = 0;
+        if (pendingLost_) {
+            uint16_t lost = pendingLost_ > 0xFFFF ? 0xFFFF : pendingLost_;
+            n = encode(rec, REC_LOST, nowMs, (const uint8_t *)&lost);
+            lastMs_ = nowMs;
+        }
+        n += encode(rec + n, type, nowMs, payload);
+        if (n <= freeBytes()) {
+            put(rec, n);
+            lastMs_ = nowMs;
+            stats_.records++;
+            stats_.bytes += n;
+            pendingLost_ = 0;
+        } else {
+            lastMs_ = lastMs;
+            pendingLost_++;
+            stats_.lost++;
+        }
+        portEXIT_CRITICAL(&recordMux);
+    }
+
+    uint8_t ring_[RingSize];
+    uint16_t head_ = 0;
+    uint16_t tail_ = 0;
+    uint32_t lastMs_ = 0;
+    uint32_t pendingLost_ = 0;
+    uint8_t lastClimate_[8] = {};
+    bool climateSeen_ = false;
+    uint8_t header_[RECORD_HEADER_SIZE] = {};
+    bool headerPending_ = false;
+    volatile bool active_ = false;
+    RecordStats stats_ = {};
+};
+
+// --- READER ---
+struct Record {
+    RecordType type;
+    uint32_t timeMs;
+    const uint8_t *payload;
+};
+
+// Walks records in a buffer; stops at the end or at a record cut short
+class RecordReader {
+public:
+    RecordReader(const uint8_t *data, size_t len) : p_(data), end_(data + len) {}
+
+    // Reads and checks the header; false if this isn't a recording
+    bool header(uint8_t &role, uint32_t &configHash) {
+        if (end_ - p_ < RECORD_HEADER_SIZE || memcmp(p_, RECORD_MAGIC, 4) != 0 || p_[4] != RECORD_VERSION) return false;
+        role = p_[5];
+        memcpy(&configHash, p_ + 8, 4);
+        p_ += RECORD_HEADER_SIZE;
+        return true;
+    }
+
+    bool next(Record &rec) {
+        if (p_ >= end_ || *p_ >= REC_TYPES) return false;
+        const uint8_t *p = p_;
+        RecordType type = (RecordType)*p++;
+        uint32_t zigzag = 0;
+        for (uint8_t shift = 0;; shift += 7) {
+            if (p >= end_ || shift > 28) return false;
+            uint8_t b = *p++;
+            zigzag |= (uint32_t)(b & 0x7F) << shift;
+            if (!(b & 0x80)) break;
+        }
+        if ((size_t)(end_ - p) < RECORD_SIZES[type]) return false;
+
+        int32_t delta = (int32_t)(zigzag >> 1) ^ -(int32_t)(zigzag & 1);
+        timeMs_ += delta;
+        rec.type = type;
+        rec.timeMs = timeMs_;
+        rec.payload = p;
+        p_ = p + RECORD_SIZES[type];
+        return true;
+    }
+
+    // Bytes left unread: 0 unless the recording ends in a partial record
+    size_t remaining() const { return end_ - p_; }
+
+private:
+    const uint8_t *p_;
+    const uint8_t *end_;
+    uint32_t timeMs_ = 0;
+};
+
+inline uint16_t recordU16(const uint8_t *p) {
+    uint16_t v;
+    memcpy(&v, p, 2);
+    return v;
+}
+
+inline float recordF32(const uint8_t *p) {
+    float v;
+    memcpy(&v, p, 4);
+    return v;
+}
@@ -0,0 +1,155 @@
+/*
+ * Smart Car Dashboard - Runtime Stats
+ * Author: Stromlabs - Pavan Kalsariya
+ * Date: July 2025
+ * Description: Heap and task stack introspection. Besides free memory the
+ * heap monitor tracks the largest free block and the lowest it has been since
+ * boot, which is what shows fragmentation: free heap can look healthy while
+ * the largest block keeps shrinking until an allocation fails. Nothing here
+ * runs on its own; values are only read when a report is asked for.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+#include "jsonwriter.h"
+#include "logger.h"
+
+// Sampled from the loop task and from web handlers on async_tcp
+static portMUX_TYPE runtimeMux = portMUX_INITIALIZER_UNLOCKED;
+
+// --- HEAP ---
+struct HeapStats {
+    uint32_t freeBytes = 0;
+    uint32_t largestBlock = 0;
+    uint32_t minFree = 0;            // All-time low of freeBytes (from the allocator)
+    uint32_t minLargestBlock = 0;    // All-time low of largestBlock (from our samples)
+};
+
+class HeapMonitor {
+public:
+    // Cheap enough for every few seconds, not for every loop pass
+    void sample() {
+        uint32_t freeBytes = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+        uint32_t largestBlock = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+        uint32_t minFree = heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
+
+        portENTER_CRITICAL(&runtimeMux);
+        stats_.freeBytes = freeBytes;
+        stats_.largestBlock = largestBlock;
+        stats_.minFree = minFree;
+        if (samples_ == 0 || largestBlock < stats_.minLargestBlock) {
+            stats_.minLargestBlock = largestBlock;
+        }
+        samples_++;
+        portEXIT_CRITICAL(&runtimeMux);
+    }
+
+    HeapStats stats() const {
+        portENTER_CRITICAL(&runtimeMux);
+        HeapStats copy = stats_;
+        portEXIT_CRITICAL(&runtimeMux);
+        return copy;
+    }
+
+    // "heap":{"free":..,"largestBlock":..,"minFree":..,"minLargestBlock":..}
+    void write(JsonWriter &json, const char *key = "heap") const {
+        HeapStats s = stats();
+        json.beginObject(key)
+            .add("free", s.freeBytes)
+            .add("largestBlock", s.largestBlock)
+            .add("minFree", s.minFree)
+            .add("minLargestBlock", s.minLargestBlock)
+            .endObject();
+    }
+
+    void print(Print &out) const {
+        HeapStats s = stats();
+        out.printf("Heap: free %u, largest block %u (lowest %u), min free %u\n",
+                   (unsigned)s.freeBytes, (unsigned)s.largestBlock,
+                   (unsigned)s.minLargestBlock, (unsigned)s.minFree);
+    }
+
+    // Same line as print(), deferred through the logger for periodic reports
+    void log() const {
+        HeapStats s = stats();
+        LOG(MSG_HEAP, s.freeBytes, s.largestBlock, s.minLargestBlock, s.minFree);
+    }
+
+private:
+    HeapStats stats_;
+    uint32_t samples_ = 0;
+};
+
+// --- TASK STACKS ---
+// Stack high-water marks of the tasks that matter for Car 1: our loop, the
+// web server's TCP task, the WiFi driver and the lwIP stack. Handles are
+// looked up by name the first time each task is seen, then cached.
+class TaskStackMonitor {
+public:
+    static const uint8_t kTasks = 4;
+
+    const char *label(uint8_t i) const { return tasks_[i].label; }
+
+    // Lowest free stack in bytes since the task started, or -1 if the task
+    // isn't running (async_tcp only starts with the first connection)
+    int32_t minFree(uint8_t i) {
+        Task &t = tasks_[i];
+        if (!t.handle) t.handle = xTaskGetHandle(t.name);
+        if (!t.handle) return -1;
+        return uxTaskGetStackHighWaterMark(t.handle);
+    }
+
+    // "stacks":{"loop":..,"async_tcp":..,"wifi":..,"tcpip":..}
+    void write(JsonWriter &json, const char *key = "stacks") {
+        json.beginObject(key);
+        for (uint8_t i = 0; i < kTasks; i++) json.add(label(i), (long)minFree(i));
+        json.endObject();
+    }
+
+    void print(Print &out) {
+        out.print("Stack free:");
+        for (uint8_t i = 0; i < kTasks; i++) out.printf(" %s %ld", label(i), (long)minFree(i));
+        out.println();
+    }
+
+private:
+    struct Task {
+        const char *label;
+        const char *name;
+        TaskHandle_t handle;
+    };
+
+    Task tasks_[kTasks] = {
+        {"loop", "loopTask", NULL},
+        {"async_tcp", "async_tcp", NULL},
+        {"wifi", "wifi", NULL},
+        {"tcpip", "tiT", NULL},
+    };
+};
+
+// --- SERIAL COMMANDS ---
+// Collects characters from the serial port without blocking. poll() returns
+// a finished line (without the newline) or NULL.
+template <size_t Size>
+class SerialLineReader {
+public:
+    const char *poll(Stream &in) {
+        while (in.available() > 0) {
+            char c = in.read();
+            if (c == '\n' || c == '\r') {
+                if (len_ == 0) continue;
+                line_[len_] = '\0';
+                len_ = 0;
+                return line_;
+            }
+            if (len_ < Size - 1) line_[len_++] = c;
+        }
+        return NULL;
+    }
+
+private:
+    char line_[Size];
+    size_t len_ = 0;
+};
@@ -0,0 +1,158 @@
+/*
+ * Smart Car Dashboard - Job Scheduler
+ * Author: Stromlabs - Pavan Kalsariya
+ * Date: July 2025
+ * Description: Runs the loop's periodic jobs against absolute deadlines.
+ * Each job's next deadline is its last deadline plus its period, never "now
+ * plus period", so periods don't drift however late a run starts. Jobs get
+ * a phase offset so heavy ones don't fall due in the same pass. Due jobs run
+ * earliest deadline first, each at most once per pass; a job that fell a
+ * whole period behind skips the missed runs instead of running back to back.
+ * How late each run started is kept per job, and idleUs() says how long the
+ * loop can sleep before the next deadline. A job's period can be changed
+ * while it runs, e.g. slower while the car is parked.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include "jsonwriter.h"
+#include "profiler.h"
+
+typedef uint32_t (*SchedulerClock)();   // Microseconds, wrapping
+typedef void (*JobFn)();
+
+struct Job {
+    const char *name;
+    JobFn fn;
+    uint32_t periodUs;
+    uint32_t phaseUs;
+    uint32_t deadlineUs;
+    uint32_t runs;
+    uint32_t skipped;           // Periods missed entirely
+    LatencyHistogram lateness;  // Start time minus deadline
+};
+
+// Used from the loop task only; reports may be read from elsewhere and can
+// be off by one run.
+template <uint8_t MaxJobs>
+class Scheduler {
+public:
+    explicit Scheduler(SchedulerClock clock) : clock_(clock) {}
+
+    // phaseMs: offset of the first deadline from start(). Returns the job's
+    // index, or -1 if the table is full.
+    int8_t add(const char *name, JobFn fn, uint32_t periodMs, uint32_t phaseMs = 0) {
+        if (count_ >= MaxJobs || periodMs == 0) return -1;
+        Job &job = jobs_[count_];
+        job.name = name;
+        job.fn = fn;
+        job.periodUs = periodMs * 1000;
+        job.phaseUs = phaseMs * 1000;
+        job.deadlineUs = clock_() + job.phaseUs;
+        return count_++;
+    }
+
+    // Lays every job's first deadline out from now by its phase
+    void start() {
+        uint32_t now = clock_();
+        for (uint8_t i = 0; i < count_; i++) jobs_[i].deadlineUs = now + jobs_[i].phaseUs;
+    }
+
+    // A new period from the next run on. The next deadline becomes the last
+    // one plus the new period, or now if that has already passed, so a job
+    // sped up runs at once and isn't counted as skipping.
+    void setPeriod(int8_t index, uint32_t periodMs) {
+        if (index < 0 || index >= count_ || periodMs == 0) return;
+        Job &job = jobs_[index];
+        uint32_t now = clock_();
+        job.deadlineUs += periodMs * 1000 - job.periodUs;
+        job.periodUs = periodMs * 1000;
+        if ((int32_t)(now - job.deadlineUs) > 0) job.deadlineUs = now;
+    }
+
+    // Run every due job once, earliest deadline first. Returns how many ran.
+    uint8_t run() {
+        uint32_t ran = 0;   // Bit per job already run this pass
+        uint8_t n = 0;
+        for (;;) {
+            uint32_t now = clock_();
+            int8_t next = -1;
+            int32_t mostLate = -1;
+            for (uint8_t i = 0; i < count_; i++) {
+                int32_t late = (int32_t)(now - jobs_[i].deadlineUs);
+                if (late >= 0 && !(ran & (1UL << i)) && late > mostLate) {
+                    mostLate = late;
+                    next = i;
+                }
+            }
+            if (next < 0) return n;
+
+            Job &job = jobs_[next];
+            job.lateness.record(mostLate);
+            job.fn();
+            job.runs++;
+            ran |= 1UL << next;
+            n++;
+
+            // Next slot on the job's own grid; skip slots already gone
+            job.deadlineUs += job.periodUs;
+            int32_t behind = (int32_t)(clock_() - job.deadlineUs);
+            if (behind >= 0) {
+                uint32_t missed = (uint32_t)behind / job.periodUs + 1;
+                job.deadlineUs += missed * job.periodUs;
+                job.skipped += missed;
+            }
+        }
+    }
+
+    // Time until the earliest deadline; 0 if a job is already due
+    uint32_t idleUs() const {
+        uint32_t now = clock_();
+        uint32_t idle = UINT32_MAX;
+        for (uint8_t i = 0; i < count_; i++) {
+            int32_t until = (int32_t)(jobs_[i].deadlineUs - now);
+            if (until <= 0) return 0;
+            if ((uint32_t)until < idle) idle = until;
+        }
+        return idle;
+    }
+
+    uint8_t count() const { return count_; }
+    const Job &job(uint8_t i) const { return jobs_[i]; }
+
+    // "jobs":[{"name":..,"periodMs":..,"runs":..,"skipped":..,"lateP50Us":..,"lateP99Us":..,"lateMaxUs":..},...]
+    void write(JsonWriter &json, const char *key = "jobs") const {
+        json.beginArray(key);
+        for (uint8_t i = 0; i < count_; i++) {
+            const Job &job = jobs_[i];
+            json.beginObject()
+                .add("name", job.name)
+                .add("periodMs", job.periodUs / 1000)
+                .add("runs", job.runs)
+                .add("skipped", job.skipped)
+                .add("lateP50Us", job.lateness.percentileUs(50))
+                .add("lateP99Us", job.lateness.percentileUs(99))
+                .add("lateMaxUs", job.lateness.maxUs())
+                .endObject();
+        }
+        json.endArray();
+    }
+
+    void print(Print &out) const {
+        out.printf("%-12s %8s %8s %8s %8s %8s %8s  (lateness in us)\n", "job", "period", "runs", "skipped", "p50",
+                   "p99", "max");
+        for (uint8_t i = 0; i < count_; i++) {
+            const Job &job = jobs_[i];
+            out.printf("%-12s %8lu %8lu %8lu %8lu %8lu %8lu\n", job.name, (unsigned long)(job.periodUs / 1000),
+                       (unsigned long)job.runs, (unsigned long)job.skipped,
+                       (unsigned long)job.lateness.percentileUs(50), (unsigned long)job.lateness.percentileUs(99),
+                       (unsigned long)job.lateness.maxUs());
+        }
+    }
+
+private:
+    SchedulerClock clock_;
+    Job jobs_[MaxJobs] = {};
+    uint8_t count_ = 0;
+};
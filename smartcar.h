@@ -0,0 +1,1280 @@
+/*
+ * Smart Car Dashboard - Firmware
+ * Author: Stromlabs - Pavan Kalsariya
+ * Date: July 2025
+ * Description: The firmware shared by every car. A sketch defines CAR_ROLE and
+ * includes this file; pins, thresholds and timings come from config.h, and
+ * features the role doesn't have are left out by the preprocessor. Reads
+ * DHT11 and ultrasonics, drives indicators and buzzer, and depending on the
+ * role reads the MPU6050, drives the NeoPixel, hosts the dashboard and syncs
+ * indicators with the other car.
+ * Visit: stromlabs.tech
+ */
+
+#pragma once
+
+#include "config.h"
+
+#include <WiFi.h>
+#include <ESPAsyncWebServer.h>
+#include <ArduinoJson.h>
+#include <DHT.h>
+#include <LittleFS.h>
+#if FEATURE_PEER
+#include <HTTPClient.h>
+#endif
+#if !FEATURE_DASHBOARD
+#include <esp_wifi.h>
+#endif
+#if FEATURE_DASHBOARD
+#include <AsyncWebSocket.h>
+#include <esp_wifi.h>
+#include "dashboard.h"
+#include "history.h"
+#include "telemetrylog.h"
+#endif
+#if FEATURE_AMBIENT
+#include "pixelstrip.h"
+#include "animation.h"
+#endif
+#if FEATURE_MPU
+#include <Wire.h>
+#include <Adafruit_MPU6050.h>
+#include <Adafruit_Sensor.h>
+#endif
+#include "jsonwriter.h"
+#include "runtime.h"
+#include "profiler.h"
+#include "logger.h"
+#include "buzzer.h"
+#include "blinker.h"
+#include "scheduler.h"
+#include "power.h"
+#include "carlogic.h"
+#include "messages.h"
+#include "inbox.h"
+
+#define DHT_TYPE DHT11
+
+// Automatic light sleep needs an SDK built with power management and
+// tickless idle, and a station: the access point can't sleep and keep its
+// clients. Elsewhere idle only slows the clock and the jobs.
+#if !FEATURE_DASHBOARD && CONFIG_PM_ENABLE && CONFIG_FREERTOS_USE_TICKLESS_IDLE
+#define POWER_LIGHT_SLEEP 1
+#include <esp_pm.h>
+#include <esp_sleep.h>
+#include <driver/gpio.h>
+#include <hal/gpio_ll.h>
+#else
+#define POWER_LIGHT_SLEEP 0
+#endif
+
+// --- NETWORK ---
+AsyncWebServer server(80);
+#if FEATURE_DASHBOARD
+AsyncWebSocket ws("/ws");
+#endif
+
+// The other car: Car 1 finds Car 2 among its stations, Car 2 always talks
+// to Car 1 at CONFIG.mainHost
+IPAddress peerIP;
+
+// --- SENSOR OBJECTS ---
+DHT dht(CONFIG.pins.dht, DHT_TYPE);
+#if FEATURE_AMBIENT
+PixelStrip<CONFIG.neopixelCount> ambientLight(CONFIG.pins.neopixel);
+AmbientAnimator<CONFIG.neopixelCount> ambientAnim;
+#endif
+#if FEATURE_MPU
+Adafruit_MPU6050 mpu;
+#endif
+
+#if FEATURE_DASHBOARD
+// --- TELEMETRY HISTORY ---
+TelemetryHistory history;
+
+// --- TELEMETRY LOG ---
+// Two blocks: one filling while the other is written
+TelemetryLog<512> telemetryLog;
+#endif
+
+// --- RUNTIME STATS ---
+HeapMonitor heapMonitor;
+TaskStackMonitor taskStacks;
+
+#if FEATURE_PEER
+// --- /update BODIES ---
+// Bodies are under 100 bytes; four slots cover a few requests in flight
+BodyPool<4, 256> updateBodies;
+#endif
+
+// --- INBOXES ---
+// The car state belongs to the loop task. What arrives on async_tcp is
+// posted here and applied by the loop (takeInbox()).
+#if FEATURE_PEER
+Inbox<UpdateBody, 8> updateInbox(wakeLoop);
+#endif
+#if FEATURE_DASHBOARD
+struct DashboardCommand {
+    uint32_t clientId;          // Acked once applied, if still connected
+    unsigned long seq;
+    uint8_t target;             // CommandTarget
+    bool value;
+};
+
+Inbox<DashboardCommand, 16> commandInbox(wakeLoop);
+#endif
+
+// --- JSON SENDERS ---
+// Each reply or frame built in a fixed buffer. One that overflowed is cut
+// off mid-value, so it isn't sent: HTTP gets a 500, a frame is skipped.
+
+enum JsonSender : uint8_t {
+    JSON_STATE,
+    JSON_SNAPSHOT,
+    JSON_ACK,
+    JSON_STATUS,
+    JSON_UPDATE,
+    JSON_PEER_SYNC,
+    JSON_PROFILE,
+    JSON_JOBS,
+    JSON_RUNTIME,
+    JSON_SENDERS
+};
+
+static const char *const JSON_SENDER_NAMES[JSON_SENDERS] = {
+    "state", "snapshot", "ack", "status", "update", "peerSync", "profile", "jobs", "runtime"};
+
+// Messages dropped per sender; senders run on loopTask and async_tcp
+std::atomic<uint32_t> jsonOverflows[JSON_SENDERS];
+
+// Counts every overflow and logs each sender's first
+void jsonDropped(JsonSender sender, size_t capacity) {
+    if (jsonOverflows[sender]++ == 0) LOG(MSG_JSON_OVERFLOW, (uint32_t)capacity);
+}
+
+bool jsonFits(const JsonWriter &json, JsonSender sender) {
+    if (!json.overflowed()) return true;
+    jsonDropped(sender, json.capacity());
+    return false;
+}
+
+void sendJson(AsyncWebServerRequest *request, const JsonWriter &json, JsonSender sender) {
+    if (jsonFits(json, sender)) request->send(200, "application/json", json.c_str());
+    else request->send(500, "application/json", "{\"error\":\"response too large\"}");
+}
+
+// A whole number of seconds from a query parameter, left as is if the
+// parameter is absent. False for anything but digits, or past 32 bits.
+bool readSeconds(AsyncWebServerRequest *request, const char *name, uint32_t &seconds) {
+    if (!request->hasParam(name)) return true;
+    const char *text = request->getParam(name)->value().c_str();
+    if (!*text) return false;
+    uint32_t value = 0;
+    for (; *text; text++) {
+        if (*text < '0' || *text > '9' || value > (UINT32_MAX - 9) / 10) return false;
+        value = value * 10 + (*text - '0');
+    }
+    seconds = value;
+    return true;
+}
+
+// --- LOOP PROFILER ---
+enum LoopStage {
+    STAGE_LOOP,
+    STAGE_DHT,
+    STAGE_ULTRASONIC,
+#if FEATURE_MPU
+    STAGE_MPU,
+#endif
+    STAGE_OUTPUTS,
+#if FEATURE_PEER && CAR_ROLE == ROLE_MAIN
+    STAGE_PEER_CHECK,
+#endif
+#if FEATURE_PEER
+    STAGE_PEER_SEND,
+#endif
+#if FEATURE_DASHBOARD
+    STAGE_WS_PUSH,
+#endif
+    STAGE_COUNT
+};
+
+// Same order as LoopStage; peer stages are named after the car on the other end
+const char *const STAGE_NAMES[STAGE_COUNT] = {
+    "loop", "dht", "ultrasonic",
+#if FEATURE_MPU
+    "mpu",
+#endif
+    "outputs",
+#if FEATURE_PEER && CAR_ROLE == ROLE_MAIN
+    "car2_check", "car2_send",
+#elif FEATURE_PEER
+    "car1_send",
+#endif
+#if FEATURE_DASHBOARD
+    "ws_push",
+#endif
+};
+
+LoopProfiler<STAGE_COUNT> profiler(STAGE_NAMES);
+
+// --- TIMING VARIABLES ---
+IndicatorBlinker blinker;
+BuzzerEngine buzzer;
+uint32_t schedulerClock() { return micros(); }
+Scheduler<10> scheduler(schedulerClock);
+
+// --- BUTTON VARIABLES ---
+volatile bool leftButtonPressed = false;
+volatile bool rightButtonPressed = false;
+volatile unsigned long lastLeftPress = 0;
+volatile unsigned long lastRightPress = 0;
+
+// --- LOOP WAKE ---
+// Wakes the loop if it's sleeping until its next job: from a button ISR, or
+// from another task (async_tcp) that published a state change
+TaskHandle_t loopTaskHandle = NULL;
+
+void IRAM_ATTR wakeLoop() {
+    if (!loopTaskHandle) return;
+    if (xPortInIsrContext()) {
+        BaseType_t woken = pdFALSE;
+        vTaskNotifyGiveFromISR(loopTaskHandle, &woken);
+        if (woken) portYIELD_FROM_ISR();
+    } else if (xTaskGetCurrentTaskHandle() != loopTaskHandle) {
+        xTaskNotifyGive(loopTaskHandle);
+    }
+}
+
+// --- BUTTON INTERRUPT HANDLERS ---
+#if POWER_LIGHT_SLEEP
+// The light sleep wake makes a button's interrupt level-triggered; back to
+// the falling edge, or it fires for as long as the button is held
+#define REARM_BUTTON(pin) gpio_ll_set_intr_type(&GPIO, (gpio_num_t)(pin), GPIO_INTR_NEGEDGE)
+#else
+#define REARM_BUTTON(pin) ((void)0)
+#endif
+
+void IRAM_ATTR leftButtonISR() {
+    REARM_BUTTON(CONFIG.pins.leftButton);
+    unsigned long currentTime = millis();
+    if (currentTime - lastLeftPress > CONFIG.debounceMs) {
+        leftButtonPressed = true;
+        lastLeftPress = currentTime;
+        powerWake(WAKE_BUTTON);
+        wakeLoop();
+    }
+}
+
+void IRAM_ATTR rightButtonISR() {
+    REARM_BUTTON(CONFIG.pins.rightButton);
+    unsigned long currentTime = millis();
+    if (currentTime - lastRightPress > CONFIG.debounceMs) {
+        rightButtonPressed = true;
+        lastRightPress = currentTime;
+        powerWake(WAKE_BUTTON);
+        wakeLoop();
+    }
+}
+
+#if FEATURE_MPU
+// MPU6050 motion detection: a parked car was moved or knocked
+void IRAM_ATTR motionISR() {
+    powerWake(WAKE_MOTION);
+    wakeLoop();
+}
+#endif
+
+// --- HELPER FUNCTIONS ---
+// Echo time in us; 0 with no echo
+uint16_t readEcho(int trigPin, int echoPin) {
+    digitalWrite(trigPin, LOW);
+    delayMicroseconds(2);
+    digitalWrite(trigPin, HIGH);
+    delayMicroseconds(10);
+    digitalWrite(trigPin, LOW);
+
+    uint32_t duration = pulseIn(echoPin, HIGH, CONFIG.echoTimeoutUs);
+    return duration > 0xFFFF ? 0xFFFF : duration;
+}
+
+#if FEATURE_AMBIENT
+// Blue when cold, red when hot, built once for the configured range
+static_assert((CONFIG.hotTemp - CONFIG.coldTemp) * TEMP_GRADIENT_STEPS_PER_DEG <= 64, "temperature range too wide for the gradient table");
+TempGradient<64> tempGradient(CONFIG.coldTemp, CONFIG.hotTemp);
+#endif
+
+#if FEATURE_PEER
+// --- HTTP COMMUNICATION WITH THE OTHER CAR ---
+// When we last sent; the periodic send only fills in if nothing changed
+unsigned long lastPeerSendMs = 0;
+
+void sendDataToPeer() {
+    char url[40];
+    if (CAR_ROLE == ROLE_MAIN) {
+        if (!peerConnected) return;
+        snprintf(url, sizeof(url), "http://%u.%u.%u.%u/update", peerIP[0], peerIP[1], peerIP[2], peerIP[3]);
+    } else {
+        snprintf(url, sizeof(url), "http://%s/update", CONFIG.mainHost);
+    }
+
+    JsonBuffer<PEER_SYNC_JSON_SIZE> json;
+    writePeerSync(json);
+    if (!jsonFits(json, JSON_PEER_SYNC)) return;
+
+    lastPeerSendMs = millis();
+    HTTPClient http;
+    http.begin(url);
+    http.setConnectTimeout(CONFIG.peerTimeoutMs);
+    http.setTimeout(CONFIG.peerTimeoutMs);
+    http.addHeader("Content-Type", "application/json");
+
+    int httpResponseCode = http.POST((uint8_t *)json.c_str(), json.length());
+    if (httpResponseCode > 0) {
+        // Parse straight off the socket instead of buffering a String
+        StaticJsonDocument<200> responseDoc;
+        deserializeJson(responseDoc, http.getStream());
+        applyPeerReply(millis(), responseDoc["leftIndicator"] | false, responseDoc["rightIndicator"] | false);
+    }
+    http.end();
+}
+
+#if CAR_ROLE == ROLE_MAIN
+// Asks one station for its /status; true if it is Car 2
+bool probeCar2(IPAddress ip, bool &left, bool &right) {
+    char url[40];
+    snprintf(url, sizeof(url), "http://%u.%u.%u.%u/status", ip[0], ip[1], ip[2], ip[3]);
+
+    HTTPClient http;
+    http.begin(url);
+    http.setConnectTimeout(CONFIG.peerTimeoutMs);
+    http.setTimeout(CONFIG.peerTimeoutMs);
+
+    bool found = false;
+    if (http.GET() == 200) {
+        StaticJsonDocument<256> doc;
+        deserializeJson(doc, http.getStream());
+        if (strcmp(doc["type"] | "", "car2") == 0) {
+            found = true;
+            left = doc["leftIndicator"] | false;
+            right = doc["rightIndicator"] | false;
+        }
+    }
+    http.end();
+    return found;
+}
+
+// One HTTP call per check, so the loop waits at most one timeout here
+// however many phones are connected: Car 2 while it answers, otherwise the
+// next station in turn.
+void checkCar2Status() {
+    static uint8_t nextStation = 0;
+    bool found = false;
+    bool left = false, right = false;
+
+    if (peerConnected) {
+        found = probeCar2(peerIP, left, right);
+    } else {
+        wifi_sta_list_t wifi_sta_list;
+        tcpip_adapter_sta_list_t adapter_sta_list;
+        if (esp_wifi_ap_get_sta_list(&wifi_sta_list) == ESP_OK &&
+            tcpip_adapter_get_sta_list(&wifi_sta_list, &adapter_sta_list) == ESP_OK && adapter_sta_list.num > 0) {
+            IPAddress ip(adapter_sta_list.sta[nextStation++ % adapter_sta_list.num].ip.addr);
+            found = probeCar2(ip, left, right);
+            if (found) {
+                peerIP = ip;
+                LOG(MSG_CAR2_FOUND, ip[0], ip[1], ip[2], ip[3]);
+            }
+        }
+    }
+    applyPeerStatus(millis(), found, left, right);
+}
+#endif
+#endif
+
+#if FEATURE_DASHBOARD
+// --- WEBSOCKET HANDLER ---
+// Sent once to a newly connected client so it doesn't wait for the next push
+void sendSnapshot(AsyncWebSocketClient *client) {
+    JsonBuffer<STATE_JSON_SIZE> json;
+    writeStateFrame(json, true, millis());
+    if (jsonFits(json, JSON_SNAPSHOT)) client->text(json.c_str(), json.length());
+}
+
+// Last few minutes at 1 s resolution as one binary frame (see history.h)
+void sendHistory(AsyncWebSocketClient *client) {
+    AsyncWebSocketMessageBuffer *buffer = ws.makeBuffer(historyFrameSize(history.seconds));
+    if (!buffer) return;
+
+    size_t len = encodeHistoryFrame(history.seconds, millis() / 1000, buffer->get(), buffer->length());
+    if (len == 0) {
+        delete buffer;
+        return;
+    }
+    client->binary(buffer);
+}
+
+// --- COMMANDS ---
+void sendAck(AsyncWebSocketClient *client, unsigned long seq, const char *target, const char *error) {
+    JsonBuffer<ACK_JSON_SIZE> json;
+    writeAck(json, seq, target, error);
+    if (jsonFits(json, JSON_ACK)) client->text(json.c_str(), json.length());
+}
+
+void onWsEvent(AsyncWebSocket *server, AsyncWebSocketClient *client, AwsEventType type, void *arg, uint8_t *data, size_t len) {
+    if (type == WS_EVT_CONNECT) {
+        powerWake(WAKE_CLIENT);
+        wakeLoop();
+        LOG(MSG_WS_CONNECT, client->id());
+        sendSnapshot(client);
+        sendHistory(client);
+    } else if (type == WS_EVT_DISCONNECT) {
+        LOG(MSG_WS_DISCONNECT, client->id());
+    } else if (type == WS_EVT_DATA) {
+        AwsFrameInfo *info = (AwsFrameInfo*)arg;
+        if (info->final && info->index == 0 && info->len == len && info->opcode == WS_TEXT) {
+            StaticJsonDocument<200> doc;
+            if (deserializeJson(doc, data, len)) return;
+
+            // {"action":"set","target":"left_indicator","value":true,"seq":17}
+            // The target state is explicit, so a retried or duplicated
+            // command lands on the same state instead of flipping it again.
+            // The loop applies it and sends the ack.
+            if (strcmp(doc["action"] | "", "set") == 0) {
+                const char *target = doc["target"] | "";
+                DashboardCommand command = {client->id(), doc["seq"] | 0UL, findCommandTarget(target),
+                                            doc["value"] | false};
+                if (command.target == COMMAND_TARGETS) sendAck(client, command.seq, target, ACK_UNKNOWN_TARGET);
+                else if (!commandInbox.post(command)) sendAck(client, command.seq, target, ACK_BUSY);
+            }
+        }
+    }
+}
+#endif
+
+// Applies what async_tcp posted, in the order it arrived; loop task only
+void takeInbox() {
+#if FEATURE_PEER
+    UpdateBody body;
+    while (updateInbox.take(body)) applyPeerUpdate(millis(), body);
+#endif
+#if FEATURE_DASHBOARD
+    DashboardCommand command;
+    while (commandInbox.take(command)) {
+        applyCommand(millis(), (CommandTarget)command.target, command.value);
+        AsyncWebSocketClient *client = ws.client(command.clientId);
+        if (client) sendAck(client, command.seq, COMMAND_TARGET_NAMES[command.target], NULL);
+    }
+#endif
+}
+
+// --- POWER ---
+// Jobs that run slower while idle; set when setup() adds them
+int8_t sensorJob = -1;
+int8_t outputJob = -1;
+int8_t statePushJob = -1;
+uint32_t activeCpuMhz = 240;
+
+#if POWER_LIGHT_SLEEP
+// The chip light-sleeps whenever every task is blocked, waking for the next
+// timer, the access point's beacons and the buttons (GPIO wake)
+void setLightSleep(bool on, uint32_t cpuMhz) {
+    esp_pm_config_esp32_t pm = {};
+    pm.max_freq_mhz = cpuMhz;
+    pm.min_freq_mhz = cpuMhz;
+    pm.light_sleep_enable = on;
+    esp_pm_configure(&pm);
+
+    const uint8_t buttons[] = {CONFIG.pins.leftButton, CONFIG.pins.rightButton};
+    for (uint8_t pin : buttons) {
+        if (pin == NO_PIN) continue;
+        if (on) {
+            gpio_wakeup_enable((gpio_num_t)pin, GPIO_INTR_LOW_LEVEL);
+        } else {
+            gpio_wakeup_disable((gpio_num_t)pin);
+            gpio_set_intr_type((gpio_num_t)pin, GPIO_INTR_NEGEDGE);
+        }
+    }
+}
+#endif
+
+// The governor's hook: clock first, so a wake is at full speed at once
+void applyPowerState(PowerState state) {
+    bool idle = state == POWER_IDLE;
+    uint32_t cpuMhz = idle ? CONFIG.idleCpuMhz : activeCpuMhz;
+#if POWER_LIGHT_SLEEP
+    setLightSleep(idle, cpuMhz);
+#else
+    setCpuFrequencyMhz(cpuMhz);
+#endif
+    profiler.clockChanged();
+#if !FEATURE_DASHBOARD
+    // The radio sleeps through more of the access point's beacons
+    esp_wifi_set_ps(idle ? WIFI_PS_MAX_MODEM : WIFI_PS_MIN_MODEM);
+#endif
+
+    scheduler.setPeriod(sensorJob, idle ? CONFIG.idleSensorMs : CONFIG.sensorMs);
+    scheduler.setPeriod(outputJob, idle ? CONFIG.idleOutputMs : CONFIG.outputMs);
+#if FEATURE_DASHBOARD
+    // Nobody is watching while idle; a connection wakes the car first
+    scheduler.setPeriod(statePushJob, idle ? CONFIG.idleSensorMs : CONFIG.wsPushMs);
+#endif
+
+    if (idle) LOG(MSG_POWER_IDLE, cpuMhz, CONFIG.idleSensorMs);
+    else LOG(MSG_POWER_ACTIVE, cpuMhz);
+}
+
+IdleGovernor governor(applyPowerState);
+
+// Anything a parked car with nobody watching wouldn't have
+bool carBusy() {
+    bool busy = carState.speed != 0 || carState.leftIndicator || carState.rightIndicator ||
+                alerts.output(CHANNEL_INDICATORS).type != ALERT_NONE ||
+                alerts.output(CHANNEL_BUZZER).type != ALERT_NONE;
+#if FEATURE_DASHBOARD
+    busy = busy || ws.count() > 0;
+#endif
+    return busy;
+}
+
+// --- RUNTIME INTROSPECTION ---
+// Members of the /debug/runtime report, also pushed to dashboards every 10 s.
+// The report grows with every section a module adds, so it's never built
+// whole on a stack: it streams through a chunk of RUNTIME_CHUNK_SIZE.
+#define RUNTIME_CHUNK_SIZE 256
+#define RUNTIME_FRAME_SLACK 64      // Room for the report to grow between sizing and writing a frame
+
+void writeRuntime(JsonWriter &json) {
+    json.add("uptime", millis() / 1000);
+    json.beginObject("jsonOverflows");
+    for (uint8_t i = 0; i < JSON_SENDERS; i++) json.add(JSON_SENDER_NAMES[i], jsonOverflows[i].load());
+    json.endObject();
+    heapMonitor.write(json);
+    taskStacks.write(json);
+#if FEATURE_PEER
+    updateBodies.write(json);
+    updateInbox.write(json, "updateInbox");
+#endif
+#if FEATURE_DASHBOARD
+    commandInbox.write(json, "commandInbox");
+#endif
+    alerts.write(json);
+    collision.write(json);
+    blinker.write(json);
+#if FEATURE_AMBIENT
+    ambientLight.write(json);
+#endif
+    buzzer.write(json);
+    stateEvents.write(json);
+    recorder.write(json);
+    governor.write(json);
+#if FEATURE_DASHBOARD
+    telemetryLog.write(json);
+#endif
+
+#if FEATURE_DASHBOARD
+    // Messages waiting in each client's send queue; a growing number means
+    // a client (or the link to it) can't keep up with the 100 ms push
+    uint32_t clients = 0, queued = 0, maxQueued = 0;
+    for (AsyncWebSocketClient *client : ws.getClients()) {
+        if (client->status() != WS_CONNECTED) continue;
+        size_t len = client->queueLen();
+        clients++;
+        queued += len;
+        if (len > maxQueued) maxQueued = len;
+    }
+
+    json.beginObject("ws")
+        .add("clients", clients)
+        .add("queued", queued)
+        .add("maxQueued", maxQueued)
+        .endObject();
+#endif
+}
+
+// The whole report as one object, through sink; returns its length
+size_t streamRuntime(JsonSink sink, void *ctx, const char *type = NULL) {
+    JsonBuffer<RUNTIME_CHUNK_SIZE> json;
+    json.setSink(sink, ctx);
+    json.beginObject();
+    if (type) json.add("type", type);
+    writeRuntime(json);
+    json.endObject();
+    json.flush();
+    return json.written();
+}
+
+// Sinks: to a Print (Serial, an HTTP response; pass it as Print *, it isn't
+// always the first base), nowhere (sizing), or into a WebSocket frame,
+// counting what didn't fit
+void printSink(void *ctx, const char *data, size_t len) {
+    static_cast<Print *>(ctx)->write((const uint8_t *)data, len);
+}
+
+void discardSink(void *, const char *, size_t) {}
+
+struct FrameSink {
+    uint8_t *data;
+    size_t size;
+    size_t len;
+};
+
+void frameSink(void *ctx, const char *data, size_t len) {
+    FrameSink *frame = static_cast<FrameSink *>(ctx);
+    size_t room = frame->len < frame->size ? frame->size - frame->len : 0;
+    if (room > 0) memcpy(frame->data + frame->len, data, len < room ? len : room);
+    frame->len += len;
+}
+
+// --- RECORDING ---
+// Recordings are /rec/0001.bin, /rec/0002.bin, ... on LittleFS. One runs from
+// boot while /rec/on exists, so a replay starts from the same state the car
+// did. The oldest are deleted to keep some flash free.
+#define RECORD_DIR "/rec"
+#define RECORD_MARKER RECORD_DIR "/on"
+#define RECORD_MIN_FREE (256UL * 1024)
+
+File recordFile;
+char recordPath[16] = "";
+
+// Numbers of the oldest and newest recordings; newest is 0 if there are none
+uint16_t findRecordings(uint16_t &oldest) {
+    uint16_t newest = 0;
+    oldest = UINT16_MAX;
+    File dir = LittleFS.open(RECORD_DIR);
+    if (!dir || !dir.isDirectory()) return 0;
+    for (File file = dir.openNextFile(); file; file = dir.openNextFile()) {
+        unsigned n;
+        if (sscanf(file.name(), "%u.bin", &n) != 1 || n == 0 || n > UINT16_MAX) continue;
+        if (n < oldest) oldest = n;
+        if (n > newest) newest = n;
+    }
+    return newest;
+}
+
+void recordingPath(char *path, size_t len, uint16_t n) {
+    snprintf(path, len, RECORD_DIR "/%04u.bin", n);
+}
+
+// At boot, if recording is switched on
+void startRecording() {
+    if (!LittleFS.exists(RECORD_MARKER)) return;
+
+    uint16_t oldest;
+    uint16_t newest = findRecordings(oldest);
+    while (newest && oldest <= newest && LittleFS.totalBytes() - LittleFS.usedBytes() < RECORD_MIN_FREE) {
+        char path[16];
+        recordingPath(path, sizeof(path), oldest++);
+        LittleFS.remove(path);
+    }
+
+    recordingPath(recordPath, sizeof(recordPath), newest + 1);
+    recordFile = LittleFS.open(recordPath, FILE_WRITE);
+    if (!recordFile) {
+        Serial.printf("Failed to open %s\n", recordPath);
+        return;
+    }
+    recorder.start(CAR_ROLE, logicConfigHash());
+    Serial.printf("Recording inputs to %s\n", recordPath);
+}
+
+void stopRecording() {
+    recorder.stop();
+    recordFile.close();
+}
+
+// Move what was recorded since the last call from RAM to flash. Stops the
+// recording if the flash is full.
+void flushRecording() {
+    if (!recorder.active()) return;
+    uint8_t chunk[256];
+    size_t len;
+    while ((len = recorder.read(chunk, sizeof(chunk))) > 0) {
+        if (recordFile.write(chunk, len) != len) {
+            stopRecording();
+            Serial.printf("Recording stopped: %s is full\n", recordPath);
+            return;
+        }
+    }
+    recordFile.flush();
+}
+
+// --- SERIAL COMMANDS ---
+// "runtime": same report as /debug/runtime
+// "profile": loop stage timings, "profile reset" starts them over
+// "jobs": scheduled jobs with their lateness
+// "log ...": output format and levels, see handleLogCommand()
+// "record": recording status, "record on" records from the next boot,
+// "record off" stops now
+SerialLineReader<32> serialCommands;
+
+void handleSerialCommand(const char *command) {
+    if (strcmp(command, "runtime") == 0) {
+        heapMonitor.sample();
+        heapMonitor.print(Serial);
+        taskStacks.print(Serial);
+
+        streamRuntime(printSink, static_cast<Print *>(&Serial));
+        Serial.println();
+    } else if (strcmp(command, "profile") == 0) {
+        profiler.print(Serial);
+    } else if (strcmp(command, "jobs") == 0) {
+        scheduler.print(Serial);
+    } else if (strcmp(command, "profile reset") == 0) {
+        profiler.requestReset();
+        Serial.println("Profile reset");
+    } else if (strcmp(command, "record") == 0) {
+        const RecordStats &stats = recorder.stats();
+        if (recorder.active()) {
+            Serial.printf("Recording to %s: %lu records, %lu bytes, %lu lost\n", recordPath,
+                          (unsigned long)stats.records, (unsigned long)stats.bytes, (unsigned long)stats.lost);
+        } else {
+            Serial.println(LittleFS.exists(RECORD_MARKER) ? "Recording from the next boot" : "Recording off");
+        }
+    } else if (strcmp(command, "record on") == 0) {
+        LittleFS.mkdir(RECORD_DIR);
+        File marker = LittleFS.open(RECORD_MARKER, FILE_WRITE);
+        Serial.println(marker ? "Recording from the next boot" : "Failed to switch recording on");
+        marker.close();
+    } else if (strcmp(command, "record off") == 0) {
+        LittleFS.remove(RECORD_MARKER);
+        flushRecording();
+        stopRecording();
+        Serial.println("Recording off");
+    } else if (!handleLogCommand(command, Serial)) {
+        Serial.printf("Unknown command: %s (try \"runtime\", \"profile\", \"jobs\", \"record\" or \"log\")\n", command);
+    }
+}
+
+// --- WEB SERVER ---
+void setupServer() {
+#if FEATURE_DASHBOARD
+    ws.onEvent(onWsEvent);
+    server.addHandler(&ws);
+
+    server.on("/", HTTP_GET, [](AsyncWebServerRequest *request) {
+        request->send_P(200, "text/html", DASHBOARD_PAGE);
+    });
+#endif
+
+    server.on("/status", HTTP_GET, [](AsyncWebServerRequest *request) {
+        JsonBuffer<STATUS_JSON_SIZE> json;
+        writeStatus(json);
+        sendJson(request, json, JSON_STATUS);
+    });
+
+    server.on("/debug/runtime", HTTP_GET, [](AsyncWebServerRequest *request) {
+        heapMonitor.sample();
+        AsyncResponseStream *response = request->beginResponseStream("application/json");
+        streamRuntime(printSink, static_cast<Print *>(response));
+        request->send(response);
+    });
+
+    // Loop stage timings; /debug/profile?reset=1 returns them and starts over
+    server.on("/debug/profile", HTTP_GET, [](AsyncWebServerRequest *request) {
+        JsonBuffer<PROFILE_JSON_SIZE> json;
+        profiler.write(json);
+        if (request->hasParam("reset")) profiler.requestReset();
+        sendJson(request, json, JSON_PROFILE);
+    });
+
+    // Scheduled jobs: runs, skipped periods and start lateness
+    server.on("/debug/jobs", HTTP_GET, [](AsyncWebServerRequest *request) {
+        JsonBuffer<JOBS_JSON_SIZE> json;
+        json.beginObject().add("unit", "us");
+        scheduler.write(json);
+        json.endObject();
+        sendJson(request, json, JSON_JOBS);
+    });
+
+    // The current recording, or the last one; see tools/replay
+    server.on("/record", HTTP_GET, [](AsyncWebServerRequest *request) {
+        uint16_t oldest;
+        uint16_t newest = findRecordings(oldest);
+        if (!newest) {
+            request->send(404, "application/json", "{\"error\":\"no recording\"}");
+            return;
+        }
+        char path[16];
+        recordingPath(path, sizeof(path), newest);
+        request->send(LittleFS, path, "application/octet-stream", true);
+    });
+
+#if FEATURE_DASHBOARD
+    // Range query: /history?res=1|10|60&from=<s>&to=<s> (seconds since boot)
+    server.on("/history", HTTP_GET, [](AsyncWebServerRequest *request) {
+        uint16_t res = request->hasParam("res") ? request->getParam("res")->value().toInt() : 10;
+        const HistoryRing *ring = history.tier(res);
+        if (!ring) {
+            request->send(400, "application/json", "{\"error\":\"res must be 1, 10 or 60\"}");
+            return;
+        }
+
+        uint32_t now = millis() / 1000;
+        uint32_t from = 0, to = now;
+        if (!readSeconds(request, "from", from) || !readSeconds(request, "to", to)) {
+            request->send(400, "application/json", "{\"error\":\"from and to must be whole seconds\"}");
+            return;
+        }
+
+        HistoryJsonReader reader(*ring, from, to, now);
+        request->send(request->beginChunkedResponse("application/json",
+            [reader](uint8_t *buffer, size_t maxLen, size_t index) mutable {
+                return reader.read(buffer, maxLen);
+            }));
+    });
+
+    // The telemetry log, oldest first, streamed: /log as NDJSON, /log?format=bin
+    // as segments of raw records (see telemetrylog.h)
+    server.on("/log", HTTP_GET, [](AsyncWebServerRequest *request) {
+        bool ndjson = !(request->hasParam("format") && request->getParam("format")->value() == "bin");
+        TelemetryLogReader<decltype(telemetryLog)> reader(telemetryLog, ndjson);
+        request->send(request->beginChunkedResponse(ndjson ? "application/x-ndjson" : "application/octet-stream",
+            [reader](uint8_t *buffer, size_t maxLen, size_t index) mutable {
+                return reader.read(buffer, maxLen);
+            }));
+    });
+#endif
+
+#if FEATURE_PEER
+    // The other car's indicators and shared settings; replies with ours.
+    // The body is collected chunk by chunk and applied only once it is
+    // complete and valid; the reply goes out after the last chunk.
+    server.on("/update", HTTP_POST, [](AsyncWebServerRequest *request) {
+        auto *slot = updateBodies.find(request);
+        BodyStatus status = slot ? slot->status : BODY_INVALID;
+        updateBodies.release(request);
+
+        if (status == BODY_TOO_LARGE) {
+            request->send(413, "application/json", "{\"error\":\"body too large\"}");
+        } else if (status != BODY_OK) {
+            request->send(400, "application/json", "{\"error\":\"invalid body\"}");
+        } else {
+            JsonBuffer<UPDATE_REPLY_JSON_SIZE> json;
+            writeUpdateReply(json);
+            sendJson(request, json, JSON_UPDATE);
+        }
+    }, NULL,
+        [](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+            if (index == 0) request->onDisconnect([request]() { updateBodies.release(request); });
+
+            auto *slot = updateBodies.receive(request, data, len, index, total, millis());
+            UpdateBody body;
+            if (slot && updateBodies.parse(slot, body)) updateInbox.post(body);
+        });
+#endif
+
+    server.begin();
+    Serial.println("HTTP server started");
+}
+
+// =================================================================
+//                       JOBS
+// =================================================================
+// Periodic work, run by the scheduler against absolute deadlines
+void readSensors() {
+    unsigned long currentTime = millis();
+
+    // DHT11
+    uint32_t stageStart = profiler.now();
+    applyClimate(currentTime, dht.readTemperature(), dht.readHumidity());
+    profiler.record(STAGE_DHT, stageStart);
+
+    // Ultrasonic sensors
+    stageStart = profiler.now();
+    uint16_t frontUs = readEcho(CONFIG.pins.frontTrig, CONFIG.pins.frontEcho);
+    uint16_t backUs = readEcho(CONFIG.pins.backTrig, CONFIG.pins.backEcho);
+    applyEchoes(currentTime, frontUs, backUs);
+    profiler.record(STAGE_ULTRASONIC, stageStart);
+
+#if FEATURE_MPU
+    // MPU6050
+    stageStart = profiler.now();
+    sensors_event_t a, g, temp;
+    if (mpu.getEvent(&a, &g, &temp)) {
+        applyMotion(currentTime, a.acceleration.x, a.acceleration.y, a.acceleration.z, g.gyro.z);
+    }
+    profiler.record(STAGE_MPU, stageStart);
+#endif
+
+#if FEATURE_DASHBOARD
+    history.record(currentTime, carState.temp, carState.humidity, carState.frontDist,
+                   carState.backDist, carState.speed, carState.direction);
+#endif
+}
+
+// The arbiter picks one alert per output; only outputs whose alert changed
+// are touched
+void applyAlerts(unsigned long currentTime) {
+    uint8_t changed = resolveOutputs(currentTime);
+
+    // Indicators: the timer blinks them
+    if (changed & CHANNEL_BIT(CHANNEL_INDICATORS)) {
+        const AlertOutput &out = alerts.output(CHANNEL_INDICATORS);
+        blinker.setMode(out.type == ALERT_INDICATOR ? out.value : BLINK_OFF);
+        alerts.applied(CHANNEL_INDICATORS);
+    }
+
+    // Buzzer: the timer plays the pattern
+    if (changed & CHANNEL_BIT(CHANNEL_BUZZER)) {
+        const AlertOutput &out = alerts.output(CHANNEL_BUZZER);
+        switch (out.type) {
+            case ALERT_INDICATOR: buzzer.play(BUZZ_INDICATOR); break;
+            case ALERT_PROXIMITY:
+                buzzer.setDistance(out.value);
+                buzzer.play(BUZZ_PROXIMITY);
+                break;
+            case ALERT_COLLISION:
+                // Beeps quicken with the grade; critical is the alarm
+                buzzer.setGap(out.value == COLLISION_CAUTION ? BUZZ_GAP_CAUTION_US : BUZZ_GAP_WARNING_US);
+                buzzer.play(out.value == COLLISION_CRITICAL ? BUZZ_ALARM : BUZZ_PROXIMITY);
+                break;
+            case ALERT_OBSTACLE:  buzzer.play(BUZZ_ALARM); break;
+            default:              buzzer.play(BUZZ_NONE); break;
+        }
+        alerts.applied(CHANNEL_BUZZER);
+    }
+
+#if FEATURE_AMBIENT
+    // Ambient light: only the layers are set here; the outputs job renders
+    if (changed & CHANNEL_BIT(CHANNEL_AMBIENT)) {
+        // Red flash for an obstacle, amber to red by collision grade, slow
+        // blue pulse while Car 2 isn't connected
+        const AlertOutput &out = alerts.output(CHANNEL_AMBIENT);
+        AlertType type = out.type;
+        if (type == ALERT_COLLISION) {
+            static const uint32_t GRADE_COLORS[COLLISION_LEVELS] = {0, 0xFFB000, 0xFF5000, 0xFF0000};
+            ambientAnim.setAlert(true, currentTime, GRADE_COLORS[out.value]);
+        } else {
+            ambientAnim.setAlert(type == ALERT_OBSTACLE, currentTime);
+        }
+        ambientAnim.setPulse(type == ALERT_PEER_LOST);
+        alerts.applied(CHANNEL_AMBIENT);
+    }
+#endif
+}
+
+// State an output shows changed: raise what applies and apply it now,
+// without waiting for the next outputs job
+void onOutputState(uint32_t fields) {
+    unsigned long currentTime = millis();
+    uint32_t outputStart = profiler.now();
+    raiseStateAlerts(currentTime);
+    buzzer.setEnabled(carState.buzzerOn);
+#if FEATURE_AMBIENT
+    ambientAnim.setEnabled(carState.ambientOn);
+    if (fields & EVENT_BIT(FIELD_TEMP)) ambientAnim.setBase(tempGradient.color(carState.temp));
+#endif
+    applyAlerts(currentTime);
+    profiler.record(STAGE_OUTPUTS, outputStart);
+}
+
+// Alerts lapse and the ambient light animates without a state change. The
+// animator renders a frame every ANIM_FRAME_MS; show() only sends it if it
+// changed, and never waits for the strip.
+void updateOutputs() {
+    unsigned long currentTime = millis();
+    uint32_t outputStart = profiler.now();
+    applyAlerts(currentTime);
+#if FEATURE_AMBIENT
+    if (ambientAnim.render(currentTime)) ambientAnim.copyTo(ambientLight);
+    ambientLight.show();
+#endif
+    profiler.record(STAGE_OUTPUTS, outputStart);
+}
+
+#if FEATURE_PEER
+#if CAR_ROLE == ROLE_MAIN
+void checkPeerJob() {
+    uint32_t stageStart = profiler.now();
+    checkCar2Status();
+    profiler.record(STAGE_PEER_CHECK, stageStart);
+}
+#endif
+
+// Our indicators or shared settings changed, or the other car just showed up
+void onPeerState(uint32_t fields) {
+    uint32_t stageStart = profiler.now();
+    sendDataToPeer();
+    profiler.record(STAGE_PEER_SEND, stageStart);
+}
+
+// Resend in case a change was lost; skipped if one went out recently
+void sendPeerJob() {
+    if (millis() - lastPeerSendMs < CONFIG.peerSendMs) return;
+    onPeerState(0);
+}
+#endif
+
+#if FEATURE_DASHBOARD
+unsigned long lastStatePushMs = 0;
+
+void onDashboardState(uint32_t fields) {
+    if (ws.count() == 0) return;
+    uint32_t stageStart = profiler.now();
+    JsonBuffer<STATE_JSON_SIZE> json;
+    writeStateFrame(json, false, 0);
+    if (jsonFits(json, JSON_STATE)) ws.textAll(json.c_str(), json.length());
+    lastStatePushMs = millis();
+    profiler.record(STAGE_WS_PUSH, stageStart);
+}
+
+// Nothing changed for a while: push anyway so the page knows the link is up
+void pushStateJob() {
+    if (millis() - lastStatePushMs < CONFIG.wsKeepaliveMs) return;
+    onDashboardState(0);
+}
+
+// One sample of what the dashboard shows, for the flash log
+void logTelemetryJob() {
+    TelemetryRecord rec;
+    rec.timeMs = millis();
+    rec.temp = lroundf(carState.temp * 10);
+    rec.humidity = lroundf(carState.humidity * 10);
+    rec.frontMm = lroundf(carState.frontDist * 10);
+    rec.backMm = lroundf(carState.backDist * 10);
+    rec.direction = lroundf(carState.direction * 10);
+    rec.speed = carState.speed;
+    rec.flags = (carState.leftIndicator ? TLOG_LEFT : 0) | (carState.rightIndicator ? TLOG_RIGHT : 0) |
+                (carState.buzzerOn ? TLOG_BUZZER : 0) | (carState.ambientOn ? TLOG_AMBIENT : 0) |
+                (carState.peerLeft ? TLOG_PEER_LEFT : 0) | (carState.peerRight ? TLOG_PEER_RIGHT : 0) |
+                (peerConnected ? TLOG_PEER_CONNECTED : 0);
+    telemetryLog.append(rec);
+}
+
+// Runtime snapshot for dashboards
+void pushRuntimeJob() {
+    if (ws.count() == 0) return;
+    heapMonitor.sample();
+
+    // Sized by a first pass, written by a second into the frame itself. The
+    // numbers can grow in between; the slack takes that up, and trailing
+    // spaces fill what's left.
+    AsyncWebSocketMessageBuffer *buffer = ws.makeBuffer(streamRuntime(discardSink, NULL, "runtime") + RUNTIME_FRAME_SLACK);
+    if (!buffer) return;
+    FrameSink frame = {buffer->get(), buffer->length(), 0};
+    streamRuntime(frameSink, &frame, "runtime");
+    if (frame.len > frame.size) {
+        delete buffer;
+        jsonDropped(JSON_RUNTIME, frame.size);
+        return;
+    }
+    memset(frame.data + frame.len, ' ', frame.size - frame.len);
+    ws.textAll(buffer);
+}
+#endif
+
+// Heap report; a falling "lowest" block means fragmentation
+void reportHeapJob() {
+    heapMonitor.sample();
+    heapMonitor.log();
+}
+
+// =================================================================
+//                      SETUP
+// =================================================================
+void setup() {
+    Serial.begin(115200);
+    logger.begin(Serial);
+    delay(1000);
+    Serial.printf("Starting Smart Car - %s\n", CONFIG.name);
+
+    // Initialize Pins
+    pinMode(CONFIG.pins.leftLed, OUTPUT);
+    pinMode(CONFIG.pins.rightLed, OUTPUT);
+    pinMode(CONFIG.pins.frontTrig, OUTPUT);
+    pinMode(CONFIG.pins.frontEcho, INPUT);
+    pinMode(CONFIG.pins.backTrig, OUTPUT);
+    pinMode(CONFIG.pins.backEcho, INPUT);
+
+    // Attach Interrupts
+    pinMode(CONFIG.pins.leftButton, INPUT_PULLUP);
+    attachInterrupt(digitalPinToInterrupt(CONFIG.pins.leftButton), leftButtonISR, FALLING);
+    if (CONFIG.pins.rightButton != NO_PIN) {
+        pinMode(CONFIG.pins.rightButton, INPUT_PULLUP);
+        attachInterrupt(digitalPinToInterrupt(CONFIG.pins.rightButton), rightButtonISR, FALLING);
+    }
+
+    // Buzzer patterns run on their own timer, one tick per blink cycle
+    if (!buzzer.begin(CONFIG.pins.buzzer, CONFIG.obstacleCm * 10, CONFIG.proximityCm * 10, CONFIG.blinkMs * 2000UL)) {
+        Serial.println("Failed to create buzzer timer");
+    }
+
+    // Recordings and the telemetry log; formats the partition the first time
+    if (LittleFS.begin(true)) {
+        startRecording();
+#if FEATURE_DASHBOARD
+        if (!telemetryLog.begin(LittleFS)) Serial.println("Failed to open the telemetry log");
+#endif
+    } else {
+        Serial.println("Failed to mount LittleFS");
+    }
+
+    // Initialize Sensors
+    dht.begin();
+    Serial.println("DHT11 initialized");
+
+#if FEATURE_AMBIENT
+    // Brightness is applied by the animator's gamma table, not the strip
+    ambientAnim.begin(CONFIG.neopixelBrightness, CONFIG.blinkMs);
+    if (ambientLight.begin()) {
+        ambientLight.clear();
+        ambientLight.show();
+        Serial.println("NeoPixel initialized");
+    } else {
+        Serial.println("Failed to start NeoPixel RMT channel");
+    }
+#endif
+
+#if FEATURE_MPU
+    Wire.begin();
+    if (!mpu.begin()) {
+        Serial.println("Failed to find MPU6050 chip");
+    } else {
+        mpu.setAccelerometerRange(MPU6050_RANGE_8_G);
+        mpu.setGyroRange(MPU6050_RANGE_500_DEG);
+        mpu.setFilterBandwidth(MPU6050_BAND_21_HZ);
+
+        // Motion interrupt, to wake from idle between the slow sensor reads.
+        // The high-pass filter only feeds motion detection, not the readings.
+        if (CONFIG.pins.mpuInt != NO_PIN) {
+            mpu.setHighPassFilter(MPU6050_HIGHPASS_0_63_HZ);
+            mpu.setMotionDetectionThreshold(1);
+            mpu.setMotionDetectionDuration(20);
+            mpu.setInterruptPinLatch(false);    // A 50 us pulse per detection
+            mpu.setMotionInterrupt(true);
+            pinMode(CONFIG.pins.mpuInt, INPUT);
+            attachInterrupt(digitalPinToInterrupt(CONFIG.pins.mpuInt), motionISR, RISING);
+        }
+        Serial.println("MPU6050 initialized");
+    }
+#endif
+
+#if FEATURE_DASHBOARD
+    // Initialize WiFi AP
+    WiFi.mode(WIFI_AP);
+    WiFi.softAP(CONFIG.ssid, CONFIG.password);
+    Serial.print("AP IP address: ");
+    Serial.println(WiFi.softAPIP());
+
+    Serial.printf("Telemetry history: %u bytes\n", (unsigned)TelemetryHistory::kBytes);
+#else
+    // Connect to Car 1's WiFi
+    WiFi.mode(WIFI_STA);
+    WiFi.begin(CONFIG.ssid, CONFIG.password);
+
+    while (WiFi.status() != WL_CONNECTED) {
+        delay(1000);
+        Serial.println("Connecting to WiFi...");
+    }
+
+    Serial.println("WiFi connected!");
+    Serial.print("IP address: ");
+    Serial.println(WiFi.localIP());
+#endif
+
+    profiler.begin();
+    heapMonitor.sample();
+    heapMonitor.print(Serial);
+
+    setupServer();
+
+    // LED test
+    digitalWrite(CONFIG.pins.leftLed, HIGH);
+    digitalWrite(CONFIG.pins.rightLed, HIGH);
+    delay(500);
+    digitalWrite(CONFIG.pins.leftLed, LOW);
+    digitalWrite(CONFIG.pins.rightLed, LOW);
+
+    // From here on the LEDs belong to the blinker's timer
+    if (!blinker.begin(CONFIG.pins.leftLed, CONFIG.pins.rightLed, CONFIG.blinkMs * 1000UL)) {
+        Serial.println("Failed to create blinker timer");
+    }
+
+    // Periodic jobs. Phases (last argument, ms) keep the slow ones apart:
+    // sensors fall on multiples of 250 ms and can take ~70 ms, so the HTTP
+    // jobs sit in the middle of the gaps, at 125 and 375 ms past a 500 ms
+    // boundary. The light jobs go anywhere.
+    sensorJob = scheduler.add("sensors", readSensors, CONFIG.sensorMs, 0);
+    outputJob = scheduler.add(STAGE_NAMES[STAGE_OUTPUTS], updateOutputs, CONFIG.outputMs, 3);
+#if FEATURE_PEER
+#if CAR_ROLE == ROLE_MAIN
+    scheduler.add(STAGE_NAMES[STAGE_PEER_CHECK], checkPeerJob, CONFIG.peerCheckMs, 375);
+#endif
+    scheduler.add(STAGE_NAMES[STAGE_PEER_SEND], sendPeerJob, CONFIG.peerSendMs, 125);
+#endif
+#if FEATURE_DASHBOARD
+    statePushJob = scheduler.add(STAGE_NAMES[STAGE_WS_PUSH], pushStateJob, CONFIG.wsPushMs, 30);
+    scheduler.add("runtime_push", pushRuntimeJob, CONFIG.runtimePushMs, 5040);
+    scheduler.add("tlog", logTelemetryJob, CONFIG.telemetryLogMs, 100);
+#endif
+    scheduler.add("heap", reportHeapJob, CONFIG.heapReportMs, 15090);
+    scheduler.add("record", flushRecording, CONFIG.recordFlushMs, 690);
+
+    // Consumers of state changes. Every field counts as changed once, so
+    // each starts from the current state.
+    stateEvents.subscribe("outputs", OUTPUT_FIELDS, 0, onOutputState);
+#if FEATURE_DASHBOARD
+    stateEvents.subscribe("dashboard", ALL_FIELDS, CONFIG.wsPushMs, onDashboardState);
+#endif
+#if FEATURE_PEER
+    stateEvents.subscribe("peer", EVENT_BIT(FIELD_LEFT) | EVENT_BIT(FIELD_RIGHT) | EVENT_BIT(FIELD_BUZZER) |
+                          EVENT_BIT(FIELD_AMBIENT) | EVENT_BIT(FIELD_PEER_CONNECTED), 0, onPeerState);
+#endif
+    for (uint8_t field = 0; field < STATE_FIELDS; field++) stateEvents.publish(field);
+
+    loopTaskHandle = xTaskGetCurrentTaskHandle();
+    scheduler.start();
+
+    // Parked with nothing on for a while: slower clock and jobs
+#if POWER_LIGHT_SLEEP
+    esp_sleep_enable_gpio_wakeup();
+#endif
+    activeCpuMhz = getCpuFrequencyMhz();
+    governor.begin(CONFIG.idleAfterMs, POWER_LIGHT_SLEEP ? POWER_LIGHT_SLEEP_MA : POWER_IDLE_MA);
+
+    Serial.println("Setup complete");
+}
+
+// =================================================================
+//                       MAIN LOOP
+// =================================================================
+void loop() {
+    // First, so a button or client wake is back at full rate before any job runs
+    governor.wake();
+
+    profiler.beginLoop();
+    uint32_t loopStart = profiler.now();
+
+#if FEATURE_DASHBOARD
+    ws.cleanupClients();
+#endif
+    const char *command = serialCommands.poll(Serial);
+    if (command) handleSerialCommand(command);
+
+    // Handle Button Presses; a change reaches its consumers before any job
+    // runs, and changes made by jobs right after them
+    bool leftPressed = leftButtonPressed;
+    if (leftPressed) leftButtonPressed = false;
+    bool rightPressed = rightButtonPressed;
+    if (rightPressed) rightButtonPressed = false;
+    handleButtons(millis(), leftPressed, rightPressed);
+    takeInbox();
+    stateEvents.dispatch();
+
+    scheduler.run();
+    stateEvents.dispatch();
+    governor.update(carBusy());
+    profiler.record(STAGE_LOOP, loopStart);
+
+    // Nothing due: sleep until the next deadline or merged state change
+    // instead of spinning. A button press or a change published from
+    // another task wakes the loop early.
+    uint32_t idleUs = min(scheduler.idleUs(), stateEvents.idleUs());
+    if (idleUs >= 1000) {
+        uint32_t sleepStart = micros();
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(idleUs / 1000));
+        governor.slept(micros() - sleepStart);
+    }
+}
@@ -0,0 +1,427 @@
+/*
+ * Smart Car Dashboard - Telemetry Log
+ * Author: Stromlabs - Pavan Kalsariya
+ * Date: July 2025
+ * Description: Car 1's dashboard values, kept on flash across power cycles.
+ * The loop appends a 16-byte record at a fixed rate into a RAM ring and
+ * returns; a low-priority task on core 0 writes the ring to LittleFS one
+ * whole 4 KB block at a time, so flash is written rarely and never from the
+ * loop. Blocks go into segment files that rotate: a new one each boot and
+ * every TLOG_SEGMENT_BLOCKS, and the oldest is deleted past
+ * TLOG_MAX_SEGMENTS. Deleting and rewriting whole segments, on top of
+ * LittleFS's own wear levelling, spreads erases over the partition instead
+ * of rewriting one spot. /log streams every segment and then the part still
+ * in RAM, a batch at a time, as NDJSON or as the raw records.
+ *
+ * Segment (little-endian): a 16-byte header, then records.
+ *   magic "SCTL", version, record size, boot (u16), first record number of
+ *   the boot (u32), record count (u32; 0xFFFFFFFF on flash: to end of file)
+ * The binary stream is the same, with each segment's count filled in.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <atomic>
+#include "jsonwriter.h"
+#include "profiler.h"
+
+// --- FORMAT ---
+#define TLOG_MAGIC "SCTL"
+#define TLOG_VERSION 1
+#define TLOG_HEADER_SIZE 16
+#define TLOG_OPEN_COUNT 0xFFFFFFFFUL
+
+#define TLOG_DIR "/tlog"
+#define TLOG_BLOCK_BYTES 4096
+#define TLOG_SEGMENT_BLOCKS 16          // 64 KB, 68 min at 1 Hz
+#define TLOG_MAX_SEGMENTS 8             // About 9 h at 1 Hz
+#define TLOG_MIN_FREE (128UL * 1024)    // Left for recordings and the FS itself
+
+enum TelemetryFlag : uint8_t {
+    TLOG_LEFT = 1 << 0,
+    TLOG_RIGHT = 1 << 1,
+    TLOG_BUZZER = 1 << 2,
+    TLOG_AMBIENT = 1 << 3,
+    TLOG_PEER_LEFT = 1 << 4,
+    TLOG_PEER_RIGHT = 1 << 5,
+    TLOG_PEER_CONNECTED = 1 << 6,
+};
+
+struct TelemetryRecord {
+    uint32_t timeMs;        // Since boot
+    int16_t temp;           // Tenths of a degree C
+    uint16_t humidity;      // Tenths of a percent
+    uint16_t frontMm;
+    uint16_t backMm;
+    int16_t direction;      // Tenths of a degree
+    uint8_t speed;
+    uint8_t flags;          // TelemetryFlag bits
+};
+
+static_assert(sizeof(TelemetryRecord) == 16, "TelemetryRecord is stored as-is");
+
+#define TLOG_BLOCK_RECORDS (TLOG_BLOCK_BYTES / sizeof(TelemetryRecord))
+
+struct TelemetryHeader {
+    char magic[4];
+    uint8_t version;
+    uint8_t recordSize;
+    uint16_t boot;
+    uint32_t first;
+    uint32_t count;
+};
+
+static_assert(sizeof(TelemetryHeader) == TLOG_HEADER_SIZE, "TelemetryHeader is stored as-is");
+
+inline TelemetryHeader telemetryHeader(uint16_t boot, uint32_t first, uint32_t count) {
+    TelemetryHeader h = {{'S', 'C', 'T', 'L'}, TLOG_VERSION, sizeof(TelemetryRecord), boot, first, count};
+    return h;
+}
+
+// One NDJSON line, without the newline
+inline void writeTelemetryJson(JsonWriter &json, uint16_t boot, uint32_t n, const TelemetryRecord &r) {
+    json.beginObject()
+        .add("boot", boot)
+        .add("n", n)
+        .add("t", r.timeMs)
+        .add("temp", r.temp * 0.1f, 1)
+        .add("humidity", r.humidity * 0.1f, 1)
+        .add("frontDist", r.frontMm * 0.1f, 1)
+        .add("backDist", r.backMm * 0.1f, 1)
+        .add("speed", r.speed)
+        .add("direction", r.direction * 0.1f, 1)
+        .add("leftIndicator", (bool)(r.flags & TLOG_LEFT))
+        .add("rightIndicator", (bool)(r.flags & TLOG_RIGHT))
+        .add("buzzerOn", (bool)(r.flags & TLOG_BUZZER))
+        .add("ambientOn", (bool)(r.flags & TLOG_AMBIENT))
+        .add("car2Left", (bool)(r.flags & TLOG_PEER_LEFT))
+        .add("car2Right", (bool)(r.flags & TLOG_PEER_RIGHT))
+        .add("car2Connected", (bool)(r.flags & TLOG_PEER_CONNECTED))
+        .endObject();
+}
+
+// Reads and checks a segment's header
+inline bool readTelemetryHeader(File &file, TelemetryHeader &h) {
+    return file && file.read((uint8_t *)&h, sizeof(h)) == sizeof(h) && memcmp(h.magic, TLOG_MAGIC, 4) == 0 &&
+           h.version == TLOG_VERSION && h.recordSize == sizeof(TelemetryRecord);
+}
+
+inline void telemetrySegmentPath(char *path, size_t len, uint32_t segment) {
+    snprintf(path, len, TLOG_DIR "/%08lu.bin", (unsigned long)segment);
+}
+
+// --- LOG ---
+// Segment numbers are shared by the writer task and /log readers
+static portMUX_TYPE tlogMux = portMUX_INITIALIZER_UNLOCKED;
+
+// RingRecords: a multiple of TLOG_BLOCK_RECORDS, at least two blocks so the
+// loop fills one while the other is written
+template <uint16_t RingRecords>
+class TelemetryLog {
+public:
+    static_assert(RingRecords % TLOG_BLOCK_RECORDS == 0 && RingRecords >= 2 * TLOG_BLOCK_RECORDS,
+                  "RingRecords must be two or more whole blocks");
+
+    // Finds the segments already on flash and starts the writer task.
+    // Returns false if the directory can't be used; appends still go to RAM.
+    bool begin(fs::LittleFSFS &fs) {
+        fs_ = &fs;
+        fs.mkdir(TLOG_DIR);
+        File dir = fs.open(TLOG_DIR);
+        if (!dir || !dir.isDirectory()) return false;
+
+        uint32_t oldest = UINT32_MAX, newest = 0;
+        for (File file = dir.openNextFile(); file; file = dir.openNextFile()) {
+            unsigned long n;
+            if (sscanf(file.name(), "%lu.bin", &n) != 1 || n == 0) continue;
+            if (n < oldest) oldest = n;
+            if (n > newest) newest = n;
+        }
+        if (newest) {
+            oldest_ = oldest;
+            newest_ = newest;
+            TelemetryHeader h;
+            if (readHeader(newest, h)) boot_ = h.boot + 1;
+        } else {
+            oldest_ = newest_ = 0;
+        }
+
+        if (!task_) xTaskCreatePinnedToCore(writerTask, "tlog", 4096, this, 1, &task_, 0);
+        return true;
+    }
+
+    // --- APPEND (loop task) ---
+    // Dropped and counted if the writer is a whole ring behind
+    void append(const TelemetryRecord &rec) {
+        uint32_t n = appended_.load(std::memory_order_relaxed);
+        if (n - flashed_.load(std::memory_order_acquire) >= RingRecords) {
+            dropped_++;
+            return;
+        }
+        ring_[n % RingRecords] = rec;
+        appended_.store(n + 1, std::memory_order_release);
+        if ((n + 1) % TLOG_BLOCK_RECORDS == 0 && task_) xTaskNotifyGive(task_);
+    }
+
+    // --- READING (any task) ---
+    uint16_t boot() const { return boot_; }
+    uint32_t appended() const { return appended_.load(std::memory_order_acquire); }
+    void segments(uint32_t &oldest, uint32_t &newest) const {
+        portENTER_CRITICAL(&tlogMux);
+        oldest = oldest_;
+        newest = newest_;
+        portEXIT_CRITICAL(&tlogMux);
+    }
+
+    // Copies records [first, first + max) of this boot still held in RAM;
+    // returns how many, 0 once first has been overwritten or not appended
+    uint16_t copyRecent(uint32_t first, TelemetryRecord *out, uint16_t max) const {
+        uint32_t end = appended();
+        if (first >= end || end - first >= RingRecords) return 0;
+        uint16_t n = end - first < max ? end - first : max;
+        for (uint16_t i = 0; i < n; i++) out[i] = ring_[(first + i) % RingRecords];
+        // The loop may have reused slots while they were copied
+        if (appended() - first >= RingRecords) return 0;
+        return n;
+    }
+
+    bool readHeader(uint32_t segment, TelemetryHeader &h) const {
+        char path[24];
+        telemetrySegmentPath(path, sizeof(path), segment);
+        File file = fs_->open(path);
+        bool ok = readTelemetryHeader(file, h);
+        file.close();
+        return ok;
+    }
+
+    fs::LittleFSFS *fs() const { return fs_; }
+
+    // "tlog":{"boot":..,"records":..,"flashed":..,"dropped":..,"segments":..,"failed":..,"writeP50Us":..,"writeMaxUs":..}
+    void write(JsonWriter &json, const char *key = "tlog") const {
+        uint32_t oldest, newest;
+        segments(oldest, newest);
+        json.beginObject(key)
+            .add("boot", boot_)
+            .add("records", appended())
+            .add("flashed", flashed_.load(std::memory_order_relaxed))
+            .add("dropped", dropped_)
+            .add("segments", newest ? newest - oldest + 1 : 0)
+            .add("failed", failed_)
+            .add("writeP50Us", writes_.percentileUs(50))
+            .add("writeMaxUs", writes_.maxUs())
+            .endObject();
+    }
+
+private:
+    static void writerTask(void *arg) {
+        TelemetryLog *self = (TelemetryLog *)arg;
+        for (;;) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            while (!self->failed_ && self->appended() - self->flashed_.load() >= TLOG_BLOCK_RECORDS) self->writeBlock();
+        }
+    }
+
+    // Opens the next segment, deleting the oldest to make room
+    bool rotate() {
+        file_.close();
+        uint32_t next = newest_ + 1;
+        for (;;) {
+            uint32_t held = newest_ ? newest_ - oldest_ + 1 : 0;
+            if (held == 0) break;
+            if (held < TLOG_MAX_SEGMENTS && fs_->totalBytes() - fs_->usedBytes() >= TLOG_MIN_FREE) break;
+            char old[24];
+            telemetrySegmentPath(old, sizeof(old), oldest_);
+            fs_->remove(old);
+            portENTER_CRITICAL(&tlogMux);
+            if (oldest_ == newest_) oldest_ = newest_ = 0;
+            else oldest_++;
+            portEXIT_CRITICAL(&tlogMux);
+        }
+
+        char path[24];
+        telemetrySegmentPath(path, sizeof(path), next);
+        file_ = fs_->open(path, FILE_WRITE);
+        TelemetryHeader h = telemetryHeader(boot_, flashed_.load(), TLOG_OPEN_COUNT);
+        if (!file_ || file_.write((const uint8_t *)&h, sizeof(h)) != sizeof(h)) return false;
+
+        portENTER_CRITICAL(&tlogMux);
+        if (!oldest_) oldest_ = next;
+        newest_ = next;
+        portEXIT_CRITICAL(&tlogMux);
+        segmentBlocks_ = 0;
+        return true;
+    }
+
+    // The oldest unwritten block: the loop won't touch it until it's flashed
+    void writeBlock() {
+        uint32_t start = micros();
+        if ((!file_ || segmentBlocks_ >= TLOG_SEGMENT_BLOCKS) && !rotate()) {
+            failed_ = true;
+            return;
+        }
+        uint32_t first = flashed_.load();
+        const uint8_t *block = (const uint8_t *)&ring_[first % RingRecords];
+        if (file_.write(block, TLOG_BLOCK_BYTES) != TLOG_BLOCK_BYTES) {
+            failed_ = true;
+            return;
+        }
+        file_.flush();
+        segmentBlocks_++;
+        flashed_.store(first + TLOG_BLOCK_RECORDS, std::memory_order_release);
+        writes_.record(micros() - start);
+    }
+
+    TelemetryRecord ring_[RingRecords];
+    std::atomic<uint32_t> appended_{0};     // Loop task only writes
+    std::atomic<uint32_t> flashed_{0};      // Writer task only writes
+    uint32_t dropped_ = 0;
+    volatile bool failed_ = false;          // Flash full or gone; the ring keeps the latest records
+
+    fs::LittleFSFS *fs_ = NULL;
+    File file_;
+    uint16_t segmentBlocks_ = 0;
+    uint16_t boot_ = 1;
+    uint32_t oldest_ = 0, newest_ = 0;      // Segment numbers on flash; 0 for none
+    LatencyHistogram writes_;               // Whole block, rotation included
+    TaskHandle_t task_ = NULL;
+};
+
+// --- STREAMING ---
+// Fills chunked responses for /log: every segment on flash, oldest first,
+// then the records of this boot not yet written. Reads a batch at a time,
+// reopening the file each time, so a segment deleted mid-download is skipped
+// instead of read from under the writer.
+template <typename Log>
+class TelemetryLogReader {
+public:
+    TelemetryLogReader(const Log &log, bool ndjson) : log_(&log), ndjson_(ndjson) {
+        log.segments(segment_, lastSegment_);
+        if (!lastSegment_) segment_ = 1;
+    }
+
+    size_t read(uint8_t *out, size_t maxLen) {
+        size_t written = 0;
+        while (written < maxLen) {
+            if (pos_ == len_ && !nextPiece()) break;
+            size_t n = len_ - pos_;
+            if (n > maxLen - written) n = maxLen - written;
+            memcpy(out + written, piece_ + pos_, n);
+            pos_ += n;
+            written += n;
+        }
+        return written;
+    }
+
+private:
+    static const uint16_t kBatch = 32;
+
+    // The next header, NDJSON line or raw record into piece_
+    bool nextPiece() {
+        pos_ = len_ = 0;
+        if (batchPos_ == batchLen_ && !nextBatch()) return false;
+        if (headerPending_) {
+            headerPending_ = false;
+            if (!ndjson_) {
+                TelemetryHeader h = telemetryHeader(boot_, n_, count_);
+                memcpy(piece_, &h, sizeof(h));
+                len_ = sizeof(h);
+                return true;
+            }
+        }
+
+        const TelemetryRecord &rec = batch_[batchPos_++];
+        if (ndjson_) {
+            JsonWriter json(piece_, sizeof(piece_) - 1);
+            writeTelemetryJson(json, boot_, n_, rec);
+            len_ = json.length();
+            piece_[len_++] = '\n';
+        } else {
+            memcpy(piece_, &rec, sizeof(rec));
+            len_ = sizeof(rec);
+        }
+        n_++;
+        return true;
+    }
+
+    bool nextBatch() {
+        batchPos_ = batchLen_ = 0;
+        while (segment_ <= lastSegment_) {
+            if (remaining_ == 0 && !openSegment()) {
+                segment_++;
+                continue;
+            }
+            char path[24];
+            telemetrySegmentPath(path, sizeof(path), segment_);
+            File file = log_->fs()->open(path);
+            uint16_t want = remaining_ < kBatch ? remaining_ : kBatch;
+            size_t got = file && file.seek(offset_) ? file.read((uint8_t *)batch_, want * sizeof(TelemetryRecord)) : 0;
+            file.close();
+            batchLen_ = got / sizeof(TelemetryRecord);
+            if (batchLen_ == 0) {       // Deleted under us
+                remaining_ = 0;
+                segment_++;
+                continue;
+            }
+            offset_ += batchLen_ * sizeof(TelemetryRecord);
+            remaining_ -= batchLen_;
+            if (remaining_ == 0) segment_++;
+            if (boot_ == log_->boot()) recentFrom_ = n_ + batchLen_;
+            return true;
+        }
+
+        // Then what this boot has appended since, from RAM
+        if (!recentStarted_) {
+            recentStarted_ = true;
+            uint32_t end = log_->appended();
+            boot_ = log_->boot();
+            n_ = recentFrom_;
+            count_ = remaining_ = end > recentFrom_ ? end - recentFrom_ : 0;
+            headerPending_ = count_ > 0;
+        }
+        if (remaining_ == 0) return false;
+        uint16_t want = remaining_ < kBatch ? remaining_ : kBatch;
+        batchLen_ = log_->copyRecent(n_, batch_, want);
+        if (batchLen_ == 0) return false;       // Overwritten while streaming
+        remaining_ -= batchLen_;
+        return true;
+    }
+
+    // Reads the header; the record count is fixed by the size right now
+    bool openSegment() {
+        char path[24];
+        telemetrySegmentPath(path, sizeof(path), segment_);
+        File file = log_->fs()->open(path);
+        TelemetryHeader h;
+        bool ok = readTelemetryHeader(file, h);
+        size_t size = ok ? file.size() : 0;
+        file.close();
+        if (!ok) return false;
+
+        boot_ = h.boot;
+        n_ = h.first;
+        count_ = (size - sizeof(h)) / sizeof(TelemetryRecord);
+        remaining_ = count_;
+        offset_ = sizeof(h);
+        headerPending_ = true;
+        return remaining_ > 0;
+    }
+
+    const Log *log_;
+    bool ndjson_;
+    uint32_t segment_ = 0, lastSegment_ = 0;
+    uint32_t offset_ = 0;
+    uint32_t remaining_ = 0;        // Records left in this piece
+    uint16_t boot_ = 0;
+    uint32_t n_ = 0;                // Record number within the boot
+    uint32_t count_ = 0;            // Records in the current piece of the stream
+    bool headerPending_ = false;
+    uint32_t recentFrom_ = 0;       // This boot's first record not yet streamed from flash
+    bool recentStarted_ = false;
+
+    TelemetryRecord batch_[kBatch];
+    uint16_t batchPos_ = 0, batchLen_ = 0;
+    char piece_[320];
+    size_t pos_ = 0, len_ = 0;
+};
@@ -0,0 +1,112 @@
+/*
+ * Smart Car Dashboard - Ambient Animation Benchmark
+ * Author: Stromlabs - Pavan Kalsariya
+ * Description: Checks the blending and lookup table in animation.h, then
+ * renders frames with every layer active at several strip lengths and
+ * reports the cost per frame and per LED. Exits non-zero if a check fails.
+ *
+ * Timings are from the host CPU; the ESP32 at 240 MHz is several times
+ * slower. What carries over is that the cost grows linearly with the LED
+ * count, with no per-frame work beyond that.
+ *
+ * Build (Linux):
+ *   g++ -std=c++17 -O2 -I tools/host -I . tools/anim_bench.cpp -o anim_bench
+ */
+
+#include <Arduino.h>
+#include "animation.h"
+
+#include <chrono>
+
+static int failures = 0;
+
+static void check(bool ok, const char *what) {
+    printf("  %-44s %s\n", what, ok ? "ok" : "FAIL");
+    if (!ok) failures++;
+}
+
+// Stands in for PixelStrip: keeps the pixels so the copy isn't optimized away
+template <uint16_t Count>
+struct NullStrip {
+    uint32_t pixels[Count];
+    void setPixelColor(uint16_t i, uint32_t c) { pixels[i] = c; }
+};
+
+static volatile uint32_t sink;
+
+template <uint16_t Count>
+static void bench() {
+    AmbientAnimator<Count> anim;
+    NullStrip<Count> strip;
+    anim.begin(50, 500);
+    anim.setBase(0x40BF00);
+    anim.setAlert(true, 0);
+    anim.setPulse(true);
+
+    const uint32_t frames = 2000000 / Count + 1000;
+    uint32_t now = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t f = 0; f < frames; f++) {
+        anim.render(now);
+        anim.copyTo(strip);
+        now += ANIM_FRAME_MS;
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / frames;
+    sink = strip.pixels[Count - 1];
+    printf("  %4u LEDs: %8.1f ns/frame, %5.2f ns/LED\n", Count, ns, ns / Count);
+}
+
+int main() {
+    // --- BLENDING ---
+    printf("blendColor\n");
+    bool endsExact = true, channelsApart = true;
+    for (uint32_t a = 0; a < 256; a += 15) {
+        uint32_t under = a << 16 | (255 - a) << 8 | (a ^ 0x5A);
+        uint32_t over = (255 - a) << 16 | a << 8 | (a ^ 0xA5);
+        if (blendColor(under, over, 0) != under || blendColor(under, over, 256) != over) endsExact = false;
+        // A blend of two colours stays between them, channel by channel
+        for (uint16_t alpha = 0; alpha <= 256; alpha++) {
+            uint32_t c = blendColor(under, over, alpha);
+            for (uint8_t shift = 0; shift <= 16; shift += 8) {
+                uint8_t u = under >> shift, o = over >> shift, v = c >> shift;
+                if (v < (u < o ? u : o) || v > (u > o ? u : o)) channelsApart = false;
+            }
+        }
+    }
+    check(endsExact, "alpha 0 and 256 give the inputs");
+    check(channelsApart, "no carry between channels");
+
+    // --- LOOKUP TABLE ---
+    printf("gamma table\n");
+    AmbientAnimator<1> anim;
+    anim.begin(255, 500);
+    bool monotonic = true;
+    for (uint16_t v = 1; v < 256; v++) {
+        if (anim.level(v) < anim.level(v - 1)) monotonic = false;
+    }
+    check(anim.level(0) == 0 && anim.level(255) == 255, "full brightness keeps 0 and 255");
+    check(monotonic, "monotonic");
+    anim.setBrightness(50);
+    check(anim.level(255) == 50, "brightness 50 tops out at 50");
+
+    // --- FRAME SCHEDULE ---
+    printf("frame schedule\n");
+    AmbientAnimator<1> sched;
+    sched.begin(255, 500);
+    uint32_t rendered = 0;
+    for (uint32_t t = 1000; t < 2000; t++) rendered += sched.render(t);
+    check(rendered == 1000 / ANIM_FRAME_MS, "one frame per period");
+    sched.render(2000 + 5 * ANIM_FRAME_MS);
+    check(sched.skipped() == 5, "a stall skips frames instead of bunching");
+
+    // --- COST ---
+    printf("render + copy, all layers\n");
+    bench<1>();
+    bench<8>();
+    bench<30>();
+    bench<60>();
+    bench<144>();
+
+    printf("%s\n", failures ? "FAILED" : "all checks passed");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,219 @@
+/*
+ * Smart Car Dashboard - State Event Test and Benchmark
+ * Author: Stromlabs - Pavan Kalsariya
+ * Description: Two parts, both against the firmware's EventBus (events.h).
+ *
+ * Stress: several threads publish changes as fast as they can (standing in
+ * for the button ISR, async_tcp and the loop's own jobs) into a deliberately
+ * small queue, while one thread dispatches. Each producer bumps a per-field
+ * counter before publishing; once they stop, every subscriber must have seen
+ * every field at its final count. Overflows are expected and must not lose a
+ * change.
+ *
+ * Traffic: replays the dashboard's traffic on a simulated clock, sensor
+ * reads every 250 ms and an indicator press every few seconds, and compares
+ * the fixed 100 ms WebSocket push with the event-driven one: frames sent and
+ * the delay from an indicator press to the frame that carries it.
+ *
+ * Build (Linux):
+ *   g++ -std=c++17 -O2 -pthread -I tools/host -I . tools/event_bench.cpp -o event_bench
+ *
+ * Usage:
+ *   ./event_bench [seconds] [seed]      stress for 2 s, 1 h of traffic, seed 1
+ */
+
+#include <Arduino.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <vector>
+
+// --- CLOCK ---
+// Real time for the stress part, simulated for the traffic part
+static bool simulated = false;
+static uint64_t simUs = 0;
+static const auto hostStart = std::chrono::steady_clock::now();
+
+static unsigned long micros() {
+    if (simulated) return (uint32_t)simUs;
+    return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - hostStart).count();
+}
+static unsigned long millis() { return micros() / 1000; }
+
+struct Print {
+    template <typename... Args>
+    void printf(const char *fmt, Args... args) { ::printf(fmt, args...); }
+};
+
+struct {
+    uint32_t getCpuFreqMHz() { return 240; }
+    uint32_t getCycleCount() { return micros() * 240; }
+} ESP;
+
+#include "events.h"
+
+static int failures = 0;
+
+static void check(bool ok, const char *what) {
+    printf("  %-52s %s\n", what, ok ? "ok" : "FAIL");
+    if (!ok) failures++;
+}
+
+// --- STRESS ---
+static const uint8_t kFields = 12;
+static const uint8_t kProducers = 3;
+static std::atomic<uint32_t> fieldCount[kFields];
+static uint32_t seenFast[kFields], seenMerged[kFields];
+
+static void copySeen(uint32_t *seen, uint32_t fields) {
+    for (uint8_t f = 0; f < kFields; f++) {
+        if (fields & EVENT_BIT(f)) seen[f] = fieldCount[f].load(std::memory_order_acquire);
+    }
+}
+
+static void onFast(uint32_t fields) { copySeen(seenFast, fields); }
+static void onMerged(uint32_t fields) { copySeen(seenMerged, fields); }
+
+static void stress(double seconds) {
+    printf("stress: %u producers, 16-slot queue, %.1f s\n", kProducers, seconds);
+    static EventBus<2, 16> bus;
+    bus.subscribe("fast", EVENT_BIT(kFields) - 1, 0, onFast);
+    bus.subscribe("merged", EVENT_BIT(kFields) - 1, 1, onMerged);
+
+    std::atomic<bool> stop(false);
+    std::vector<std::thread> producers;
+    for (uint8_t p = 0; p < kProducers; p++) {
+        producers.emplace_back([&, p]() {
+            std::mt19937 rng(p + 1);
+            while (!stop.load(std::memory_order_relaxed)) {
+                // Each producer owns every third field, as each task owns its state
+                uint8_t field = p + kProducers * (rng() % (kFields / kProducers));
+                fieldCount[field].fetch_add(1, std::memory_order_release);
+                bus.publish(field);
+            }
+        });
+    }
+
+    auto end = std::chrono::steady_clock::now() + std::chrono::duration<double>(seconds);
+    unsigned long dispatches = 0;
+    while (std::chrono::steady_clock::now() < end) {
+        bus.dispatch();
+        dispatches++;
+    }
+    stop = true;
+    for (std::thread &t : producers) t.join();
+
+    // Drain what's left, waiting out the merged subscriber's window
+    while (bus.idleUs() != UINT32_MAX) bus.dispatch();
+
+    bool fastOk = true, mergedOk = true;
+    uint64_t total = 0;
+    for (uint8_t f = 0; f < kFields; f++) {
+        uint32_t final = fieldCount[f].load();
+        total += final;
+        if (seenFast[f] != final) fastOk = false;
+        if (seenMerged[f] != final) mergedOk = false;
+    }
+    printf("  %llu published (%.1f M/s), %lu dropped into the overflow mask, %lu dispatches\n",
+           (unsigned long long)total, total / seconds / 1e6, (unsigned long)bus.dropped(), dispatches);
+    printf("  handler runs: %lu with no window, %lu with a 1 ms window\n", (unsigned long)bus.subscriber(0).runs,
+           (unsigned long)bus.subscriber(1).runs);
+    check(bus.published() == (uint32_t)total, "every publish counted");
+    check(bus.dropped() > 0, "queue overflowed at least once");
+    check(fastOk, "no-window subscriber saw every final value");
+    check(mergedOk, "1 ms-window subscriber saw every final value");
+}
+
+// --- TRAFFIC ---
+enum { T_SENSORS, T_INDICATOR };
+
+struct TrafficResult {
+    unsigned long frames;
+    std::vector<uint32_t> pressDelayMs;
+};
+
+static uint64_t pressUs = 0;        // Press not yet on the wire; 0 if none
+static TrafficResult *current = NULL;
+
+static void onFrame(uint32_t fields) {
+    current->frames++;
+    if (pressUs && (fields & EVENT_BIT(T_INDICATOR))) {
+        current->pressDelayMs.push_back((simUs - pressUs) / 1000);
+        pressUs = 0;
+    }
+}
+
+static uint32_t percentile(std::vector<uint32_t> v, uint8_t p) {
+    if (v.empty()) return 0;
+    std::sort(v.begin(), v.end());
+    return v[(v.size() - 1) * p / 100];
+}
+
+// sensorsChange: whether a 250 ms read changes any shown value (the yaw and
+// echo times usually do); events: push on change instead of every 100 ms
+static TrafficResult traffic(double hours, uint32_t seed, bool sensorsChange, bool events) {
+    std::mt19937 rng(seed);
+    TrafficResult result = {0, {}};
+    current = &result;
+    simUs = 0;
+    pressUs = 0;
+
+    EventBus<1, 64> bus;
+    if (events) bus.subscribe("dashboard", EVENT_BIT(T_SENSORS) | EVENT_BIT(T_INDICATOR), 100, onFrame);
+
+    uint64_t endUs = (uint64_t)(hours * 3600e6);
+    uint64_t nextRead = 0, nextPush = 0;
+    uint64_t nextPress = 1000000 + rng() % 8000000;
+    // One loop pass per millisecond; the firmware's loop sleeps in 1 ms ticks
+    for (; simUs < endUs; simUs += 1000) {
+        if (simUs >= nextRead) {
+            nextRead += 250000;
+            if (sensorsChange) bus.publish(T_SENSORS);
+        }
+        if (simUs >= nextPress) {
+            nextPress += 1000000 + rng() % 8000000;
+            if (!pressUs) pressUs = simUs;
+            bus.publish(T_INDICATOR);
+        }
+        if (events) {
+            bus.dispatch();
+        } else if (simUs >= nextPush) {
+            nextPush += 100000;
+            onFrame(EVENT_BIT(T_INDICATOR));
+        }
+    }
+    return result;
+}
+
+static void compare(const char *scenario, double hours, uint32_t seed, bool sensorsChange) {
+    TrafficResult fixed = traffic(hours, seed, sensorsChange, false);
+    TrafficResult events = traffic(hours, seed, sensorsChange, true);
+    double seconds = hours * 3600;
+    printf("%s\n", scenario);
+    printf("  %-14s %8s %10s %10s %10s\n", "push", "frames/s", "press p50", "press p99", "press max");
+    printf("  %-14s %8.2f %8lu ms %8lu ms %8lu ms\n", "every 100 ms", fixed.frames / seconds,
+           (unsigned long)percentile(fixed.pressDelayMs, 50), (unsigned long)percentile(fixed.pressDelayMs, 99),
+           (unsigned long)percentile(fixed.pressDelayMs, 100));
+    printf("  %-14s %8.2f %8lu ms %8lu ms %8lu ms\n", "on change", events.frames / seconds,
+           (unsigned long)percentile(events.pressDelayMs, 50), (unsigned long)percentile(events.pressDelayMs, 99),
+           (unsigned long)percentile(events.pressDelayMs, 100));
+    check(events.frames < fixed.frames, "fewer frames on change");
+    check(percentile(events.pressDelayMs, 99) <= 100, "a press waits at most one window");
+}
+
+int main(int argc, char **argv) {
+    double seconds = argc > 1 ? atof(argv[1]) : 2;
+    uint32_t seed = argc > 2 ? strtoul(argv[2], NULL, 10) : 1;
+
+    stress(seconds);
+
+    simulated = true;
+    compare("traffic, 1 h, every sensor read changes a value", 1, seed, true);
+    compare("traffic, 1 h, sensors steady", 1, seed, false);
+
+    printf("%s\n", failures ? "FAILED" : "all checks passed");
+    return failures ? 1 : 0;
+}
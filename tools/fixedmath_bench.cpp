@@ -0,0 +1,202 @@
+/*
+ * Smart Car Dashboard - Fixed-Point Math Accuracy and Benchmark
+ * Author: Stromlabs - Pavan Kalsariya
+ * Description: Checks each kernel in fixedmath.h against the float/double
+ * expression it replaced in the firmware, over the full input range, and
+ * times both. Exits non-zero if a kernel is outside its stated error.
+ *
+ * Timings are from the host CPU, which does doubles in hardware. On the
+ * ESP32 doubles, pow() and sqrt() are software routines, so the gap there
+ * is larger; use the numbers to compare kernels, not to predict firmware
+ * timings.
+ *
+ * Build (Linux):
+ *   g++ -std=c++17 -O2 -I tools/host -I . tools/fixedmath_bench.cpp -o fixedmath_bench
+ */
+
+#include <Arduino.h>
+#include "fixedmath.h"
+
+#include <chrono>
+#include <random>
+#include <vector>
+
+// --- REFERENCES (the firmware's previous expressions) ---
+// Arduino's definitions, which the host shim doesn't carry
+#define PI 3.1415926535897932384626433832795
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+static long map(long x, long in_min, long in_max, long out_min, long out_max) {
+    return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
+
+static float refEchoCm(long duration) {
+    if (duration == 0) return 999.0;
+    return duration * 0.034 / 2;
+}
+
+static int refSpeed(float x, float y, float z) {
+    float totalAccel = sqrt(pow(x, 2) + pow(y, 2) + pow(z, 2));
+    float accelDiff = fabs(totalAccel - 9.8);
+    return (accelDiff > 0.5) ? (accelDiff > 1.5 ? 2 : 1) : 0;
+}
+
+// The exact blend; the old map() truncated to whole degrees
+static uint32_t refTempColor(float temp, float cold, float hot) {
+    if (temp <= cold) return 0x0000FF;
+    if (temp >= hot) return 0xFF0000;
+    int r = lround((temp - cold) / (hot - cold) * 255);
+    return (uint32_t)r << 16 | (uint32_t)(255 - r) << 8;
+}
+
+static int failures = 0;
+
+static void check(bool ok, const char *what) {
+    printf("  %-44s %s\n", what, ok ? "ok" : "FAIL");
+    if (!ok) failures++;
+}
+
+// Time fn over n iterations; returns ns per call. The sink keeps the
+// compiler from dropping the work.
+static volatile uint64_t sink;
+
+template <typename F>
+static double timeIt(int n, F fn) {
+    uint64_t acc = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < n; i++) acc += fn(i);
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    sink = acc;
+    return ns / n;
+}
+
+int main() {
+    std::mt19937 rng(1);
+    const int kBench = 5000000;
+
+    // --- ULTRASONIC ---
+    printf("echoToMm\n");
+    double maxErrMm = 0;
+    for (uint32_t us = 0; us <= 30000; us++) {
+        double err = fabs(echoToMm(us) - refEchoCm(us) * 10.0);
+        if (err > maxErrMm) maxErrMm = err;
+    }
+    printf("  max error %.3f mm over 0..30000 us\n", maxErrMm);
+    check(maxErrMm <= 0.6, "within 0.6 mm");
+    check(echoToMm(0) == 9990, "no echo reads 999 cm");
+
+    std::vector<uint32_t> echoes(4096);
+    for (uint32_t &e : echoes) e = rng() % 30001;
+    double tRef = timeIt(kBench, [&](int i) { return (uint64_t)refEchoCm(echoes[i & 4095]); });
+    double tFix = timeIt(kBench, [&](int i) { return (uint64_t)echoToMm(echoes[i & 4095]); });
+    printf("  float %.2f ns, fixed %.2f ns\n", tRef, tFix);
+
+    // --- ACCELERATION ---
+    printf("speedLevel\n");
+    struct Sample { float x, y, z; };
+    std::vector<Sample> samples(200000);
+    std::uniform_real_distribution<float> axis(-12.0f, 12.0f);
+    unsigned long mismatches = 0, edgeMismatches = 0;
+    for (Sample &s : samples) {
+        s = {axis(rng), axis(rng), axis(rng)};
+        int expected = refSpeed(s.x, s.y, s.z);
+        int got = speedLevel(accelToFixed(s.x), accelToFixed(s.y), accelToFixed(s.z));
+        if (got == expected) continue;
+        // Quantizing to 1/256 m/s^2 may only flip samples right at a band edge
+        float diff = fabsf(sqrtf(s.x * s.x + s.y * s.y + s.z * s.z) - 9.8f);
+        if (fabsf(diff - 0.5f) < 0.01f || fabsf(diff - 1.5f) < 0.01f) edgeMismatches++;
+        else mismatches++;
+    }
+    printf("  %lu of %zu differ, all within 0.01 m/s^2 of a band edge: %s\n", mismatches + edgeMismatches,
+           samples.size(), mismatches ? "no" : "yes");
+    check(mismatches == 0, "only band-edge samples differ");
+    check(speedLevel(accelToFixed(40), accelToFixed(40), accelToFixed(40)) == 2, "saturated input doesn't overflow");
+
+    tRef = timeIt(kBench, [&](int i) {
+        const Sample &s = samples[i % samples.size()];
+        return (uint64_t)refSpeed(s.x, s.y, s.z);
+    });
+    tFix = timeIt(kBench, [&](int i) {
+        const Sample &s = samples[i % samples.size()];
+        return (uint64_t)speedLevel(accelToFixed(s.x), accelToFixed(s.y), accelToFixed(s.z));
+    });
+    printf("  float %.2f ns, fixed %.2f ns\n", tRef, tFix);
+
+    // --- YAW ---
+    // 10 minutes of 250 ms updates with jittered intervals and random turns,
+    // against a double-precision integration of the same rates
+    printf("YawIntegrator\n");
+    YawIntegrator yaw;
+    float legacyYaw = 0;
+    double exact = 0;
+    double maxErrFixed = 0, maxErrLegacy = 0;
+    std::uniform_real_distribution<float> rate(-3.0f, 3.0f);
+    for (int step = 0; step < 2400; step++) {
+        float gz = rate(rng);
+        uint32_t dtMs = 240 + rng() % 21;
+
+        yaw.update(lroundf(gz * RAD_TO_MDEG), dtMs);
+
+        float deltaTime = dtMs / 1000.0;
+        legacyYaw += gz * deltaTime * 180 / PI;
+        if (legacyYaw > 360) legacyYaw -= 360;
+        if (legacyYaw < 0) legacyYaw += 360;
+
+        exact = fmod(exact + gz * (dtMs / 1000.0) * 180.0 / M_PI, 360.0);
+        if (exact < 0) exact += 360.0;
+
+        auto angleErr = [&](double a) { double d = fabs(a - exact); return d > 180 ? 360 - d : d; };
+        maxErrFixed = fmax(maxErrFixed, angleErr(yaw.degrees()));
+        maxErrLegacy = fmax(maxErrLegacy, angleErr(legacyYaw));
+    }
+    printf("  max drift after 10 min: fixed %.4f deg, float %.4f deg\n", maxErrFixed, maxErrLegacy);
+    check(maxErrFixed < 0.05, "within 0.05 deg over 10 min");
+
+    tRef = timeIt(kBench, [&](int i) {
+        float deltaTime = 250 / 1000.0;
+        legacyYaw += (float)(i & 7) * deltaTime * 180 / PI;
+        if (legacyYaw > 360) legacyYaw -= 360;
+        if (legacyYaw < 0) legacyYaw += 360;
+        return (uint64_t)legacyYaw;
+    });
+    tFix = timeIt(kBench, [&](int i) {
+        yaw.update(lroundf((float)(i & 7) * RAD_TO_MDEG), 250);
+        return (uint64_t)yaw.millidegrees();
+    });
+    printf("  float %.2f ns, fixed %.2f ns\n", tRef, tFix);
+
+    // --- TEMPERATURE COLOR ---
+    printf("TempGradient\n");
+    const float cold = 20.0f, hot = 35.0f;
+    TempGradient<64> gradient(cold, hot);
+    int maxErrR = 0;
+    bool endsExact = true;
+    for (int t = -100; t <= 600; t++) {
+        float temp = t * 0.1f;
+        uint32_t got = gradient.color(temp), expected = refTempColor(temp, cold, hot);
+        if ((temp <= cold || temp >= hot) && got != expected) endsExact = false;
+        if ((got & 0xFF) != (expected & 0xFF)) endsExact = false;    // Blue only at or below cold
+        int errR = abs((int)(got >> 16 & 0xFF) - (int)(expected >> 16 & 0xFF));
+        if (errR > maxErrR) maxErrR = errR;
+    }
+    printf("  max red/green error %d/255 over -10..60 C in 0.1 C steps\n", maxErrR);
+    check(maxErrR <= 5, "within 5/255");
+    check(endsExact, "blue at or below cold, red at or above hot");
+
+    std::vector<float> temps(4096);
+    std::uniform_real_distribution<float> tempDist(15.0f, 40.0f);
+    for (float &t : temps) t = tempDist(rng);
+    tRef = timeIt(kBench, [&](int i) {
+        float temp = temps[i & 4095];
+        if (temp <= cold) return (uint64_t)0x0000FF;
+        if (temp >= hot) return (uint64_t)0xFF0000;
+        long r = map(constrain(temp, cold, hot), cold, hot, 0, 255);
+        long g = map(constrain(temp, cold, hot), cold, hot, 255, 0);
+        return (uint64_t)(r << 16 | g << 8);
+    });
+    tFix = timeIt(kBench, [&](int i) { return (uint64_t)gradient.color(temps[i & 4095]); });
+    printf("  map() %.2f ns, table %.2f ns\n", tRef, tFix);
+
+    printf("%s\n", failures ? "FAILED" : "all kernels within bounds");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,22 @@
+/*
+ * Smart Car Dashboard - Host Shim
+ * Description: The few Arduino/ESP32 definitions the firmware headers use,
+ * so they can be compiled into the Linux tools in this directory.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <mutex>
+
+// Critical sections map onto one process-wide mutex
+typedef struct { std::recursive_mutex *lock; } portMUX_TYPE;
+static std::recursive_mutex hostCriticalLock;
+#define portMUX_INITIALIZER_UNLOCKED { &hostCriticalLock }
+inline void portENTER_CRITICAL(portMUX_TYPE *mux) { mux->lock->lock(); }
+inline void portEXIT_CRITICAL(portMUX_TYPE *mux) { mux->lock->unlock(); }
@@ -0,0 +1,170 @@
+/*
+ * Smart Car Dashboard - JSON Buffer Check
+ * Author: Stromlabs - Pavan Kalsariya
+ * Description: Writes every JSON message the firmware builds in a fixed
+ * buffer (messages.h, and the /debug/profile and /debug/jobs reports) at its
+ * longest and checks it fits the buffer it's sent from. Longest means every
+ * integer at its full 32-bit width, every float at the widest value its
+ * field can take, every bool false and every string at its longest name.
+ * Run it after adding a field: it exits non-zero if a buffer is too small,
+ * before a car sends a cut-off message (which it would now drop).
+ *
+ * The runtime report has no buffer of its own size; it streams through a
+ * small one (jsonwriter.h sinks). The report's sections that build on the
+ * host are streamed through chunks of every size down to two bytes, and
+ * must come out the same as when written whole.
+ *
+ * Build (Linux; add -DCAR_ROLE=2 for Car 2):
+ *   g++ -std=c++17 -O2 -I tools/host -I . tools/json_check.cpp -o json_check
+ *
+ * Usage:
+ *   ./json_check
+ */
+
+#include <Arduino.h>
+
+#include <string>
+#include <vector>
+
+static unsigned long micros() { return 0; }
+static unsigned long millis() { return 0; }
+
+struct Print {
+    template <typename... Args>
+    void printf(const char *fmt, Args... args) { ::printf(fmt, args...); }
+};
+
+struct {
+    uint32_t getCpuFreqMHz() { return 240; }
+    uint32_t getCycleCount() { return 0; }
+} ESP;
+
+// Nothing runs here, nothing to wake
+void wakeLoop() {}
+
+#include "messages.h"
+#include "scheduler.h"
+
+// As in smartcar.h: Scheduler<10>, and every LoopStage of the largest role
+#define LOOP_JOBS 10
+#define LOOP_STAGES 8
+#define NAME_LEN 12             // Longest stage or job name the serial tables line up
+
+static const char name[NAME_LEN + 1] = "abcdefghijkl";
+static const char *const names[LOOP_STAGES] = {name, name, name, name, name, name, name, name};
+static LoopProfiler<LOOP_STAGES> profiler(names);
+
+static uint32_t simClock() { return 0; }
+static Scheduler<LOOP_JOBS> scheduler(simClock);
+#if FEATURE_PEER
+static BodyPool<4, 256> updateBodies;
+#endif
+
+static int failures = 0;
+
+// Writes one message into a buffer twice its size, so the length is known
+// even if it wouldn't fit the real one
+template <size_t Size, typename Fn>
+static void check(const char *name, Fn write) {
+    JsonBuffer<Size * 2> json;
+    json.setWidestNumbers(true);
+    write(json);
+    bool fits = !json.overflowed() && json.length() < Size;
+    printf("  %-10s %5u of %5u bytes%s\n", name, (unsigned)json.length(), (unsigned)Size, fits ? "" : "  TOO SMALL");
+    if (!fits) failures++;
+}
+
+static void noop() {}
+
+// --- STREAMED REPORTS ---
+// The runtime report's sections that have no hardware behind them
+static void writeRuntime(JsonWriter &json) {
+    json.beginObject().add("type", "runtime");
+#if FEATURE_PEER
+    updateBodies.write(json);
+#endif
+    alerts.write(json);
+    collision.write(json);
+    stateEvents.write(json);
+    recorder.write(json);
+    scheduler.write(json);
+    json.beginArray("profile");
+    profiler.write(json);
+    json.endArray();
+    json.endObject();
+}
+
+static void collect(void *ctx, const char *data, size_t len) { static_cast<std::string *>(ctx)->append(data, len); }
+
+static void checkStreamed() {
+    JsonBuffer<16384> whole;
+    whole.setWidestNumbers(true);
+    writeRuntime(whole);
+    bool ok = !whole.overflowed();
+
+    for (size_t chunk = 2; chunk <= 512 && ok; chunk++) {
+        std::vector<char> buffer(chunk);
+        std::string out;
+        JsonWriter json(buffer.data(), chunk);
+        json.setWidestNumbers(true);
+        json.setSink(collect, &out);
+        writeRuntime(json);
+        json.flush();
+        ok = !json.overflowed() && out == whole.c_str() && json.written() == whole.length();
+        if (!ok) printf("  streamed through %u bytes: not the same as written whole\n", (unsigned)chunk);
+    }
+    printf("  %-10s %5u bytes, streamed the same through 2..512-byte chunks%s\n", "runtime", (unsigned)whole.length(),
+           ok ? "" : "  FAILED");
+    if (!ok) failures++;
+}
+
+int main() {
+    printf("%s, longest message per buffer\n", CONFIG.name);
+
+    // Widest values each field can take: distances are converted from a
+    // 16-bit echo in mm, the heading is -180..180, DHT11 never reads outside
+    // -40..100
+    carState.temp = -40.0f;
+    carState.humidity = 100.0f;
+    carState.frontDist = 6553.5f;
+    carState.backDist = 6553.5f;
+    carState.direction = -179.9f;
+    carState.leftIndicator = carState.rightIndicator = false;
+    carState.buzzerOn = carState.ambientOn = false;
+    carState.peerLeft = carState.peerRight = false;
+    carState.collision = COLLISION_CRITICAL;
+    carState.collisionBack = false;
+    carState.ttcMs = TTC_NONE - 1;
+    peerConnected = false;
+
+#if FEATURE_DASHBOARD
+    const char *target = "";
+    for (uint8_t t = 0; t < COMMAND_TARGETS; t++) {
+        if (strlen(COMMAND_TARGET_NAMES[t]) > strlen(target)) target = COMMAND_TARGET_NAMES[t];
+    }
+
+    check<STATE_JSON_SIZE>("state", [](JsonWriter &json) { writeStateFrame(json, false, 0); });
+    check<STATE_JSON_SIZE>("snapshot", [](JsonWriter &json) { writeStateFrame(json, true, 0); });
+    check<ACK_JSON_SIZE>("ack", [&](JsonWriter &json) { writeAck(json, 0, target, NULL); });
+    check<ACK_JSON_SIZE>("ack error", [&](JsonWriter &json) { writeAck(json, 0, target, ACK_BUSY); });
+#endif
+#if FEATURE_PEER
+    check<STATUS_JSON_SIZE>("status", [](JsonWriter &json) { writeStatus(json); });
+    check<UPDATE_REPLY_JSON_SIZE>("update", [](JsonWriter &json) { writeUpdateReply(json); });
+    check<PEER_SYNC_JSON_SIZE>("peer sync", [](JsonWriter &json) { writePeerSync(json); });
+#endif
+
+    check<PROFILE_JSON_SIZE>("profile", [](JsonWriter &json) { profiler.write(json); });
+
+    while (scheduler.add(name, noop, 1) >= 0) {}
+    check<JOBS_JSON_SIZE>("jobs", [](JsonWriter &json) {
+        json.beginObject().add("unit", "us");
+        scheduler.write(json);
+        json.endObject();
+    });
+
+    checkStreamed();
+
+    printf(failures ? "\n%d checks failed\n" : "\nall messages fit\n", failures);
+    return failures ? 1 : 0;
+}
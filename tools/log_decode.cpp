@@ -0,0 +1,109 @@
+/*
+ * Smart Car Dashboard - Log Decoder
+ * Author: Stromlabs - Pavan Kalsariya
+ * Description: Turns a serial capture from a car in "log binary" mode back
+ * into text lines, using the same message table (logmessages.h) the firmware
+ * was built with. Bytes that are not part of a frame, such as setup prints
+ * and command replies, are passed through unchanged, so a capture that mixes
+ * text and binary output reads naturally.
+ *
+ * The firmware logs a hash of its message table when logging starts; a
+ * warning is printed if it doesn't match the table this decoder was built
+ * with, since IDs would then map to the wrong formats.
+ *
+ * Build (Linux):
+ *   g++ -std=c++17 -O2 -I tools/host -I . tools/log_decode.cpp -o log_decode
+ *
+ * Usage:
+ *   ./log_decode capture.bin
+ *   cat /dev/ttyUSB0 | ./log_decode           decode live (set 115200 baud first)
+ */
+
+#include <Arduino.h>
+#include "logformat.h"
+
+#include <vector>
+
+struct DecodeStats {
+    unsigned long frames = 0;
+    unsigned long badFrames = 0;
+    unsigned long tableMismatches = 0;
+};
+
+static void printRecord(const LogRecord &rec, DecodeStats &stats) {
+    if (rec.id == MSG_LOG_START && rec.argc == 1 && rec.args[0] != logTableHash()) {
+        fprintf(stderr, "log_decode: message table %08x differs from this build's %08x; rebuild from the firmware's revision\n",
+                (unsigned)rec.args[0], (unsigned)logTableHash());
+        stats.tableMismatches++;
+    }
+
+    char line[256];
+    formatLogLine(rec, line, sizeof(line));
+    puts(line);
+    stats.frames++;
+}
+
+// Text between frames is printed as is; other binary bytes (the rest of a
+// corrupt frame) are dropped
+static void passThrough(uint8_t c) {
+    if (c == '\n' || c == '\r' || c == '\t' || (c >= 0x20 && c < 0x7F)) putchar(c);
+}
+
+// Consume as much of buf as possible; returns the number of bytes used.
+// An incomplete frame at the end is left for the next read.
+static size_t decodeBuffer(const uint8_t *buf, size_t len, bool final, DecodeStats &stats) {
+    size_t pos = 0;
+    while (pos < len) {
+        if (buf[pos] != LOG_FRAME_SYNC0) {
+            passThrough(buf[pos++]);
+            continue;
+        }
+
+        LogRecord rec;
+        int n = decodeLogFrame(buf + pos, len - pos, rec);
+        if (n > 0) {
+            printRecord(rec, stats);
+            pos += n;
+        } else if (n == 0 && !final) {
+            break;
+        } else {
+            // Corrupt frame: report it and resync after the sync pair. A lone
+            // 0xA5 is just a stray byte.
+            if (len - pos >= 2 && buf[pos + 1] == LOG_FRAME_SYNC1) {
+                puts("[bad frame]");
+                stats.badFrames++;
+                pos += 2;
+            } else {
+                passThrough(buf[pos++]);
+            }
+        }
+    }
+    return pos;
+}
+
+int main(int argc, char **argv) {
+    FILE *in = stdin;
+    if (argc > 1 && strcmp(argv[1], "-") != 0) {
+        in = fopen(argv[1], "rb");
+        if (!in) {
+            perror(argv[1]);
+            return 1;
+        }
+    }
+
+    DecodeStats stats;
+    std::vector<uint8_t> buf;
+    uint8_t chunk[4096];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), in)) > 0) {
+        buf.insert(buf.end(), chunk, chunk + n);
+        size_t used = decodeBuffer(buf.data(), buf.size(), false, stats);
+        buf.erase(buf.begin(), buf.begin() + used);
+        fflush(stdout);
+    }
+    decodeBuffer(buf.data(), buf.size(), true, stats);
+
+    fprintf(stderr, "log_decode: %lu records, %lu bad frames\n", stats.frames, stats.badFrames);
+    if (in != stdin) fclose(in);
+    return stats.tableMismatches ? 2 : 0;
+}
@@ -0,0 +1,459 @@
+/*
+ * Smart Car Dashboard - Recording Replay
+ * Author: Stromlabs - Pavan Kalsariya
+ * Description: Feeds a car's input recording (record.h, downloaded from
+ * /record) through the firmware's own car logic (carlogic.h) on a simulated
+ * clock, as fast as the host can go, and checks it reaches the same output
+ * decisions the car did: which alert the buzzer, ambient light and
+ * indicators showed, in the same order. A field issue recorded once can then
+ * be stepped through, or bisected, on Linux.
+ *
+ * Inputs are applied at their recorded times, and the state changes they
+ * publish reach the outputs where the car's loop delivered them (REC_STATE),
+ * so changes made in one loop pass are taken in together as on the car. The
+ * outputs the car recorded also serve as points at which to check for
+ * lapsed alerts, since the car checks every outputMs while the replay only
+ * runs on records.
+ *
+ * --synth writes a recording of a simulated drive instead: the firmware's
+ * job table on scheduler.h, with obstacles coming and going, button presses,
+ * dashboard commands, the other car, and HTTP calls that now and then stall
+ * for their 1 s timeout. It exercises the replay without a car. It also
+ * checks Car 1's peer-lost pulse: it ends within peerLostAlertMs of Car 2
+ * dropping out, and with --car2-off (Car 2 never answers) it never shows.
+ *
+ * Build (Linux; add -DCAR_ROLE=2 for Car 2's recordings):
+ *   g++ -std=c++17 -O2 -I tools/host -I . tools/replay.cpp -o replay
+ *
+ * Usage:
+ *   ./replay recording.bin                  replay and compare
+ *   ./replay --synth <hours> <out.bin> [seed] [--car2-off]
+ */
+
+#include <Arduino.h>
+
+#include <chrono>
+#include <random>
+#include <vector>
+
+// --- SIMULATED CLOCK ---
+// Set from each record while replaying; advanced by job costs in --synth
+static uint64_t simUs = 0;
+
+static unsigned long micros() { return (uint32_t)simUs; }
+static unsigned long millis() { return (uint32_t)(simUs / 1000); }
+
+struct Print {
+    template <typename... Args>
+    void printf(const char *fmt, Args... args) { ::printf(fmt, args...); }
+};
+
+struct {
+    uint32_t getCpuFreqMHz() { return 240; }
+    uint32_t getCycleCount() { return (uint32_t)(simUs * 240); }
+} ESP;
+
+// One thread here, nothing to wake
+void wakeLoop() {}
+
+#include "carlogic.h"
+#include "scheduler.h"
+
+// --- OUTPUTS ---
+struct OutputChange {
+    uint32_t timeMs;
+    uint8_t channel;
+    uint8_t type;
+    uint16_t value;
+};
+
+static const char *const CHANNEL_NAMES[ALERT_CHANNELS] = {"buzzer", "ambient", "indicators"};
+
+static bool replaying = false;
+static std::vector<OutputChange> produced;
+
+#if FEATURE_PEER && FEATURE_AMBIENT
+// How often the ambient light showed the peer-lost pulse, and how long after
+// Car 2 dropped out it was still showing at most
+static uint32_t peerLostShown = 0, peerLostLongestMs = 0;
+static bool peerLostShowing = false;
+
+static void trackPeerLost(uint32_t nowMs) {
+    bool showing = alerts.output(CHANNEL_AMBIENT).type == ALERT_PEER_LOST;
+    if (showing && !peerLostShowing) peerLostShown++;
+    if (!showing && peerLostShowing && nowMs - peerLostMs > peerLostLongestMs) peerLostLongestMs = nowMs - peerLostMs;
+    peerLostShowing = showing;
+}
+#endif
+
+static void resolve(uint32_t nowMs) {
+    uint8_t changed = resolveOutputs(nowMs);
+#if FEATURE_PEER && FEATURE_AMBIENT
+    if (changed & CHANNEL_BIT(CHANNEL_AMBIENT)) trackPeerLost(nowMs);
+#endif
+    if (!replaying) return;
+    for (uint8_t c = 0; c < ALERT_CHANNELS; c++) {
+        if (!(changed & CHANNEL_BIT(c))) continue;
+        const AlertOutput &out = alerts.output((AlertChannel)c);
+        produced.push_back({nowMs, c, out.type, out.value});
+    }
+}
+
+// The firmware's "outputs" subscriber, without the hardware
+static void onOutputState(uint32_t) {
+    raiseStateAlerts(millis());
+    resolve(millis());
+}
+
+// As setup() does: every field counts as changed once
+static void subscribeOutputs() {
+    stateEvents.subscribe("outputs", OUTPUT_FIELDS, 0, onOutputState);
+    for (uint8_t field = 0; field < STATE_FIELDS; field++) stateEvents.publish(field);
+}
+
+static void printChange(const char *label, const OutputChange &c) {
+    printf("  %-9s %10lu ms  %-10s %-9s %u\n", label, (unsigned long)c.timeMs, CHANNEL_NAMES[c.channel],
+           ALERT_NAMES[c.type], c.value);
+}
+
+// --- REPLAY ---
+static bool readFile(const char *path, std::vector<uint8_t> &data) {
+    FILE *in = fopen(path, "rb");
+    if (!in) return false;
+    uint8_t chunk[65536];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), in)) > 0) data.insert(data.end(), chunk, chunk + n);
+    fclose(in);
+    return true;
+}
+
+// Apply one input record; false for anything else
+static bool applyRecord(const Record &rec) {
+    const uint8_t *p = rec.payload;
+    uint32_t now = rec.timeMs;
+    switch (rec.type) {
+        case REC_ECHO: applyEchoes(now, recordU16(p), recordU16(p + 2)); return true;
+        case REC_CLIMATE: applyClimate(now, recordF32(p), recordF32(p + 4)); return true;
+#if FEATURE_MPU
+        case REC_MOTION: applyMotion(now, recordF32(p), recordF32(p + 4), recordF32(p + 8), recordF32(p + 12)); return true;
+#endif
+        case REC_BUTTON: handleButtons(now, p[0] & 1, p[0] & 2); return true;
+#if FEATURE_PEER
+        case REC_PEER_UPDATE: {
+            UpdateBody body;
+            body.present = p[0];
+            body.values = p[1];
+            applyPeerUpdate(now, body);
+            return true;
+        }
+        case REC_PEER_REPLY: applyPeerReply(now, p[0] & 1, p[0] & 2); return true;
+#if CAR_ROLE == ROLE_MAIN
+        case REC_PEER_STATUS: applyPeerStatus(now, p[0] & 1, p[0] & 2, p[0] & 4); return true;
+#endif
+#endif
+#if FEATURE_DASHBOARD
+        case REC_COMMAND: applyCommand(now, (CommandTarget)(p[0] & 0x7F), p[0] & 0x80); return true;
+#endif
+        default: return false;
+    }
+}
+
+static int replay(const char *path) {
+    std::vector<uint8_t> data;
+    if (!readFile(path, data)) {
+        fprintf(stderr, "replay: can't read %s\n", path);
+        return 1;
+    }
+
+    RecordReader reader(data.data(), data.size());
+    uint8_t role;
+    uint32_t hash;
+    if (!reader.header(role, hash)) {
+        fprintf(stderr, "replay: %s is not a recording\n", path);
+        return 1;
+    }
+    if (role != CAR_ROLE || hash != logicConfigHash()) {
+        fprintf(stderr, "replay: recorded as role %u with settings %08x, this build is role %u with %08x; "
+                "rebuild with the car's CAR_ROLE and config.h\n", role, (unsigned)hash, CAR_ROLE,
+                (unsigned)logicConfigHash());
+        return 2;
+    }
+
+    replaying = true;
+    subscribeOutputs();
+
+    std::vector<OutputChange> expected;
+    unsigned long counts[REC_TYPES] = {};
+    unsigned long records = 0, lost = 0, skipped = 0;
+    uint32_t firstMs = 0, lastMs = 0;
+    auto wallStart = std::chrono::steady_clock::now();
+
+    Record rec;
+    while (reader.next(rec)) {
+        simUs = (uint64_t)rec.timeMs * 1000;
+        if (records++ == 0) firstMs = rec.timeMs;
+        counts[rec.type]++;
+        lastMs = rec.timeMs;
+
+        if (rec.type == REC_STATE) {
+            stateEvents.dispatch();
+        } else if (rec.type == REC_OUTPUT) {
+            expected.push_back({rec.timeMs, rec.payload[0], rec.payload[1], recordU16(rec.payload + 2)});
+            resolve(rec.timeMs);
+        } else if (rec.type == REC_LOST) {
+            lost += recordU16(rec.payload);
+            printf("  gap       %10lu ms  %u records lost on the car; outputs after this may differ\n",
+                   (unsigned long)rec.timeMs, recordU16(rec.payload));
+        } else if (!applyRecord(rec)) {
+            skipped++;      // Input this role's logic doesn't take
+        }
+    }
+    double wallS = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+    double simS = (lastMs - firstMs) / 1000.0;
+
+    printf("%s: %lu bytes, %.2f h recorded\n", path, (unsigned long)data.size(), simS / 3600);
+    for (uint8_t t = 0; t < REC_TYPES; t++) {
+        if (counts[t]) printf("  %-11s %9lu\n", RECORD_NAMES[t], counts[t]);
+    }
+    if (reader.remaining()) printf("  %lu bytes at the end cut short\n", (unsigned long)reader.remaining());
+    if (skipped) printf("  %lu records this role doesn't take, skipped\n", skipped);
+    printf("replayed in %.3f s, %.0fx real time\n", wallS, wallS > 0 ? simS / wallS : 0);
+
+    // Same changes in the same order, at the same times
+    size_t n = produced.size() < expected.size() ? produced.size() : expected.size();
+    size_t mismatch = n;
+    uint32_t maxDeviationMs = 0;
+    for (size_t i = 0; i < n; i++) {
+        const OutputChange &a = produced[i], &b = expected[i];
+        if (a.channel != b.channel || a.type != b.type || a.value != b.value) {
+            mismatch = i;
+            break;
+        }
+        uint32_t deviation = a.timeMs > b.timeMs ? a.timeMs - b.timeMs : b.timeMs - a.timeMs;
+        if (deviation > maxDeviationMs) maxDeviationMs = deviation;
+    }
+
+    if (mismatch == n && produced.size() == expected.size()) {
+        printf("outputs match: %lu changes, same order, times within %lu ms\n", (unsigned long)expected.size(),
+               (unsigned long)maxDeviationMs);
+        return 0;
+    }
+
+    printf("outputs differ at change %lu of %lu recorded (%lu replayed)%s\n", (unsigned long)mismatch,
+           (unsigned long)expected.size(), (unsigned long)produced.size(), lost ? ", after a gap" : "");
+    if (mismatch < expected.size()) printChange("recorded", expected[mismatch]);
+    if (mismatch < produced.size()) printChange("replayed", produced[mismatch]);
+    return 1;
+}
+
+// --- SYNTHETIC DRIVE ---
+static std::mt19937 rng;
+
+static uint32_t between(uint32_t lo, uint32_t hi) { return lo + rng() % (hi - lo + 1); }
+static float noise(float amplitude) { return amplitude * ((int32_t)between(0, 2000) - 1000) / 1000.0f; }
+static bool chance(uint32_t oneIn) { return rng() % oneIn == 0; }
+
+static void spend(uint32_t us) { simUs += us; }
+
+// An obstacle drifts towards its target distance; a new target every few s
+struct Obstacle {
+    float cm = 500;
+    float targetCm = 500;
+
+    uint16_t echoUs() {
+        if (chance(12)) targetCm = chance(3) ? between(4, 60) : between(100, 600);
+        cm += (targetCm - cm) * 0.3f + noise(1);
+        if (cm < 2) cm = 2;
+        return cm > 400 ? 0 : (uint16_t)(cm * 58);   // No echo past ~4 m
+    }
+};
+
+static Obstacle front, back;
+static int8_t temp = 24, humidity = 50;
+#if FEATURE_MPU
+static float turnRate = 0;
+#endif
+static std::vector<uint8_t> synthOut;
+
+#if FEATURE_PEER
+static bool peerLeft = false, peerRight = false;
+#if CAR_ROLE == ROLE_MAIN
+static bool peerFound = true;
+static bool car2Off = false;    // --car2-off: Car 2 never answers
+#endif
+
+// HTTP to the other car; one call in 50 waits out the 1 s timeout
+#define STALL_MS 1000
+static void httpCall() { spend(chance(50) ? STALL_MS * 1000 : between(4000, 40000)); }
+#endif
+
+static void sensorsJob() {
+    uint32_t now = millis();
+
+    // DHT11: whole degrees and percent; a failed read now and then
+    spend(between(5000, 8000));
+    if (chance(40)) temp += chance(2) ? 1 : -1;
+    if (chance(20)) humidity += chance(2) ? 1 : -1;
+    applyClimate(now, chance(100) ? NAN : temp, humidity);
+
+    // Each echo takes its round trip, or the 30 ms timeout
+    uint16_t frontUs = front.echoUs(), backUs = back.echoUs();
+    spend((frontUs ? frontUs : CONFIG.echoTimeoutUs) + (backUs ? backUs : CONFIG.echoTimeoutUs));
+    applyEchoes(now, frontUs, backUs);
+
+#if FEATURE_MPU
+    if (chance(20)) turnRate = chance(2) ? noise(1.5f) : 0;
+    spend(between(800, 1200));
+    applyMotion(now, noise(2), noise(2), 9.81f + noise(0.5f), turnRate + noise(0.05f));
+#endif
+}
+
+static void outputsJob() {
+    spend(between(30, 200));
+    resolve(millis());
+}
+
+#if FEATURE_PEER
+#if CAR_ROLE == ROLE_MAIN
+static void peerCheckJob() {
+    httpCall();
+    if (!car2Off && chance(30)) peerFound = !peerFound;
+    applyPeerStatus(millis(), peerFound, peerLeft, peerRight);
+}
+#endif
+
+// The firmware's "peer" subscriber and its resend job: each send gets the
+// other car's indicators back
+static void sendToPeer() {
+    httpCall();
+    applyPeerReply(millis(), peerLeft, peerRight);
+}
+
+static void onPeerState(uint32_t) { sendToPeer(); }
+#endif
+
+static void flushJob() {
+    uint8_t chunk[256];
+    size_t len;
+    while ((len = recorder.read(chunk, sizeof(chunk))) > 0) synthOut.insert(synthOut.end(), chunk, chunk + len);
+}
+
+static uint32_t schedClock() { return micros(); }
+
+static int synth(double hours, const char *path) {
+    Scheduler<8> sched(schedClock);
+    simUs = 3000000;        // Setup takes a few seconds
+    recorder.start(CAR_ROLE, logicConfigHash());
+
+    sched.add("sensors", sensorsJob, CONFIG.sensorMs, 0);
+    sched.add("outputs", outputsJob, CONFIG.outputMs, 3);
+#if FEATURE_PEER
+#if CAR_ROLE == ROLE_MAIN
+    sched.add("peer_check", peerCheckJob, CONFIG.peerCheckMs, 375);
+#endif
+    sched.add("peer_send", sendToPeer, CONFIG.peerSendMs, 125);
+#endif
+    sched.add("record", flushJob, CONFIG.recordFlushMs, 690);
+
+    subscribeOutputs();
+#if FEATURE_PEER
+    stateEvents.subscribe("peer", EVENT_BIT(FIELD_LEFT) | EVENT_BIT(FIELD_RIGHT) | EVENT_BIT(FIELD_BUZZER) |
+                          EVENT_BIT(FIELD_AMBIENT) | EVENT_BIT(FIELD_PEER_CONNECTED), 0, onPeerState);
+#endif
+    sched.start();
+
+    // Things that happen outside the loop: button ISRs, the other car's
+    // /update and dashboard commands on async_tcp
+    uint64_t endUs = simUs + (uint64_t)(hours * 3600e6);
+    uint64_t nextPress = simUs + between(1000000, 20000000);
+    uint64_t nextUpdate = simUs + between(1000000, 30000000);
+    uint64_t nextCommand = simUs + between(1000000, 60000000);
+    bool leftPressed = false, rightPressed = false;
+
+    while (simUs < endUs) {
+        spend(between(20, 150));    // Serial poll, ws.cleanupClients()
+
+        if (simUs >= nextPress) {
+            nextPress = simUs + between(150, 20000000);
+            if (CONFIG.pins.rightButton == NO_PIN || chance(2)) leftPressed = true;
+            else rightPressed = true;
+        }
+        if (simUs >= nextUpdate) {
+            nextUpdate = simUs + between(500000, 30000000);
+#if FEATURE_PEER
+            peerLeft = chance(3);
+            peerRight = !peerLeft && chance(3);
+            UpdateBody body;
+            body.set(UPDATE_LEFT, peerLeft);
+            body.set(UPDATE_RIGHT, peerRight);
+            if (chance(4)) body.set(UPDATE_BUZZER, !chance(4));
+            if (chance(4)) body.set(UPDATE_AMBIENT, !chance(4));
+            applyPeerUpdate(millis(), body);
+#endif
+        }
+        if (simUs >= nextCommand) {
+            nextCommand = simUs + between(1000000, 60000000);
+#if FEATURE_DASHBOARD
+            applyCommand(millis(), (CommandTarget)between(0, COMMAND_TARGETS - 1), chance(2));
+#endif
+        }
+
+        bool left = leftPressed, right = rightPressed;
+        leftPressed = rightPressed = false;
+        handleButtons(millis(), left, right);
+        stateEvents.dispatch();
+        sched.run();
+        stateEvents.dispatch();
+
+        // Sleep in whole ticks until the next deadline, or until something
+        // from outside wakes the loop
+        uint64_t wake = nextPress < nextUpdate ? nextPress : nextUpdate;
+        if (nextCommand < wake) wake = nextCommand;
+        uint32_t idleUs = sched.idleUs() < stateEvents.idleUs() ? sched.idleUs() : stateEvents.idleUs();
+        if (idleUs >= 1000) {
+            uint64_t sleepUs = idleUs / 1000 * 1000;
+            if (wake > simUs && wake - simUs < sleepUs) sleepUs = wake - simUs;
+            spend(sleepUs);
+        }
+    }
+    flushJob();
+
+    FILE *out = fopen(path, "wb");
+    if (!out || fwrite(synthOut.data(), 1, synthOut.size(), out) != synthOut.size()) {
+        fprintf(stderr, "replay: can't write %s\n", path);
+        return 1;
+    }
+    fclose(out);
+
+    const RecordStats &stats = recorder.stats();
+    printf("%s: %.1f h simulated, %lu records, %lu bytes (%.0f KB/h), %lu lost\n", path, hours,
+           (unsigned long)stats.records, (unsigned long)synthOut.size(), synthOut.size() / 1024.0 / hours,
+           (unsigned long)stats.lost);
+
+#if FEATURE_PEER && FEATURE_AMBIENT
+    // Resolved every outputMs, unless a stalled HTTP call holds the loop, so
+    // the pulse may outlast its window by that much
+    bool ok = car2Off ? peerLostShown == 0
+                      : peerLostLongestMs <= CONFIG.peerLostAlertMs + CONFIG.outputMs + STALL_MS;
+    printf("peer-lost pulse: shown %lu times, up to %lu ms after the drop (limit %lu ms)%s\n", (unsigned long)peerLostShown,
+           (unsigned long)peerLostLongestMs, (unsigned long)(car2Off ? 0 : CONFIG.peerLostAlertMs),
+           ok ? "" : "  FAILED");
+    if (!ok) return 1;
+#endif
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    if (argc >= 4 && strcmp(argv[1], "--synth") == 0) {
+        rng.seed(argc > 4 ? strtoul(argv[4], NULL, 10) : 1);
+#if FEATURE_PEER && FEATURE_AMBIENT
+        car2Off = argc > 5 && strcmp(argv[5], "--car2-off") == 0;
+        peerFound = !car2Off;
+#endif
+        return synth(atof(argv[2]), argv[3]);
+    }
+    if (argc == 2) return replay(argv[1]);
+
+    fprintf(stderr, "usage: replay recording.bin\n       replay --synth <hours> <out.bin> [seed] [--car2-off]\n");
+    return 1;
+}
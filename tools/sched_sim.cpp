@@ -0,0 +1,190 @@
+/*
+ * Smart Car Dashboard - Scheduler Simulation
+ * Author: Stromlabs - Pavan Kalsariya
+ * Description: Runs the firmware's job table through scheduler.h on a
+ * simulated clock for a long drive (24 h by default), with job costs drawn
+ * from what the firmware actually spends: a DHT read and two pulseIn()
+ * calls per sensor job, HTTP calls to the other car that now and then hit
+ * their 1 s timeout, and a short WebSocket push. The clock starts just
+ * before the 32-bit microsecond counter wraps.
+ *
+ * Checks that every job's runs plus skipped periods match elapsed time
+ * exactly (no drift), and reports lateness per job. The same workload is
+ * then run through the old "if (now - last > N) last = now" checks for
+ * comparison.
+ *
+ * Build (Linux):
+ *   g++ -std=c++17 -O2 -I tools/host -I . tools/sched_sim.cpp -o sched_sim
+ *
+ * Usage:
+ *   ./sched_sim [hours] [seed] [timeoutEvery]
+ *   default 24 hours, seed 1, one HTTP call in 50 times out (0: none)
+ */
+
+#include <Arduino.h>
+
+#include <random>
+
+// --- SIMULATED CLOCK ---
+// The firmware headers' view of time, which the host shim doesn't carry.
+// Kept in 64 bits; micros() and millis() wrap like the ESP32's.
+static uint64_t simUs = 0xFFFFFFFFu - 10000000u;   // micros() wraps 10 s in
+
+static unsigned long micros() { return (uint32_t)simUs; }
+static unsigned long millis() { return (uint32_t)(simUs / 1000); }
+
+struct Print {
+    template <typename... Args>
+    void printf(const char *fmt, Args... args) { ::printf(fmt, args...); }
+};
+
+struct {
+    uint32_t getCpuFreqMHz() { return 240; }
+    uint32_t getCycleCount() { return (uint32_t)(simUs * 240); }
+} ESP;
+
+#include "scheduler.h"
+
+// --- WORKLOAD ---
+static std::mt19937 rng;
+
+static uint32_t between(uint32_t lo, uint32_t hi) { return lo + rng() % (hi - lo + 1); }
+
+static void spend(uint32_t us) { simUs += us; }
+
+// Heavy jobs that ran in the current loop pass
+static uint8_t heavyRan = 0;
+
+// DHT (~5 ms) plus two echoes (up to the 30 ms timeout each when clear)
+static void sensors() { heavyRan++; spend(between(5000, 8000) + between(300, 30000) + between(300, 30000)); }
+static void outputs() { spend(between(30, 200)); }
+// HTTP to the other car; one call in timeoutEvery waits out the 1 s timeout
+static uint32_t timeoutEvery = 50;
+static void http() {
+    heavyRan++;
+    spend(timeoutEvery && rng() % timeoutEvery == 0 ? 1000000 : between(4000, 40000));
+}
+static void wsPush() { spend(between(500, 3000)); }
+static void runtimePush() { spend(between(2000, 6000)); }
+static void heap() { spend(between(200, 800)); }
+
+struct JobSpec {
+    const char *name;
+    JobFn fn;
+    uint32_t periodMs;
+    uint32_t phaseMs;
+};
+
+// Car 1's table and phases, as registered in setup(). Sends made at once on
+// a state change (events.h) come on top and aren't modelled.
+static const JobSpec JOBS[] = {
+    {"sensors", sensors, 250, 0},
+    {"outputs", outputs, 20, 3},
+    {"car2_check", http, 2000, 375},
+    {"car2_send", http, 2000, 125},
+    {"ws_push", wsPush, 100, 30},
+    {"runtime_push", runtimePush, 10000, 5040},
+    {"heap", heap, 30000, 15090},
+};
+static const uint8_t kJobs = sizeof(JOBS) / sizeof(JOBS[0]);
+
+// Per loop pass: serial poll, buttons, ws.cleanupClients()
+static void loopOverhead() { spend(between(20, 150)); }
+
+// --- SCHEDULER RUN ---
+static uint32_t schedClock() { return micros(); }
+
+static int runScheduler(uint64_t durationUs) {
+    Scheduler<8> sched(schedClock);
+    for (uint8_t i = 0; i < kJobs; i++) sched.add(JOBS[i].name, JOBS[i].fn, JOBS[i].periodMs, JOBS[i].phaseMs);
+    uint64_t startUs = simUs;
+    sched.start();
+
+    uint64_t sleptUs = 0;
+    unsigned long passes = 0, heavyTogether = 0;
+    while (simUs - startUs < durationUs) {
+        loopOverhead();
+        heavyRan = 0;
+        sched.run();
+        if (heavyRan > 1) heavyTogether++;
+        passes++;
+
+        // The firmware sleeps whole ticks (1 ms) until the next deadline
+        uint32_t idle = sched.idleUs();
+        if (idle >= 1000) {
+            spend(idle / 1000 * 1000);
+            sleptUs += idle / 1000 * 1000;
+        }
+    }
+
+    printf("scheduler: %lu passes, asleep %.1f%% of the time, %lu passes ran more than one heavy job\n", passes,
+           100.0 * sleptUs / (simUs - startUs), heavyTogether);
+    printf("  %-12s %8s %9s %8s %8s %8s %8s  %s\n", "job", "period", "runs", "skipped", "p50", "p99", "max",
+           "(lateness, us)");
+    int failures = 0;
+    for (uint8_t i = 0; i < kJobs; i++) {
+        const Job &job = sched.job(i);
+        // Deadlines that have passed since start, on the job's own grid
+        uint64_t due = (simUs - startUs - job.phaseUs) / job.periodUs + 1;
+        uint32_t accounted = job.runs + job.skipped;
+        bool ok = accounted == due || accounted == due + 1;     // The last may be mid-run
+        printf("  %-12s %8lu %9lu %8lu %8lu %8lu %8lu  %s\n", job.name, (unsigned long)(job.periodUs / 1000),
+               (unsigned long)job.runs, (unsigned long)job.skipped, (unsigned long)job.lateness.percentileUs(50),
+               (unsigned long)job.lateness.percentileUs(99), (unsigned long)job.lateness.maxUs(),
+               ok ? "" : "DRIFT");
+        if (!ok) failures++;
+    }
+    return failures;
+}
+
+// --- LEGACY RUN ---
+// The checks this replaced: "> N" and last = now, in a loop that never sleeps
+static void runLegacy(uint64_t durationUs) {
+    uint32_t last[kJobs];
+    unsigned long runs[kJobs] = {};
+    unsigned long heavyTogether = 0, passes = 0;
+    for (uint8_t i = 0; i < kJobs; i++) last[i] = millis();
+
+    uint64_t startUs = simUs;
+    while (simUs - startUs < durationUs) {
+        loopOverhead();
+        uint32_t now = millis();
+        heavyRan = 0;
+        for (uint8_t i = 0; i < kJobs; i++) {
+            // outputs ran every pass in the old loop
+            if (i == 1 || now - last[i] > JOBS[i].periodMs) {
+                if (i != 1) last[i] = now;
+                JOBS[i].fn();
+                runs[i]++;
+            }
+        }
+        if (heavyRan > 1) heavyTogether++;
+        passes++;
+    }
+    uint64_t elapsed = simUs - startUs;
+
+    printf("legacy checks: %lu passes, never asleep, %lu passes ran more than one heavy job\n", passes,
+           heavyTogether);
+    for (uint8_t i = 0; i < kJobs; i++) {
+        if (i == 1) continue;
+        double mean = elapsed / 1000.0 / runs[i];
+        printf("  %-12s mean period %9.2f ms (%+.1f%%)\n", JOBS[i].name, mean,
+               100.0 * (mean - JOBS[i].periodMs) / JOBS[i].periodMs);
+    }
+}
+
+int main(int argc, char **argv) {
+    double hours = argc > 1 ? atof(argv[1]) : 24;
+    uint32_t seed = argc > 2 ? strtoul(argv[2], NULL, 10) : 1;
+    if (argc > 3) timeoutEvery = strtoul(argv[3], NULL, 10);
+    uint64_t durationUs = (uint64_t)(hours * 3600e6);
+
+    rng.seed(seed);
+    int failures = runScheduler(durationUs);
+
+    rng.seed(seed);
+    runLegacy(durationUs);
+
+    printf("%s\n", failures ? "FAILED: periods drifted" : "no drift: every deadline accounted for");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,222 @@
+/*
+ * Smart Car Dashboard - Collision Warning Simulation
+ * Author: Stromlabs - Pavan Kalsariya
+ * Description: Drives ttc.h through simulated ultrasonic readings at the
+ * firmware's sensor rate, with HC-SR04-like noise and dropped echoes, and
+ * compares its warnings with the fixed-distance alerts (proximity and
+ * obstacle from config.h). Scenarios:
+ *
+ *   approach   straight at a wall at several speeds, until impact
+ *   brake      a hard stop short of the wall, with and without the IMU
+ *   creep      parking slowly up to a wall
+ *   parked     standing 20 cm from a wall
+ *   crossing   something passes in front of the sensor and is gone
+ *
+ * Reports how long before impact each warning came, and how long warnings
+ * stayed up where there was nothing to hit. Then times update() on the host.
+ *
+ * Build (Linux):
+ *   g++ -std=c++17 -O2 -I tools/host -I . tools/ttc_sim.cpp -o ttc_sim
+ *
+ * Usage:
+ *   ./ttc_sim [seed]
+ */
+
+#include <Arduino.h>
+
+#include <chrono>
+#include <cmath>
+#include <random>
+
+#include "config.h"
+#include "fixedmath.h"
+#include "ttc.h"
+
+// --- SIMULATED SENSORS ---
+static std::mt19937 rng;
+
+#define NOISE_MM 4.0            // HC-SR04 jitter, one sigma
+#define DROPOUT_PCT 3           // Echoes lost to an angled surface
+
+static uint16_t echo(double mm) {
+    if (rng() % 100 < DROPOUT_PCT || mm > 4000) return ECHO_NONE_MM;
+    std::normal_distribution<double> noise(0, NOISE_MM);
+    double read = mm + noise(rng);
+    return read < 20 ? 20 : (uint16_t)read;     // Nothing nearer than 2 cm echoes cleanly
+}
+
+// Accelerometer x in mm/s^2: the car's acceleration plus a mounting offset and vibration
+static int32_t accel(double mms2) {
+    std::normal_distribution<double> noise(0, 150);
+    return lround(mms2 + 250 + noise(rng));
+}
+
+// --- SCENARIOS ---
+// When each warning first came up, in ms before impact (or the run's end)
+struct Warnings {
+    int32_t proximity = -1, obstacle = -1;
+    int32_t level[COLLISION_LEVELS] = {-1, -1, -1, -1};
+    uint32_t collisionMs = 0;   // Time with any collision warning up
+};
+
+typedef double (*SpeedFn)(double t, double range);    // Closing speed in mm/s at time t (s)
+
+// range0: starting distance in mm. Ends at impact or after seconds.
+static Warnings run(double range0, SpeedFn speed, double seconds, bool imu) {
+    CollisionPredictor predictor(CONFIG.ttcCautionMs, CONFIG.ttcWarningMs, CONFIG.ttcCriticalMs);
+    Warnings w;
+    const uint32_t stepMs = CONFIG.sensorMs;
+    double range = range0, lastSpeed = speed(0, range0);
+    uint32_t now = 1000;
+    uint32_t endMs = seconds * 1000;
+
+    // The bias filter settles while parked before the run starts
+    for (int i = 0; imu && i < 200; i++) predictor.motion(accel(0));
+
+    for (uint32_t t = 0; t <= endMs && range > 0; t += stepMs, now += stepMs) {
+        uint16_t mm = echo(range);
+        predictor.update(now, mm, ECHO_NONE_MM);
+        int32_t left = endMs - t;
+        if (mm < CONFIG.proximityCm * 10 && w.proximity < 0) w.proximity = left;
+        if (mm < CONFIG.obstacleCm * 10 && w.obstacle < 0) w.obstacle = left;
+        for (uint8_t l = COLLISION_NONE; l <= predictor.level(); l++) {
+            if (w.level[l] < 0) w.level[l] = left;     // A level skipped counts as reached
+        }
+        if (predictor.level() != COLLISION_NONE) w.collisionMs += stepMs;
+
+        // Move on to the next reading
+        double v = speed(t / 1000.0, range);
+        if (imu) predictor.motion(accel((v - lastSpeed) * 1000 / stepMs));
+        lastSpeed = v;
+        range -= v * stepMs / 1000;
+    }
+    return w;
+}
+
+static double approachSpeed;
+static double constantSpeed(double, double) { return approachSpeed; }
+
+// 1 m/s, then 3 m/s^2 of braking from 1.6 m to stop at about 1.4 m
+static double braking(double t, double range) {
+    static double v;
+    if (t == 0) v = 1000;
+    if (range < 1600) v = v > 750 ? v - 750 : 0;    // 3 m/s^2 over a 250 ms step
+    return v;
+}
+
+static double creeping(double, double range) { return range > 60 ? 40 : 0; }
+static double parked(double, double) { return 0; }
+
+static int failures = 0;
+
+static void check(bool ok, const char *what) {
+    if (!ok) {
+        printf("FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+static void printLead(int32_t ms) {
+    if (ms < 0) printf("%9s", "-");
+    else printf("%8.2fs", ms / 1000.0);
+}
+
+int main(int argc, char **argv) {
+    rng.seed(argc > 1 ? atoi(argv[1]) : 1);
+    printf("sensor every %u ms; caution %u ms, warning %u ms, critical %u ms; proximity %.0f cm, obstacle %.0f cm\n\n",
+           CONFIG.sensorMs, CONFIG.ttcCautionMs, CONFIG.ttcWarningMs, CONFIG.ttcCriticalMs, CONFIG.proximityCm,
+           CONFIG.obstacleCm);
+
+    // Approach: lead time before impact, averaged over runs
+    printf("approach from 2.9 m, warning lead before impact (average of 50)\n");
+    printf("%8s %9s %9s %9s %9s %9s\n", "speed", "proximity", "obstacle", "caution", "warning", "critical");
+    const double speeds[] = {300, 600, 1000, 1500, 2000};
+    for (double v : speeds) {
+        approachSpeed = v;
+        double seconds = 2900 / v;
+        int64_t sums[5] = {};
+        int counts[5] = {};
+        for (int i = 0; i < 50; i++) {
+            Warnings w = run(2900, constantSpeed, seconds, false);
+            int32_t leads[5] = {w.proximity, w.obstacle, w.level[COLLISION_CAUTION], w.level[COLLISION_WARNING],
+                                w.level[COLLISION_CRITICAL]};
+            for (int k = 0; k < 5; k++) {
+                if (leads[k] >= 0) {
+                    sums[k] += leads[k];
+                    counts[k]++;
+                }
+            }
+        }
+        printf("%6.1f/s", v / 1000);
+        for (int k = 0; k < 5; k++) printLead(counts[k] ? sums[k] / counts[k] : -1);
+        printf("\n");
+        check(counts[4] == 50, "a critical warning before every impact");
+        // Caution can't come before the tracker has its first readings at 2.9 m
+        double ahead = seconds * 1000 - (TTC_MIN_SAMPLES - 1) * CONFIG.sensorMs;
+        if (ahead > CONFIG.ttcCautionMs) ahead = CONFIG.ttcCautionMs;
+        check(counts[2] == 50 && sums[2] / 50 >= ahead * 3 / 4, "caution most of its time ahead");
+    }
+
+    // Nothing to hit: how long warnings were up
+    printf("\nno impact, time with a collision warning up (total of 50 runs)\n");
+    struct {
+        const char *name;
+        double range0;
+        SpeedFn speed;
+        double seconds;
+        bool imu;
+        uint32_t allowedMs;
+    } quiet[] = {
+        {"brake (echo only)", 2900, braking, 5, false, UINT32_MAX},
+        {"brake (with IMU)", 2900, braking, 5, true, UINT32_MAX},
+        {"creep at 4 cm/s", 500, creeping, 15, false, 0},
+        {"parked at 20 cm", 200, parked, 30, false, 0},
+    };
+    uint32_t brakeMs[2] = {};
+    for (int q = 0; q < 4; q++) {
+        uint32_t total = 0;
+        int critical = 0;
+        for (int i = 0; i < 50; i++) {
+            Warnings w = run(quiet[q].range0, quiet[q].speed, quiet[q].seconds, quiet[q].imu);
+            total += w.collisionMs;
+            if (w.level[COLLISION_CRITICAL] >= 0) critical++;
+        }
+        printf("  %-20s %8.2fs  critical in %d runs\n", quiet[q].name, total / 1000.0, critical);
+        if (q < 2) {
+            brakeMs[q] = total;
+            check(critical == 0, "no critical warning for a stop 1.4 m short");
+        }
+        if (quiet[q].allowedMs == 0) check(total == 0, "no warning without a closing obstacle");
+    }
+    check(brakeMs[1] <= brakeMs[0], "the IMU shortens warnings once braking");
+
+    // Crossing: 9990 mm, then 0.5 s of something at 50 cm, then clear again
+    {
+        CollisionPredictor predictor(CONFIG.ttcCautionMs, CONFIG.ttcWarningMs, CONFIG.ttcCriticalMs);
+        uint32_t upMs = 0;
+        for (uint32_t t = 0; t < 5000; t += CONFIG.sensorMs) {
+            uint16_t mm = (t >= 2000 && t < 2500) ? echo(500) : ECHO_NONE_MM;
+            predictor.update(t, mm, ECHO_NONE_MM);
+            if (predictor.level() != COLLISION_NONE) upMs += CONFIG.sensorMs;
+        }
+        printf("  %-20s %8.2fs\n", "crossing at 50 cm", upMs / 1000.0);
+        check(upMs == 0, "no warning for something passing by");
+    }
+
+    // Cost per update, both sensors
+    {
+        CollisionPredictor predictor(CONFIG.ttcCautionMs, CONFIG.ttcWarningMs, CONFIG.ttcCriticalMs);
+        const uint32_t n = 10000000;
+        uint32_t sink = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < n; i++) {
+            predictor.update(i * 250, 2500 - (i % 2000), 1000 + (i % 7));
+            sink += predictor.ttcMs();
+        }
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / n;
+        printf("\nupdate(): %.1f ns per reading on this host (%u)\n", ns, sink & 1);
+    }
+
+    printf(failures ? "\n%d checks failed\n" : "\nall checks passed\n", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,247 @@
+/*
+ * Smart Car Dashboard - /update Body Test and Benchmark
+ * Author: Stromlabs - Pavan Kalsariya
+ * Description: Feeds randomly generated /update bodies through the firmware's
+ * BodyPool and parser (updatebody.h), split into random chunks the way TCP
+ * segments reach ESPAsyncWebServer, with several requests interleaved. Each
+ * body is checked against what it was generated from: valid bodies must
+ * apply exactly their fields, broken ones must be rejected and nothing else.
+ * Then reports throughput for the same path.
+ *
+ * Build (Linux):
+ *   g++ -std=c++17 -O2 -I tools/host -I . tools/update_bench.cpp -o update_bench
+ *
+ * Usage:
+ *   ./update_bench [bodies] [seed]      default 200000 bodies, seed 1
+ */
+
+#include <Arduino.h>
+#include "updatebody.h"
+
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+static const uint8_t kSlots = 4;
+static const size_t kSize = 256;
+typedef BodyPool<kSlots, kSize> Pool;
+
+// --- BODY GENERATOR ---
+enum Expect : uint8_t { EXPECT_OK, EXPECT_INVALID, EXPECT_TOO_LARGE, EXPECT_BAD_CHUNK };
+
+struct TestBody {
+    std::string text;
+    UpdateBody fields;
+    Expect expect;
+};
+
+class Generator {
+public:
+    explicit Generator(uint32_t seed) : rng_(seed) {}
+
+    TestBody next() {
+        TestBody body;
+        body.text = valid(body.fields);
+        body.expect = EXPECT_OK;
+
+        // One body in five is broken in some way
+        switch (pick(10)) {
+            case 0: {
+                // Cut short: a prefix of an object is never valid
+                body.text.resize(pick(body.text.size() - 1));
+                if (body.text.empty()) body.text = "{";
+                body.expect = EXPECT_INVALID;
+                break;
+            }
+            case 1: {
+                // A known key with a non-bool value
+                static const char *const bad[] = {"1", "\"true\"", "null", "{}", "[true]", "tru"};
+                body.text = "{\"leftIndicator\":" + std::string(bad[pick(6)]) + "}";
+                body.expect = EXPECT_INVALID;
+                break;
+            }
+            case 2: {
+                // Padding past the buffer
+                body.text.insert(1, std::string(kSize, ' '));
+                body.expect = EXPECT_TOO_LARGE;
+                break;
+            }
+            case 3:
+                body.expect = EXPECT_BAD_CHUNK;
+                break;
+        }
+        if (body.expect != EXPECT_OK) body.fields = UpdateBody();
+        return body;
+    }
+
+    uint32_t pick(uint32_t n) { return n ? rng_() % n : 0; }
+
+private:
+    std::string space() {
+        static const char *const ws[] = {"", "", " ", "\n  ", "\t"};
+        return ws[pick(5)];
+    }
+
+    std::string valid(UpdateBody &fields) {
+        std::vector<std::string> members;
+        for (uint8_t f = 0; f < UPDATE_FIELDS; f++) {
+            if (pick(4) == 0) continue;
+            bool value = pick(2);
+            fields.set((UpdateField)f, value);
+            members.push_back(std::string("\"") + UPDATE_FIELD_KEYS[f] + "\"" + space() + ":" + space() +
+                              (value ? "true" : "false"));
+        }
+        // Unknown keys the firmware should skip
+        static const char *const extra[] = {"\"seq\":17", "\"from\":\"car2\"", "\"note\":\"a \\\"quoted\\\" word\"",
+                                            "\"rssi\":-61.5e0", "\"x\":null"};
+        if (pick(3) == 0) members.insert(members.begin() + pick(members.size() + 1), extra[pick(5)]);
+
+        std::string text = "{" + space();
+        for (size_t i = 0; i < members.size(); i++) {
+            if (i) text += "," + space();
+            text += members[i];
+        }
+        return text + space() + "}";
+    }
+
+    std::mt19937 rng_;
+};
+
+// --- FRAGMENTED DELIVERY ---
+// One request in flight: its body and where the next chunk starts
+struct Request {
+    TestBody body;
+    size_t sent = 0;
+    bool corrupted = false;
+};
+
+struct Results {
+    unsigned long bodies = 0;
+    unsigned long chunks = 0;
+    unsigned long bytes = 0;
+    unsigned long failures = 0;
+};
+
+static bool sameFields(const UpdateBody &a, const UpdateBody &b) {
+    return a.present == b.present && (a.values & a.present) == (b.values & b.present);
+}
+
+// Send the next chunk of req. Returns true when the request is finished.
+static bool feed(Pool &pool, Request &req, Generator &gen, uint32_t now, Results &results, bool check) {
+    const std::string &text = req.body.text;
+    size_t total = text.size();
+    size_t remaining = total - req.sent;
+    size_t len = remaining <= 1 ? remaining : 1 + gen.pick(remaining < 64 ? remaining : 64);
+    size_t index = req.sent;
+
+    // A bad-chunk body skips ahead once, leaving a gap, so it needs a second chunk
+    if (req.body.expect == EXPECT_BAD_CHUNK && index == 0 && len > total / 2) len = total / 2;
+    if (req.body.expect == EXPECT_BAD_CHUNK && !req.corrupted && index > 0) {
+        index++;
+        if (len > total - index) len = total - index;
+        req.corrupted = true;
+    }
+
+    Pool::Slot *slot = pool.receive(&req, (const uint8_t *)text.data() + index, len, index, total, now);
+    req.sent = index + len;
+    results.chunks++;
+    results.bytes += len;
+
+    UpdateBody parsed;
+    bool applied = slot && pool.parse(slot, parsed);
+    if (req.sent < total && !(slot && slot->status != BODY_RECEIVING)) return false;
+
+    // Done: last chunk in, or rejected early
+    if (check) {
+        BodyStatus status = slot ? slot->status : BODY_INVALID;
+        bool ok = false;
+        switch (req.body.expect) {
+            case EXPECT_OK:        ok = applied && status == BODY_OK && sameFields(parsed, req.body.fields); break;
+            case EXPECT_INVALID:   ok = !applied && status == BODY_INVALID; break;
+            case EXPECT_TOO_LARGE: ok = !applied && status == BODY_TOO_LARGE; break;
+            case EXPECT_BAD_CHUNK: ok = !applied && status == BODY_BAD_CHUNK; break;
+        }
+        if (!ok) {
+            if (results.failures < 5) {
+                fprintf(stderr, "FAIL expect %d status %d: %s\n", req.body.expect, status, text.c_str());
+            }
+            results.failures++;
+        }
+    }
+    pool.release(&req);
+    results.bodies++;
+    return true;
+}
+
+static Results run(unsigned long count, uint32_t seed, bool check) {
+    Pool pool;
+    Generator gen(seed);
+    Request inFlight[kSlots];
+    bool active[kSlots] = {};
+    unsigned long started = 0;
+    uint32_t now = 0;
+    Results results;
+
+    while (results.bodies < count) {
+        // Chunks from different requests interleave
+        uint8_t i = gen.pick(kSlots);
+        if (!active[i]) {
+            if (started == count) continue;
+            inFlight[i] = Request();
+            inFlight[i].body = gen.next();
+            active[i] = true;
+            started++;
+        }
+        if (feed(pool, inFlight[i], gen, now++, results, check)) active[i] = false;
+    }
+
+    if (check && pool.inUse() != 0) {
+        fprintf(stderr, "FAIL %u slots still in use\n", pool.inUse());
+        results.failures++;
+    }
+    return results;
+}
+
+int main(int argc, char **argv) {
+    unsigned long count = argc > 1 ? strtoul(argv[1], NULL, 10) : 200000;
+    uint32_t seed = argc > 2 ? strtoul(argv[2], NULL, 10) : 1;
+
+    // Correctness: every body checked against its expectation
+    Results checked = run(count, seed, true);
+    printf("checked %lu bodies in %lu chunks: %lu failures\n", checked.bodies, checked.chunks, checked.failures);
+
+    // Parser alone on whole valid bodies
+    Generator gen(seed);
+    std::vector<std::string> texts;
+    for (int i = 0; i < 1000; i++) {
+        TestBody body = gen.next();
+        if (body.expect == EXPECT_OK) texts.push_back(body.text);
+    }
+    size_t textBytes = 0;
+    for (const std::string &t : texts) textBytes += t.size();
+
+    const int rounds = 2000;
+    auto start = std::chrono::steady_clock::now();
+    unsigned long parsedOk = 0;
+    for (int r = 0; r < rounds; r++) {
+        for (const std::string &t : texts) {
+            UpdateBody body;
+            parsedOk += UpdateBodyParser::parse(t.data(), t.size(), body);
+        }
+    }
+    double parseSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double parseBodies = (double)rounds * texts.size();
+    printf("parser: %.0f bodies/s, %.1f MB/s (mean body %.0f bytes)\n", parseBodies / parseSec,
+           rounds * textBytes / parseSec / 1e6, (double)textBytes / texts.size());
+    if (parsedOk != parseBodies) checked.failures++;
+
+    // Whole path: fragmented delivery through the pool, then parse
+    start = std::chrono::steady_clock::now();
+    Results timed = run(count, seed + 1, false);
+    double pathSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("pool + parser: %.0f bodies/s, %.1f MB/s, %.1f chunks per body\n", timed.bodies / pathSec,
+           timed.bytes / pathSec / 1e6, (double)timed.chunks / timed.bodies);
+
+    return checked.failures ? 1 : 0;
+}
@@ -0,0 +1,782 @@
+/*
+ * Smart Car Dashboard - WebSocket Load Generator
+ * Author: Stromlabs - Pavan Kalsariya
+ * Description: Opens N dashboard clients against Car 1's /ws endpoint and
+ * measures delivered frame rate, command round-trip latency and server CPU
+ * per client, for a sweep of N. Results are printed as one JSON object per
+ * line so runs against different firmware revisions can be compared.
+ *
+ * Without --target, an in-process stand-in of Car 1 is started: the same
+ * telemetry push (on change, at most every wsPushMs, with a keepalive after
+ * wsKeepaliveMs of quiet), connect snapshot, history replay frame (built
+ * with the firmware's history.h) and set/ack command handling, served over
+ * a local socket. Server CPU is only known for the stand-in.
+ *
+ * Build (Linux):
+ *   g++ -std=c++17 -O2 -pthread -I tools/host -I . tools/ws_loadgen.cpp -o ws_loadgen
+ *
+ * Usage:
+ *   ./ws_loadgen                                  sweep 1..32 against the stand-in
+ *   ./ws_loadgen --target 192.168.4.1:80          sweep against a real Car 1
+ *   ./ws_loadgen --sweep 1,4,16 --duration 20 --label fw-abc123 > results.ndjson
+ *   ./ws_loadgen --serve 8080                     only run the stand-in
+ */
+
+#include <Arduino.h>
+#include "config.h"
+#include "history.h"
+#include "jsonwriter.h"
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+// --- CLOCKS ---
+static double nowMs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+static double threadCpuMs(pthread_t thread) {
+    clockid_t id;
+    timespec ts;
+    if (pthread_getcpuclockid(thread, &id) != 0 || clock_gettime(id, &ts) != 0) return 0;
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+// --- SHA-1 / BASE64 (WebSocket handshake only) ---
+static void sha1(const uint8_t *data, size_t len, uint8_t out[20]) {
+    uint32_t h[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+    std::vector<uint8_t> msg(data, data + len);
+    msg.push_back(0x80);
+    while (msg.size() % 64 != 56) msg.push_back(0);
+    uint64_t bits = (uint64_t)len * 8;
+    for (int i = 7; i >= 0; i--) msg.push_back(bits >> (i * 8));
+
+    auto rol = [](uint32_t v, int n) { return (v << n) | (v >> (32 - n)); };
+    for (size_t chunk = 0; chunk < msg.size(); chunk += 64) {
+        uint32_t w[80];
+        for (int i = 0; i < 16; i++) {
+            w[i] = msg[chunk + i * 4] << 24 | msg[chunk + i * 4 + 1] << 16 |
+                   msg[chunk + i * 4 + 2] << 8 | msg[chunk + i * 4 + 3];
+        }
+        for (int i = 16; i < 80; i++) w[i] = rol(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+
+        uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+        for (int i = 0; i < 80; i++) {
+            uint32_t f, k;
+            if (i < 20)      { f = (b & c) | (~b & d);          k = 0x5A827999; }
+            else if (i < 40) { f = b ^ c ^ d;                    k = 0x6ED9EBA1; }
+            else if (i < 60) { f = (b & c) | (b & d) | (c & d); k = 0x8F1BBCDC; }
+            else             { f = b ^ c ^ d;                    k = 0xCA62C1D6; }
+            uint32_t t = rol(a, 5) + f + e + k + w[i];
+            e = d; d = c; c = rol(b, 30); b = a; a = t;
+        }
+        h[0] += a; h[1] += b; h[2] += c; h[3] += d; h[4] += e;
+    }
+    for (int i = 0; i < 5; i++) {
+        out[i * 4] = h[i] >> 24; out[i * 4 + 1] = h[i] >> 16;
+        out[i * 4 + 2] = h[i] >> 8; out[i * 4 + 3] = h[i];
+    }
+}
+
+static std::string base64(const uint8_t *data, size_t len) {
+    static const char *chars = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string out;
+    for (size_t i = 0; i < len; i += 3) {
+        uint32_t n = data[i] << 16 | (i + 1 < len ? data[i + 1] << 8 : 0) | (i + 2 < len ? data[i + 2] : 0);
+        out += chars[(n >> 18) & 63];
+        out += chars[(n >> 12) & 63];
+        out += i + 1 < len ? chars[(n >> 6) & 63] : '=';
+        out += i + 2 < len ? chars[n & 63] : '=';
+    }
+    return out;
+}
+
+static std::string acceptKey(const std::string &key) {
+    std::string s = key + "258EAFA5-E914-47DA-95CA-C5AB0DC11B65";
+    uint8_t digest[20];
+    sha1((const uint8_t *)s.data(), s.size(), digest);
+    return base64(digest, 20);
+}
+
+// --- WEBSOCKET FRAMING ---
+enum { OP_TEXT = 1, OP_BINARY = 2, OP_CLOSE = 8 };
+
+static bool sendAll(int fd, const void *data, size_t len) {
+    const uint8_t *p = (const uint8_t *)data;
+    while (len > 0) {
+        ssize_t n = send(fd, p, len, MSG_NOSIGNAL);
+        if (n <= 0) return false;
+        p += n;
+        len -= n;
+    }
+    return true;
+}
+
+// Clients must mask, servers must not (RFC 6455 5.1)
+static bool sendFrame(int fd, uint8_t opcode, const void *payload, size_t len, bool mask) {
+    uint8_t header[14];
+    size_t h = 0;
+    header[h++] = 0x80 | opcode;
+    uint8_t maskBit = mask ? 0x80 : 0;
+    if (len < 126) {
+        header[h++] = maskBit | len;
+    } else if (len <= 0xFFFF) {
+        header[h++] = maskBit | 126;
+        header[h++] = len >> 8;
+        header[h++] = len & 0xFF;
+    } else {
+        header[h++] = maskBit | 127;
+        for (int i = 7; i >= 0; i--) header[h++] = (uint64_t)len >> (i * 8);
+    }
+
+    if (!mask) return sendAll(fd, header, h) && sendAll(fd, payload, len);
+
+    uint8_t key[4];
+    for (int i = 0; i < 4; i++) key[i] = rand() & 0xFF;
+    memcpy(header + h, key, 4);
+    h += 4;
+    std::string masked((const char *)payload, len);
+    for (size_t i = 0; i < len; i++) masked[i] ^= key[i % 4];
+    return sendAll(fd, header, h) && sendAll(fd, masked.data(), len);
+}
+
+// Accumulates bytes from a socket and yields complete frames
+struct FrameReader {
+    std::string buf;
+
+    // Returns false when the peer closed or errored
+    bool fill(int fd) {
+        char tmp[4096];
+        ssize_t n = recv(fd, tmp, sizeof(tmp), 0);
+        if (n <= 0) return false;
+        buf.append(tmp, n);
+        return true;
+    }
+
+    bool next(uint8_t &opcode, std::string &payload) {
+        if (buf.size() < 2) return false;
+        const uint8_t *p = (const uint8_t *)buf.data();
+        opcode = p[0] & 0x0F;
+        bool masked = p[1] & 0x80;
+        uint64_t len = p[1] & 0x7F;
+        size_t h = 2;
+        if (len == 126) {
+            if (buf.size() < 4) return false;
+            len = p[2] << 8 | p[3];
+            h = 4;
+        } else if (len == 127) {
+            if (buf.size() < 10) return false;
+            len = 0;
+            for (int i = 0; i < 8; i++) len = len << 8 | p[2 + i];
+            h = 10;
+        }
+        size_t keyAt = h;
+        if (masked) h += 4;
+        if (buf.size() < h + len) return false;
+
+        payload.assign(buf, h, len);
+        if (masked) {
+            for (size_t i = 0; i < len; i++) payload[i] ^= buf[keyAt + i % 4];
+        }
+        buf.erase(0, h + len);
+        return true;
+    }
+};
+
+// Tiny field lookups for the flat JSON objects this protocol uses
+static bool jsonNumber(const std::string &json, const char *key, double &out) {
+    std::string k = std::string("\"") + key + "\":";
+    size_t at = json.find(k);
+    if (at == std::string::npos) return false;
+    out = strtod(json.c_str() + at + k.size(), NULL);
+    return true;
+}
+
+static std::string jsonString(const std::string &json, const char *key) {
+    std::string k = std::string("\"") + key + "\":\"";
+    size_t at = json.find(k);
+    if (at == std::string::npos) return "";
+    size_t end = json.find('"', at + k.size());
+    return json.substr(at + k.size(), end - at - k.size());
+}
+
+static bool jsonBool(const std::string &json, const char *key) {
+    std::string k = std::string("\"") + key + "\":true";
+    return json.find(k) != std::string::npos;
+}
+
+// =================================================================
+//                      CAR 1 STAND-IN
+// =================================================================
+struct StandInState {
+    float temp = 24.0, humidity = 55.0, frontDist = 999.0, backDist = 999.0;
+    int speed = 0;
+    float direction = 0;
+    bool leftIndicator = false, rightIndicator = false, buzzerOn = true, ambientOn = true;
+    bool car2Connected = false, car2Left = false, car2Right = false;
+    const char *collision = "none";
+    bool collisionBack = false;
+    float ttc = -1;
+};
+
+class StandInServer {
+public:
+    bool start(uint16_t port) {
+        listenFd_ = socket(AF_INET, SOCK_STREAM, 0);
+        int one = 1;
+        setsockopt(listenFd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = htons(port);
+        if (bind(listenFd_, (sockaddr *)&addr, sizeof(addr)) != 0 || listen(listenFd_, 64) != 0) {
+            perror("stand-in bind");
+            return false;
+        }
+        socklen_t len = sizeof(addr);
+        getsockname(listenFd_, (sockaddr *)&addr, &len);
+        port_ = ntohs(addr.sin_port);
+
+        // Three minutes of synthetic history so the replay frame is full size
+        for (unsigned long ms = 0; ms < 180000; ms += 250) simulate(ms);
+        clockOffsetMs_ = 180000 - nowMs();
+
+        running_ = true;
+        thread_ = std::thread([this] { run(); });
+        return true;
+    }
+
+    void stop() {
+        running_ = false;
+        if (thread_.joinable()) thread_.join();
+        for (auto &c : clients_) close(c.fd);
+        clients_.clear();
+        close(listenFd_);
+    }
+
+    uint16_t port() const { return port_; }
+    double cpuMs() { return thread_.joinable() ? threadCpuMs(thread_.native_handle()) : 0; }
+
+private:
+    struct Client {
+        int fd;
+        bool upgraded;
+        std::string request;
+        FrameReader reader;
+    };
+
+    unsigned long millisNow() { return (unsigned long)(nowMs() + clockOffsetMs_); }
+
+    void simulate(unsigned long ms) {
+        double t = ms / 1000.0;
+        state_.temp = 24 + 3 * sin(t / 60);
+        state_.humidity = 55 + 10 * sin(t / 90);
+        state_.frontDist = fmod(t, 20) < 5 ? 20 + 15 * sin(t) : 999;
+        state_.backDist = 999;
+        state_.speed = fmod(t, 30) < 15 ? 1 : 0;
+        state_.direction = fmod(t * 3, 360);
+        history_.record(ms, state_.temp, state_.humidity, state_.frontDist, state_.backDist,
+                        state_.speed, state_.direction);
+    }
+
+    // Same serialization path as writeState() in Car 1
+    void stateJson(JsonWriter &json, bool snapshot) {
+        json.beginObject();
+        if (snapshot) json.add("type", "snapshot").add("serverTime", millisNow()).add("obstacleCm", CONFIG.obstacleCm, 1);
+        json.add("temp", state_.temp, 1)
+            .add("humidity", state_.humidity, 1)
+            .add("frontDist", state_.frontDist, 1)
+            .add("backDist", state_.backDist, 1)
+            .add("speed", state_.speed)
+            .add("direction", state_.direction, 1)
+            .add("leftIndicator", state_.leftIndicator)
+            .add("rightIndicator", state_.rightIndicator)
+            .add("buzzerOn", state_.buzzerOn)
+            .add("ambientOn", state_.ambientOn)
+            .add("car2Connected", state_.car2Connected)
+            .add("car2Left", state_.car2Left)
+            .add("car2Right", state_.car2Right)
+            .add("collision", state_.collision)
+            .add("collisionSide", state_.collisionBack ? "back" : "front")
+            .add("ttc", state_.ttc, 1)
+            .endObject();
+    }
+
+    // Same rules as applySetCommand() in Car 1
+    bool applySet(const std::string &target, bool value) {
+        if (target == "left_indicator") {
+            state_.leftIndicator = value;
+            if (value) state_.rightIndicator = false;
+        } else if (target == "right_indicator") {
+            state_.rightIndicator = value;
+            if (value) state_.leftIndicator = false;
+        } else if (target == "buzzer") {
+            state_.buzzerOn = value;
+        } else if (target == "ambient") {
+            state_.ambientOn = value;
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    void onConnect(Client &c) {
+        JsonBuffer<384> json;
+        stateJson(json, true);
+        sendFrame(c.fd, OP_TEXT, json.c_str(), json.length(), false);
+
+        std::vector<uint8_t> frame(historyFrameSize(history_.seconds));
+        size_t len = encodeHistoryFrame(history_.seconds, millisNow() / 1000, frame.data(), frame.size());
+        sendFrame(c.fd, OP_BINARY, frame.data(), len, false);
+    }
+
+    void onText(Client &c, const std::string &msg) {
+        if (jsonString(msg, "action") != "set") return;
+        double seq = 0;
+        jsonNumber(msg, "seq", seq);
+        std::string target = jsonString(msg, "target");
+        bool applied = applySet(target, jsonBool(msg, "value"));
+        if (applied) changed();
+
+        JsonBuffer<224> json;
+        json.beginObject().add("type", "ack").add("seq", (unsigned long)seq).add("target", target.c_str());
+        if (!applied) json.add("error", "unknown target");
+        json.add("leftIndicator", state_.leftIndicator)
+            .add("rightIndicator", state_.rightIndicator)
+            .add("buzzerOn", state_.buzzerOn)
+            .add("ambientOn", state_.ambientOn)
+            .endObject();
+        sendFrame(c.fd, OP_TEXT, json.c_str(), json.length(), false);
+    }
+
+    bool handshake(Client &c) {
+        size_t end = c.request.find("\r\n\r\n");
+        if (end == std::string::npos) return true;
+
+        std::string key;
+        size_t at = c.request.find("Sec-WebSocket-Key:");
+        if (at != std::string::npos) {
+            at += 18;
+            while (c.request[at] == ' ') at++;
+            key = c.request.substr(at, c.request.find("\r\n", at) - at);
+        }
+        if (c.request.compare(0, 8, "GET /ws ") != 0 || key.empty()) {
+            const char *notFound = "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n\r\n";
+            sendAll(c.fd, notFound, strlen(notFound));
+            return false;
+        }
+
+        std::string response = "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\n"
+                               "Connection: Upgrade\r\nSec-WebSocket-Accept: " + acceptKey(key) + "\r\n\r\n";
+        if (!sendAll(c.fd, response.data(), response.size())) return false;
+        c.reader.buf = c.request.substr(end + 4);
+        c.request.clear();
+        c.upgraded = true;
+        onConnect(c);
+        return true;
+    }
+
+    // The firmware publishes a field only when its value changes; a changed
+    // frame stands in for that
+    void changed() {
+        JsonBuffer<384> json;
+        stateJson(json, false);
+        if (lastPushed_ != json.c_str()) dirty_ = true;
+    }
+
+    // Like the firmware's dashboard subscriber and keepalive job: a change
+    // goes out at once unless a push went out in the last wsPushMs, then
+    // waits out the rest; with no change, a push after wsKeepaliveMs
+    double nextPushMs() const { return lastPushMs_ + (dirty_ ? CONFIG.wsPushMs : CONFIG.wsKeepaliveMs); }
+
+    void push(double now, std::vector<int> &dead) {
+        JsonBuffer<384> json;
+        stateJson(json, false);
+        lastPushed_ = json.c_str();
+        lastPushMs_ = now;
+        dirty_ = false;
+        for (auto &c : clients_) {
+            if (c.upgraded && !sendFrame(c.fd, OP_TEXT, json.c_str(), json.length(), false)) dead.push_back(c.fd);
+        }
+    }
+
+    void run() {
+        double nextSensor = nowMs();
+        lastPushMs_ = nowMs();
+        while (running_) {
+            std::vector<pollfd> fds;
+            fds.push_back({listenFd_, POLLIN, 0});
+            for (auto &c : clients_) fds.push_back({c.fd, POLLIN, 0});
+
+            double wait = std::min(nextSensor, nextPushMs()) - nowMs();
+            poll(fds.data(), fds.size(), wait > 0 ? (int)wait + 1 : 0);
+
+            if (fds[0].revents & POLLIN) {
+                int fd = accept(listenFd_, NULL, NULL);
+                if (fd >= 0) {
+                    int one = 1;
+                    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+                    clients_.push_back({fd, false, "", FrameReader()});
+                }
+            }
+
+            std::vector<int> dead;
+            for (size_t i = 1; i < fds.size(); i++) {
+                if (!(fds[i].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+                Client &c = clients_[i - 1];
+                if (!c.upgraded) {
+                    char tmp[2048];
+                    ssize_t n = recv(c.fd, tmp, sizeof(tmp), 0);
+                    if (n <= 0) { dead.push_back(c.fd); continue; }
+                    c.request.append(tmp, n);
+                    if (!handshake(c)) dead.push_back(c.fd);
+                    continue;
+                }
+                if (!c.reader.fill(c.fd)) { dead.push_back(c.fd); continue; }
+                uint8_t opcode;
+                std::string payload;
+                while (c.reader.next(opcode, payload)) {
+                    if (opcode == OP_TEXT) onText(c, payload);
+                    else if (opcode == OP_CLOSE) dead.push_back(c.fd);
+                }
+            }
+
+            double now = nowMs();
+            if (now >= nextSensor) {
+                nextSensor += CONFIG.sensorMs;
+                simulate(millisNow());
+                changed();
+            }
+            if (now >= nextPushMs()) push(now, dead);
+
+            for (int fd : dead) {
+                auto it = std::find_if(clients_.begin(), clients_.end(), [fd](const Client &c) { return c.fd == fd; });
+                if (it != clients_.end()) {
+                    close(fd);
+                    clients_.erase(it);
+                }
+            }
+        }
+    }
+
+    int listenFd_ = -1;
+    uint16_t port_ = 0;
+    double clockOffsetMs_ = 0;
+    std::atomic<bool> running_{false};
+    std::thread thread_;
+    std::vector<Client> clients_;
+    StandInState state_;
+    TelemetryHistory history_;
+    std::string lastPushed_;    // The last state frame sent
+    double lastPushMs_ = 0;
+    bool dirty_ = false;        // State changed since then
+};
+
+// =================================================================
+//                      LOAD CLIENTS
+// =================================================================
+struct ClientStats {
+    long frames = 0;
+    long snapshots = 0;
+    long historyFrames = 0;
+    long acks = 0;
+    long commands = 0;
+    std::vector<double> gaps;
+    std::vector<double> ackLatency;
+};
+
+struct LoadClient {
+    int fd = -1;
+    FrameReader reader;
+    double lastFrame = 0;
+    double nextCommand = 0;
+    unsigned long seq = 0;
+    bool value = false;
+    std::map<unsigned long, double> inFlight;
+    ClientStats stats;
+};
+
+static int connectTo(const std::string &host, uint16_t port) {
+    addrinfo hints = {}, *res = NULL;
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &res) != 0) return -1;
+    int fd = socket(res->ai_family, res->ai_socktype, 0);
+    if (connect(fd, res->ai_addr, res->ai_addrlen) != 0) {
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(res);
+    if (fd >= 0) {
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+    return fd;
+}
+
+static bool openClient(LoadClient &c, const std::string &host, uint16_t port) {
+    c.fd = connectTo(host, port);
+    if (c.fd < 0) return false;
+
+    uint8_t nonce[16];
+    for (auto &byte : nonce) byte = rand() & 0xFF;
+    std::string request = "GET /ws HTTP/1.1\r\nHost: " + host + "\r\nUpgrade: websocket\r\n"
+                          "Connection: Upgrade\r\nSec-WebSocket-Key: " + base64(nonce, 16) +
+                          "\r\nSec-WebSocket-Version: 13\r\n\r\n";
+    if (!sendAll(c.fd, request.data(), request.size())) return false;
+
+    std::string response;
+    while (response.find("\r\n\r\n") == std::string::npos) {
+        char tmp[1024];
+        ssize_t n = recv(c.fd, tmp, sizeof(tmp), 0);
+        if (n <= 0) return false;
+        response.append(tmp, n);
+    }
+    if (response.compare(0, 12, "HTTP/1.1 101") != 0) return false;
+    c.reader.buf = response.substr(response.find("\r\n\r\n") + 4);
+    return true;
+}
+
+static void onClientFrame(LoadClient &c, uint8_t opcode, const std::string &payload, double now, bool measuring) {
+    if (opcode == OP_BINARY) {
+        c.stats.historyFrames++;
+        return;
+    }
+    if (opcode != OP_TEXT) return;
+
+    std::string type = jsonString(payload, "type");
+    if (type == "ack") {
+        double seq;
+        if (!jsonNumber(payload, "seq", seq)) return;
+        auto it = c.inFlight.find((unsigned long)seq);
+        if (it == c.inFlight.end()) return;
+        if (measuring) {
+            c.stats.acks++;
+            c.stats.ackLatency.push_back(now - it->second);
+        }
+        c.inFlight.erase(it);
+    } else if (type == "snapshot") {
+        c.stats.snapshots++;
+        c.lastFrame = now;
+    } else {
+        if (measuring) {
+            c.stats.frames++;
+            if (c.lastFrame > 0) c.stats.gaps.push_back(now - c.lastFrame);
+        }
+        c.lastFrame = now;
+    }
+}
+
+static double percentile(std::vector<double> v, double p) {
+    if (v.empty()) return 0;
+    std::sort(v.begin(), v.end());
+    size_t i = std::min(v.size() - 1, (size_t)(p / 100.0 * v.size()));
+    return v[i];
+}
+
+struct RunConfig {
+    std::string host = "127.0.0.1";
+    uint16_t port = 0;
+    bool standIn = true;
+    double durationS = 10;
+    double warmupS = 1;
+    double commandMs = 500;
+    std::string label = "";
+};
+
+static void runLevel(int n, const RunConfig &cfg) {
+    StandInServer server;
+    uint16_t port = cfg.port;
+    if (cfg.standIn) {
+        if (!server.start(0)) exit(1);
+        port = server.port();
+    }
+
+    std::vector<LoadClient> clients(n);
+    int opened = 0;
+    for (auto &c : clients) {
+        if (openClient(c, cfg.host, port)) opened++;
+        else fprintf(stderr, "client failed to connect\n");
+    }
+
+    // Stagger command timers so clients don't all click at once
+    double start = nowMs();
+    for (int i = 0; i < n; i++) clients[i].nextCommand = start + cfg.commandMs * i / n;
+
+    double measureFrom = start + cfg.warmupS * 1000;
+    double end = measureFrom + cfg.durationS * 1000;
+    double cpuFrom = 0;
+    bool measuring = false;
+
+    while (nowMs() < end) {
+        double now = nowMs();
+        if (!measuring && now >= measureFrom) {
+            measuring = true;
+            cpuFrom = cfg.standIn ? server.cpuMs() : 0;
+        }
+
+        std::vector<pollfd> fds;
+        for (auto &c : clients) fds.push_back({c.fd, POLLIN, 0});
+        poll(fds.data(), fds.size(), 5);
+        now = nowMs();
+
+        for (int i = 0; i < n; i++) {
+            LoadClient &c = clients[i];
+            if (c.fd < 0) continue;
+            if (fds[i].revents & (POLLIN | POLLHUP | POLLERR)) {
+                if (!c.reader.fill(c.fd)) {
+                    close(c.fd);
+                    c.fd = -1;
+                    continue;
+                }
+                uint8_t opcode;
+                std::string payload;
+                while (c.reader.next(opcode, payload)) onClientFrame(c, opcode, payload, now, measuring);
+            }
+
+            if (now >= c.nextCommand) {
+                c.nextCommand += cfg.commandMs;
+                c.value = !c.value;
+                char msg[128];
+                int len = snprintf(msg, sizeof(msg),
+                    "{\"action\":\"set\",\"target\":\"%s\",\"value\":%s,\"seq\":%lu}",
+                    i % 2 ? "right_indicator" : "left_indicator", c.value ? "true" : "false", ++c.seq);
+                c.inFlight[c.seq] = now;
+                if (measuring) c.stats.commands++;
+                sendFrame(c.fd, OP_TEXT, msg, len, true);
+            }
+        }
+    }
+
+    double cpuMs = cfg.standIn ? server.cpuMs() - cpuFrom : 0;
+
+    ClientStats total;
+    long minFrames = -1;
+    for (auto &c : clients) {
+        total.frames += c.stats.frames;
+        total.snapshots += c.stats.snapshots;
+        total.historyFrames += c.stats.historyFrames;
+        total.acks += c.stats.acks;
+        total.commands += c.stats.commands;
+        total.gaps.insert(total.gaps.end(), c.stats.gaps.begin(), c.stats.gaps.end());
+        total.ackLatency.insert(total.ackLatency.end(), c.stats.ackLatency.begin(), c.stats.ackLatency.end());
+        if (minFrames < 0 || c.stats.frames < minFrames) minFrames = c.stats.frames;
+        if (c.fd >= 0) {
+            sendFrame(c.fd, OP_CLOSE, "", 0, true);
+            close(c.fd);
+        }
+    }
+    if (cfg.standIn) server.stop();
+
+    double rate = total.frames / cfg.durationS / std::max(opened, 1);
+    double cpuPct = cpuMs / (cfg.durationS * 1000) * 100;
+
+    printf("{\"label\":\"%s\",\"target\":\"%s\",\"clients\":%d,\"connected\":%d,\"duration_s\":%.1f,"
+           "\"frames_per_client_hz\":%.2f,\"min_client_frames_hz\":%.2f,"
+           "\"frame_gap_ms\":{\"p50\":%.2f,\"p99\":%.2f,\"max\":%.2f},"
+           "\"ack_latency_ms\":{\"p50\":%.2f,\"p90\":%.2f,\"p99\":%.2f,\"max\":%.2f},"
+           "\"commands\":%ld,\"acks\":%ld,\"snapshots\":%ld,\"history_frames\":%ld,",
+           cfg.label.c_str(), cfg.standIn ? "stand-in" : cfg.host.c_str(), n, opened, cfg.durationS,
+           rate, std::max(minFrames, 0L) / cfg.durationS,
+           percentile(total.gaps, 50), percentile(total.gaps, 99), percentile(total.gaps, 100),
+           percentile(total.ackLatency, 50), percentile(total.ackLatency, 90),
+           percentile(total.ackLatency, 99), percentile(total.ackLatency, 100),
+           total.commands, total.acks, total.snapshots, total.historyFrames);
+    if (cfg.standIn) {
+        printf("\"server_cpu_pct\":%.3f,\"server_cpu_pct_per_client\":%.4f}\n", cpuPct, cpuPct / n);
+    } else {
+        printf("\"server_cpu_pct\":null,\"server_cpu_pct_per_client\":null}\n");
+    }
+    fflush(stdout);
+
+    fprintf(stderr, "N=%2d  %6.2f frames/s/client  gap p99 %6.1f ms  ack p50 %6.2f p99 %6.2f ms",
+            n, rate, percentile(total.gaps, 99), percentile(total.ackLatency, 50),
+            percentile(total.ackLatency, 99));
+    if (cfg.standIn) fprintf(stderr, "  cpu %.2f%%", cpuPct);
+    fprintf(stderr, "\n");
+}
+
+// =================================================================
+//                      MAIN
+// =================================================================
+static void usage() {
+    fprintf(stderr,
+        "usage: ws_loadgen [--target host:port] [--sweep 1,2,4,8,16,32] [--clients N]\n"
+        "                  [--duration s] [--warmup s] [--command-ms ms] [--label name]\n"
+        "       ws_loadgen --serve port\n");
+}
+
+int main(int argc, char **argv) {
+    signal(SIGPIPE, SIG_IGN);
+    srand(time(NULL));
+
+    RunConfig cfg;
+    std::vector<int> levels = {1, 2, 4, 8, 16, 32};
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (arg == "--serve" && value) {
+            StandInServer server;
+            if (!server.start(atoi(value))) return 1;
+            fprintf(stderr, "stand-in serving ws://127.0.0.1:%u/ws\n", server.port());
+            while (true) pause();
+        } else if (arg == "--target" && value) {
+            std::string target = value;
+            size_t colon = target.find(':');
+            cfg.host = target.substr(0, colon);
+            cfg.port = colon == std::string::npos ? 80 : atoi(target.c_str() + colon + 1);
+            cfg.standIn = false;
+            i++;
+        } else if (arg == "--sweep" && value) {
+            levels.clear();
+            for (const char *p = value; *p; ) {
+                levels.push_back(atoi(p));
+                p = strchr(p, ',');
+                if (!p) break;
+                p++;
+            }
+            i++;
+        } else if (arg == "--clients" && value) {
+            levels = {atoi(value)};
+            i++;
+        } else if (arg == "--duration" && value) {
+            cfg.durationS = atof(value);
+            i++;
+        } else if (arg == "--warmup" && value) {
+            cfg.warmupS = atof(value);
+            i++;
+        } else if (arg == "--command-ms" && value) {
+            cfg.commandMs = atof(value);
+            i++;
+        } else if (arg == "--label" && value) {
+            cfg.label = value;
+            i++;
+        } else {
+            usage();
+            return 1;
+        }
+    }
+
+    for (int n : levels) {
+        if (n > 0) runLevel(n, cfg);
+    }
+    return 0;
+}
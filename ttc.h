@@ -0,0 +1,186 @@
+/*
+ * Smart Car Dashboard - Collision Prediction
+ * Author: Stromlabs - Pavan Kalsariya
+ * Date: July 2025
+ * Description: Time to collision from the ultrasonic ranges, so the warning
+ * comes earlier the faster an obstacle closes in and not at all while
+ * creeping. Each side keeps a range and closing rate, updated per echo by an
+ * alpha-beta filter in integer math: a fixed handful of operations per
+ * sample and no history to walk. Where there is an IMU, the car's own
+ * forward acceleration feeds the filter's prediction, so the rate follows
+ * braking and pulling away before the echoes show it. The time to collision
+ * (range over closing rate) is graded into caution, warning and critical,
+ * with hysteresis so a level doesn't flicker at its threshold.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include "jsonwriter.h"
+
+// --- TRACKING ---
+#define TTC_MAX_RANGE_MM 3000       // Farther echoes aren't tracked; the HC-SR04 gets unreliable
+#define TTC_GATE_MM 300             // A jump past the prediction this big is another object: start over
+#define TTC_MAX_GAP_MS 1000         // Samples further apart start over (e.g. idle sensor rate)
+#define TTC_MAX_MISSES 2            // Echoes in a row that may be lost before the track is dropped
+#define TTC_MIN_SAMPLES 3           // Before the rate is trusted
+#define TTC_MIN_RATE_MMS 100        // Closing slower than this is creeping: no prediction
+#define TTC_MAX_RATE_MMS 10000
+#define TTC_ALPHA_16 8              // Filter gains in 1/16: 0.5 on range...
+#define TTC_BETA_16 3               // ...and about 0.19 on rate
+#define TTC_ACCEL_DEADBAND 300      // mm/s^2 of IMU vibration ignored
+#define TTC_ACCEL_MAX 4000          // mm/s^2
+#define TTC_NONE 0xFFFF             // Not closing, or not tracked yet
+
+enum CollisionLevel : uint8_t {
+    COLLISION_NONE,
+    COLLISION_CAUTION,
+    COLLISION_WARNING,
+    COLLISION_CRITICAL,
+    COLLISION_LEVELS
+};
+
+static const char *const COLLISION_LEVEL_NAMES[COLLISION_LEVELS] = {"none", "caution", "warning", "critical"};
+
+// One sensor's nearest echo. Range is kept in 1/16 mm so the half-gain
+// corrections don't round away; rate is positive while closing.
+class RangeTracker {
+public:
+    // mm as converted from the echo; anything past TTC_MAX_RANGE_MM, no echo
+    // included, counts as a lost echo. closingAccel: the car's acceleration
+    // toward this sensor's side in mm/s^2, 0 without an IMU.
+    void update(uint32_t nowMs, uint16_t mm, int32_t closingAccel) {
+        uint32_t dt = nowMs - lastMs_;
+        if (mm > TTC_MAX_RANGE_MM) {
+            // A lost echo or two coasts on the last rate; more drop the track
+            if (samples_ >= 2 && misses_ < TTC_MAX_MISSES && dt <= TTC_MAX_GAP_MS) {
+                rangeQ_ -= rateMms_ * (int32_t)dt * 16 / 1000;
+                lastMs_ = nowMs;
+                misses_++;
+            } else {
+                samples_ = 0;
+            }
+            return;
+        }
+        lastMs_ = nowMs;
+        misses_ = 0;
+        if (samples_ == 0 || dt == 0 || dt > TTC_MAX_GAP_MS) {
+            restart(mm);
+            return;
+        }
+        if (samples_ == 1) {
+            // Nothing to predict from yet: the first rate is the difference
+            int32_t rate = (rangeQ_ - ((int32_t)mm << 4)) * 1000 / 16 / (int32_t)dt;
+            if (rate > TTC_MAX_RATE_MMS || rate < -TTC_MAX_RATE_MMS) {
+                restart(mm);
+                return;
+            }
+            rangeQ_ = (int32_t)mm << 4;
+            rateMms_ = rate;
+            samples_ = 2;
+            return;
+        }
+
+        int32_t rate = rateMms_ + closingAccel * (int32_t)dt / 1000;
+        int32_t predicted = rangeQ_ - rate * (int32_t)dt * 16 / 1000;
+        int32_t residual = ((int32_t)mm << 4) - predicted;
+        if (residual > (TTC_GATE_MM << 4) || residual < -(TTC_GATE_MM << 4)) {
+            restart(mm);
+            return;
+        }
+
+        // Farther than predicted: closing slower than thought
+        rangeQ_ = predicted + residual * TTC_ALPHA_16 / 16;
+        rate -= residual * TTC_BETA_16 * 1000 / (16 * 16 * (int32_t)dt);
+        rateMms_ = rate > TTC_MAX_RATE_MMS ? TTC_MAX_RATE_MMS : (rate < -TTC_MAX_RATE_MMS ? -TTC_MAX_RATE_MMS : rate);
+        if (samples_ < 255) samples_++;
+    }
+
+    // Time to reach the obstacle at the current closing rate
+    uint16_t ttcMs() const {
+        if (samples_ < TTC_MIN_SAMPLES || rateMms_ < TTC_MIN_RATE_MMS) return TTC_NONE;
+        uint32_t rangeMm = rangeQ_ > 0 ? rangeQ_ >> 4 : 0;
+        uint32_t ms = rangeMm * 1000 / (uint32_t)rateMms_;
+        return ms < TTC_NONE ? ms : TTC_NONE - 1;
+    }
+
+    int32_t rateMms() const { return samples_ ? rateMms_ : 0; }
+
+private:
+    void restart(uint16_t mm) {
+        rangeQ_ = (int32_t)mm << 4;
+        rateMms_ = 0;
+        samples_ = 1;
+    }
+
+    int32_t rangeQ_ = 0;
+    int32_t rateMms_ = 0;
+    uint32_t lastMs_ = 0;
+    uint8_t samples_ = 0;       // 0: no track
+    uint8_t misses_ = 0;
+};
+
+// --- PREDICTOR ---
+// Both sensors, graded into one warning for the side that's closer in time
+class CollisionPredictor {
+public:
+    CollisionPredictor(uint16_t cautionMs, uint16_t warningMs, uint16_t criticalMs)
+        : thresholdMs_{TTC_NONE, cautionMs, warningMs, criticalMs} {}
+
+    // Forward acceleration from the IMU (its x axis), in mm/s^2. Tilt and
+    // sensor offset are taken out by a slow average (about 64 samples);
+    // what's left inside the dead band is vibration.
+    void motion(int32_t accelMms2) {
+        biasMms2_ += (accelMms2 - biasMms2_) / 64;
+        int32_t a = accelMms2 - biasMms2_;
+        if (a > -TTC_ACCEL_DEADBAND && a < TTC_ACCEL_DEADBAND) a = 0;
+        accelMms2_ = a > TTC_ACCEL_MAX ? TTC_ACCEL_MAX : (a < -TTC_ACCEL_MAX ? -TTC_ACCEL_MAX : a);
+    }
+
+    // Once per sensor read, with both ranges as converted from the echoes
+    void update(uint32_t nowMs, uint16_t frontMm, uint16_t backMm) {
+        front_.update(nowMs, frontMm, accelMms2_);
+        back_.update(nowMs, backMm, -accelMms2_);
+        uint16_t front = front_.ttcMs(), back = back_.ttcMs();
+        back_closer_ = back < front;
+        ttcMs_ = back_closer_ ? back : front;
+
+        uint8_t level = COLLISION_NONE;
+        while (level < COLLISION_CRITICAL && ttcMs_ < thresholdMs_[level + 1]) level++;
+        // A level holds until the time is a quarter past its threshold
+        if (level < level_ && ttcMs_ != TTC_NONE && (uint32_t)ttcMs_ * 4 <= (uint32_t)thresholdMs_[level_] * 5) {
+            level = level_;
+        }
+        if (level > level_) raised_[level]++;
+        level_ = level;
+    }
+
+    CollisionLevel level() const { return (CollisionLevel)level_; }
+    bool back() const { return back_closer_; }
+    uint16_t ttcMs() const { return ttcMs_; }
+
+    // "collision":{"level":..,"side":..,"ttcMs":..,"frontRateMms":..,"backRateMms":..,"accelMms2":..,
+    //  "raised":{"caution":..,"warning":..,"critical":..}}
+    void write(JsonWriter &json, const char *key = "collision") const {
+        json.beginObject(key)
+            .add("level", COLLISION_LEVEL_NAMES[level_])
+            .add("side", back_closer_ ? "back" : "front")
+            .add("ttcMs", ttcMs_ == TTC_NONE ? -1 : (int)ttcMs_)
+            .add("frontRateMms", (long)front_.rateMms())
+            .add("backRateMms", (long)back_.rateMms())
+            .add("accelMms2", (long)accelMms2_)
+            .beginObject("raised");
+        for (uint8_t l = COLLISION_CAUTION; l < COLLISION_LEVELS; l++) json.add(COLLISION_LEVEL_NAMES[l], raised_[l]);
+        json.endObject().endObject();
+    }
+
+private:
+    RangeTracker front_, back_;
+    const uint16_t thresholdMs_[COLLISION_LEVELS];  // Below [level]: at least that level
+    int32_t biasMms2_ = 0;
+    int32_t accelMms2_ = 0;
+    uint16_t ttcMs_ = TTC_NONE;
+    uint8_t level_ = COLLISION_NONE;
+    bool back_closer_ = false;
+    uint32_t raised_[COLLISION_LEVELS] = {};    // Times each level was entered from below
+};
@@ -0,0 +1,302 @@
+/*
+ * Smart Car Dashboard - Update Body
+ * Author: Stromlabs - Pavan Kalsariya
+ * Date: July 2025
+ * Description: Receives /update request bodies that may arrive split across
+ * several TCP segments. Chunks are collected into one of a few fixed buffers,
+ * keyed by request, and only parsed once the last byte is in. The body is a
+ * flat JSON object of booleans, parsed in place without a document or heap.
+ * Bodies that are too large, arrive out of order, or don't parse are
+ * rejected and counted. Everything runs on the async_tcp task, so nothing is
+ * locked; only the counters are read from elsewhere.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include "jsonwriter.h"
+
+// --- FIELDS ---
+enum UpdateField : uint8_t {
+    UPDATE_LEFT,
+    UPDATE_RIGHT,
+    UPDATE_BUZZER,
+    UPDATE_AMBIENT,
+    UPDATE_FIELDS
+};
+
+static const char *const UPDATE_FIELD_KEYS[UPDATE_FIELDS] = {
+    "leftIndicator", "rightIndicator", "buzzerOn", "ambientOn"
+};
+
+// Which fields the body set, and to what
+struct UpdateBody {
+    uint8_t present = 0;
+    uint8_t values = 0;
+
+    bool has(UpdateField f) const { return present & (1 << f); }
+    bool get(UpdateField f) const { return values & (1 << f); }
+
+    void set(UpdateField f, bool value) {
+        present |= 1 << f;
+        if (value) values |= 1 << f;
+        else values &= ~(1 << f);
+    }
+};
+
+// --- PARSER ---
+// Accepts {"leftIndicator":true,"buzzerOn":false,...}. Known keys must hold
+// true or false; unknown keys are skipped if their value is a string, number,
+// bool or null. Nested values, missing commas or trailing bytes fail the
+// whole body, so nothing is applied from a half-valid update.
+class UpdateBodyParser {
+public:
+    static bool parse(const char *text, size_t len, UpdateBody &out) {
+        UpdateBodyParser p(text, len);
+        return p.object(out);
+    }
+
+private:
+    UpdateBodyParser(const char *text, size_t len) : p_(text), end_(text + len) {}
+
+    bool object(UpdateBody &out) {
+        skipSpace();
+        if (!take('{')) return false;
+        skipSpace();
+        if (take('}')) return atEnd();
+
+        for (;;) {
+            const char *key;
+            size_t keyLen;
+            skipSpace();
+            if (!string(&key, &keyLen)) return false;
+            skipSpace();
+            if (!take(':')) return false;
+            skipSpace();
+
+            int field = lookup(key, keyLen);
+            if (field >= 0) {
+                bool value;
+                if (!boolean(&value)) return false;
+                out.set((UpdateField)field, value);
+            } else if (!skipScalar()) {
+                return false;
+            }
+
+            skipSpace();
+            if (take('}')) return atEnd();
+            if (!take(',')) return false;
+        }
+    }
+
+    static int lookup(const char *key, size_t len) {
+        for (uint8_t f = 0; f < UPDATE_FIELDS; f++) {
+            if (strlen(UPDATE_FIELD_KEYS[f]) == len && memcmp(UPDATE_FIELD_KEYS[f], key, len) == 0) return f;
+        }
+        return -1;
+    }
+
+    // Points at the raw bytes between the quotes; escapes are skipped, not decoded
+    bool string(const char **start, size_t *len) {
+        if (!take('"')) return false;
+        *start = p_;
+        while (p_ < end_ && *p_ != '"') {
+            if (*p_ == '\\' && ++p_ == end_) return false;
+            if ((uint8_t)*p_ < 0x20) return false;
+            p_++;
+        }
+        if (p_ == end_) return false;
+        *len = p_ - *start;
+        p_++;
+        return true;
+    }
+
+    bool boolean(bool *value) {
+        if (literal("true")) *value = true;
+        else if (literal("false")) *value = false;
+        else return false;
+        return true;
+    }
+
+    bool skipScalar() {
+        if (p_ < end_ && *p_ == '"') {
+            const char *s;
+            size_t n;
+            return string(&s, &n);
+        }
+        if (literal("true") || literal("false") || literal("null")) return true;
+
+        const char *start = p_;
+        if (p_ < end_ && *p_ == '-') p_++;
+        while (p_ < end_ && (isdigit((uint8_t)*p_) || *p_ == '.' || *p_ == 'e' || *p_ == 'E' || *p_ == '+' || *p_ == '-')) p_++;
+        return p_ > start && isdigit((uint8_t)p_[-1]);
+    }
+
+    bool literal(const char *word) {
+        size_t n = strlen(word);
+        if ((size_t)(end_ - p_) < n || memcmp(p_, word, n) != 0) return false;
+        p_ += n;
+        return true;
+    }
+
+    bool take(char c) {
+        if (p_ < end_ && *p_ == c) {
+            p_++;
+            return true;
+        }
+        return false;
+    }
+
+    void skipSpace() {
+        while (p_ < end_ && (*p_ == ' ' || *p_ == '\t' || *p_ == '\r' || *p_ == '\n')) p_++;
+    }
+
+    bool atEnd() {
+        skipSpace();
+        return p_ == end_;
+    }
+
+    const char *p_;
+    const char *end_;
+};
+
+// --- BODY POOL ---
+enum BodyStatus : uint8_t {
+    BODY_RECEIVING,
+    BODY_COMPLETE,      // Whole body in, not parsed yet
+    BODY_OK,
+    BODY_TOO_LARGE,
+    BODY_BAD_CHUNK,     // Gap or overlap between chunks
+    BODY_INVALID        // Didn't parse
+};
+
+struct BodyStats {
+    uint32_t ok = 0;
+    uint32_t tooLarge = 0;
+    uint32_t badChunk = 0;
+    uint32_t invalid = 0;
+    uint32_t busy = 0;          // All slots taken
+    uint32_t abandoned = 0;     // Client went away mid-body
+};
+
+// A slot belongs to one request from its first chunk until release(). A
+// slot whose client vanished without a disconnect event is taken back after
+// BODY_TIMEOUT_MS.
+#define BODY_TIMEOUT_MS 5000
+
+template <uint8_t Slots, size_t Size>
+class BodyPool {
+public:
+    struct Slot {
+        const void *owner;
+        uint32_t startedMs;
+        size_t total;
+        size_t received;
+        BodyStatus status;
+        char data[Size];
+    };
+
+    // Feed one chunk as ESPAsyncWebServer's body callback gets it. Returns
+    // the slot once the last byte is in (status BODY_COMPLETE) or the body
+    // has been rejected; NULL while more chunks are expected or when no slot
+    // is free.
+    Slot *receive(const void *owner, const uint8_t *data, size_t len, size_t index, size_t total, uint32_t nowMs) {
+        Slot *slot = index == 0 ? claim(owner, total, nowMs) : find(owner);
+        if (!slot || slot->status != BODY_RECEIVING) return slot;
+
+        if (index != slot->received || total != slot->total || len > total - index) {
+            return reject(slot, BODY_BAD_CHUNK);
+        }
+        memcpy(slot->data + index, data, len);
+        slot->received += len;
+        if (slot->received < slot->total) return NULL;
+
+        slot->status = BODY_COMPLETE;
+        return slot;
+    }
+
+    // Parse a complete body; counts the outcome and leaves it in slot->status
+    bool parse(Slot *slot, UpdateBody &out) {
+        if (slot->status != BODY_COMPLETE) return false;
+        if (!UpdateBodyParser::parse(slot->data, slot->received, out)) {
+            reject(slot, BODY_INVALID);
+            return false;
+        }
+        slot->status = BODY_OK;
+        stats_.ok++;
+        return true;
+    }
+
+    Slot *find(const void *owner) {
+        for (uint8_t i = 0; i < Slots; i++) {
+            if (slots_[i].owner == owner) return &slots_[i];
+        }
+        return NULL;
+    }
+
+    void release(const void *owner) {
+        Slot *slot = find(owner);
+        if (!slot) return;
+        if (slot->status == BODY_RECEIVING) stats_.abandoned++;
+        slot->owner = NULL;
+    }
+
+    uint8_t inUse() const {
+        uint8_t n = 0;
+        for (uint8_t i = 0; i < Slots; i++) {
+            if (slots_[i].owner) n++;
+        }
+        return n;
+    }
+
+    const BodyStats &stats() const { return stats_; }
+
+    // "update":{"ok":..,"tooLarge":..,"badChunk":..,"invalid":..,"busy":..,"abandoned":..}
+    void write(JsonWriter &json, const char *key = "update") const {
+        json.beginObject(key)
+            .add("ok", stats_.ok)
+            .add("tooLarge", stats_.tooLarge)
+            .add("badChunk", stats_.badChunk)
+            .add("invalid", stats_.invalid)
+            .add("busy", stats_.busy)
+            .add("abandoned", stats_.abandoned)
+            .endObject();
+    }
+
+private:
+    Slot *claim(const void *owner, size_t total, uint32_t nowMs) {
+        // A request object can be reused at the same address; start it over
+        Slot *slot = find(owner);
+        for (uint8_t i = 0; !slot && i < Slots; i++) {
+            Slot &s = slots_[i];
+            if (!s.owner) slot = &s;
+            else if (nowMs - s.startedMs > BODY_TIMEOUT_MS) {
+                if (s.status == BODY_RECEIVING) stats_.abandoned++;
+                slot = &s;
+            }
+        }
+        if (!slot) {
+            stats_.busy++;
+            return NULL;
+        }
+
+        slot->owner = owner;
+        slot->startedMs = nowMs;
+        slot->total = total;
+        slot->received = 0;
+        slot->status = BODY_RECEIVING;
+        if (total == 0 || total > Size) return reject(slot, total ? BODY_TOO_LARGE : BODY_INVALID);
+        return slot;
+    }
+
+    Slot *reject(Slot *slot, BodyStatus status) {
+        slot->status = status;
+        if (status == BODY_TOO_LARGE) stats_.tooLarge++;
+        else if (status == BODY_BAD_CHUNK) stats_.badChunk++;
+        else stats_.invalid++;
+        return slot;
+    }
+
+    Slot slots_[Slots] = {};
+    BodyStats stats_;
+};
@@ -1,8 +1,8 @@
 #ifndef WEB_H
 #define WEB_H
 
-String getWebPage() {
-  return R"rawliteral(
+// Served straight from flash; building it as a String copied ~15 KB to the heap per load
+const char WEB_PAGE[] PROGMEM = R"rawliteral(
 <!DOCTYPE html>
 <html lang="en">
 <head>
@@ -231,6 +231,14 @@ String getWebPage() {
             gap: 12px;
         }
         
+        .latency {
+            margin-top: 8px;
+            min-height: 14px;
+            font-size: 11px;
+            text-align: center;
+            opacity: 0.6;
+        }
+        
         .control-btn {
             flex: 1;
             padding: 18px;
@@ -336,81 +344,90 @@ String getWebPage() {
                 <button class="control-btn left" id="leftBtn" onclick="toggleLeft()">← LEFT</button>
                 <button class="control-btn right" id="rightBtn" onclick="toggleRight()">RIGHT →</button>
             </div>
+            <div class="latency" id="latency"></div>
         </div>
     </div>
     
     <script>
-        let isUpdating = false;
+        // Indicator commands send the wanted state plus a sequence number;
+        // the response echoes both, which gives click-to-confirmed latency
+        let commandSeq = 0;
+        let indicators = { leftIndicator: false, rightIndicator: false };
+        
+        function setIndicator(side, on) {
+            const seq = ++commandSeq;
+            const sentAt = performance.now();
+            fetch(`/api/indicator/${side}?state=${on ? 'on' : 'off'}&seq=${seq}`, { method: 'POST' })
+                .then(response => response.json())
+                .then(ack => {
+                    if (ack.seq !== seq) return;
+                    document.getElementById('latency').textContent =
+                        `Confirmed in ${Math.round(performance.now() - sentAt)} ms`;
+                    updateIndicators(ack);
+                })
+                .catch(err => console.error(`${side} indicator error:`, err));
+        }
         
         function toggleLeft() {
-            if (isUpdating) return;
-            fetch('/api/indicator/left', { method: 'POST' })
-                .catch(err => console.error('Left toggle error:', err));
+            setIndicator('left', !indicators.leftIndicator);
         }
         
         function toggleRight() {
-            if (isUpdating) return;
-            fetch('/api/indicator/right', { method: 'POST' })
-                .catch(err => console.error('Right toggle error:', err));
+            setIndicator('right', !indicators.rightIndicator);
         }
         
-        function updateDashboard() {
-            if (isUpdating) return;
-            isUpdating = true;
+        function updateIndicators(data) {
+            indicators = { leftIndicator: data.leftIndicator, rightIndicator: data.rightIndicator };
             
-            fetch('/api/status')
-                .then(response => response.json())
-                .then(data => {
-                    // Update status displays
-                    document.getElementById('temperature').textContent = data.temperature.toFixed(1) + '°C';
-                    document.getElementById('humidity').textContent = data.humidity.toFixed(1) + '%';
-                    document.getElementById('speedDisplay').textContent = data.speed.toFixed(1) + ' km/h';
-                    
-                    // Update proximity with distance
-                    let proximityText = data.obstacleLocation;
-                    if (data.obstacleAlert && data.minDistance > 0) {
-                        proximityText += ` (${data.minDistance}cm)`;
-                    }
-                    document.getElementById('proximity').textContent = proximityText;
-                    
-                    // Update compass
-                    document.getElementById('compassArrow').style.transform = `rotate(${data.direction}deg)`;
-                    
-                    // Update car indicators
-                    const car = document.getElementById('car');
-                    car.className = 'car';
-                    if (data.leftIndicator) car.classList.add('left-indicator');
-                    if (data.rightIndicator) car.classList.add('right-indicator');
-                    
-                    // Update buttons
-                    document.getElementById('leftBtn').classList.toggle('active', data.leftIndicator);
-                    document.getElementById('rightBtn').classList.toggle('active', data.rightIndicator);
-                    
-                    // Update alert
-                    const alertBox = document.getElementById('alertBox');
-                    const alertText = document.getElementById('alertText');
-                    if (data.obstacleAlert) {
-                        alertText.textContent = `Obstacle: ${data.obstacleLocation}${data.minDistance > 0 ? ' (' + data.minDistance + 'cm)' : ''}`;
-                        alertBox.classList.add('show');
-                    } else {
-                        alertBox.classList.remove('show');
-                    }
-                    
-                    isUpdating = false;
-                })
-                .catch(error => {
-                    console.error('Update error:', error);
-                    isUpdating = false;
-                });
+            // Update car indicators
+            const car = document.getElementById('car');
+            car.className = 'car';
+            if (data.leftIndicator) car.classList.add('left-indicator');
+            if (data.rightIndicator) car.classList.add('right-indicator');
+            
+            // Update buttons
+            document.getElementById('leftBtn').classList.toggle('active', data.leftIndicator);
+            document.getElementById('rightBtn').classList.toggle('active', data.rightIndicator);
+        }
+        
+        function updateDashboard(data) {
+            // Update status displays
+            document.getElementById('temperature').textContent = data.temperature.toFixed(1) + '°C';
+            document.getElementById('humidity').textContent = data.humidity.toFixed(1) + '%';
+            document.getElementById('speedDisplay').textContent = data.speed.toFixed(1) + ' km/h';
+            
+            // Update proximity with distance
+            let proximityText = data.obstacleLocation;
+            if (data.obstacleAlert && data.minDistance > 0) {
+                proximityText += ` (${data.minDistance}cm)`;
+            }
+            document.getElementById('proximity').textContent = proximityText;
+            
+            // Update compass
+            document.getElementById('compassArrow').style.transform = `rotate(${data.direction}deg)`;
+            
+            updateIndicators(data);
+            
+            // Update alert
+            const alertBox = document.getElementById('alertBox');
+            const alertText = document.getElementById('alertText');
+            if (data.obstacleAlert) {
+                alertText.textContent = `Obstacle: ${data.obstacleLocation}${data.minDistance > 0 ? ' (' + data.minDistance + 'cm)' : ''}`;
+                alertBox.classList.add('show');
+            } else {
+                alertBox.classList.remove('show');
+            }
         }
         
-        // Update every 200ms
-        setInterval(updateDashboard, 200);
-        updateDashboard();
+        // State is pushed over one Server-Sent Events connection: the full
+        // state on connect, then only when something changes. EventSource
+        // reconnects on its own after a drop.
+        const events = new EventSource('/api/events');
+        events.addEventListener('state', e => updateDashboard(JSON.parse(e.data)));
+        events.onerror = () => console.error('Event stream interrupted, reconnecting');
     </script>
 </body>
 </html>
 )rawliteral";
-}
 
 #endif